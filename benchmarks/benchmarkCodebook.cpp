@@ -0,0 +1,111 @@
+#include "OggStream.h"
+#include "VorbisSetup.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+using namespace vcpp;
+
+static const std::string benchmarkDataDir{ VCPP_BENCHMARK_DATA_DIR };
+
+static const VorbisSetup& getSetup() {
+    static const VorbisSetup setup{ []() {
+        OggPhysicalStreamIn in{ benchmarkDataDir + "/stereo.ogg" };
+        std::vector<std::vector<uint8_t>> packets;
+        while (packets.size() < 3) {
+            const std::optional<OggPacket> packet{ in.nextPacket() };
+            packets.emplace_back(packet->data, packet->data + packet->size);
+        }
+        const VorbisIdentification identification{ VorbisIdentification::parse(packets[0].data(), packets[0].size()) };
+        return VorbisSetup::parse(packets[2].data(), packets[2].size(), identification);
+    }() };
+    return setup;
+}
+
+/**
+* Decodes entries by walking the codeword tree one bit at a time, for comparison.
+*/
+class TreeDecoder {
+    // Children of each node. Leaves are stored as -(entry + 1), missing children as 0.
+    std::vector<std::array<int32_t, 2>> nodes_;
+
+public:
+    explicit TreeDecoder(const VorbisCodebook& codebook) : nodes_(1, { 0, 0 }) {
+        for (uint32_t entry{ 0 }; entry < codebook.numEntries; entry++) {
+            std::size_t node{ 0 };
+            for (unsigned int bit{ 0 }; bit < codebook.lengths[entry]; bit++) {
+                int32_t& child{ nodes_[node][(codebook.codewords[entry] >> bit) & 1] };
+                if (bit + 1 == codebook.lengths[entry]) {
+                    child = -int32_t(entry) - 1;
+                }
+                else {
+                    if (child == 0) {
+                        child = int32_t(nodes_.size());
+                        nodes_.push_back({ 0, 0 });
+                    }
+                    node = std::size_t(nodes_[node][(codebook.codewords[entry] >> bit) & 1]);
+                }
+            }
+        }
+    }
+
+    int32_t decodeEntry(BitReader& reader) const {
+        int32_t node{ 0 };
+        do {
+            node = nodes_[node][reader.read(1)];
+        } while (node > 0);
+        return node == 0 || reader.isEndOfPacket() ? -1 : -node - 1;
+    }
+};
+
+// Random bits, which decode to entries with the probabilities that their codeword lengths imply.
+static std::vector<uint8_t> makeRandomPacket() {
+    std::vector<uint8_t> data(0x10000);
+    std::mt19937 random{ 0 };
+    for (uint8_t& value : data) {
+        value = uint8_t(random());
+    }
+    return data;
+}
+
+// Returns the codebook with the longest codewords.
+static const VorbisCodebook& getLongestCodebook() {
+    const VorbisSetup& setup{ getSetup() };
+    const VorbisCodebook* longest{ &setup.codebooks[0] };
+    for (const VorbisCodebook& codebook : setup.codebooks) {
+        if (*std::max_element(codebook.lengths.begin(), codebook.lengths.end())
+            > *std::max_element(longest->lengths.begin(), longest->lengths.end())) {
+            longest = &codebook;
+        }
+    }
+    return *longest;
+}
+
+template<typename Decoder>
+static void decodeAll(benchmark::State& state, const Decoder& decoder) {
+    const std::vector<uint8_t> data{ makeRandomPacket() };
+    for (auto _ : state) {
+        BitReader reader{ data.data(), data.size() };
+        int64_t sum{ 0 };
+        int32_t entry;
+        while ((entry = decoder.decodeEntry(reader)) >= 0) {
+            sum += entry;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+
+static void BM_CodebookTable(benchmark::State& state) {
+    decodeAll(state, getLongestCodebook());
+}
+BENCHMARK(BM_CodebookTable);
+
+static void BM_CodebookTreeWalk(benchmark::State& state) {
+    decodeAll(state, TreeDecoder{ getLongestCodebook() });
+}
+BENCHMARK(BM_CodebookTreeWalk);
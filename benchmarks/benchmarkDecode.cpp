@@ -0,0 +1,56 @@
+#include "OggStream.h"
+#include "VorbisStream.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+using namespace vcpp;
+
+static const std::string benchmarkDataDir{ VCPP_BENCHMARK_DATA_DIR };
+
+static const std::vector<std::vector<uint8_t>>& getPackets() {
+    static const std::vector<std::vector<uint8_t>> packets{ []() {
+        OggPhysicalStreamIn in{ benchmarkDataDir + "/stereo.ogg" };
+        std::vector<std::vector<uint8_t>> packets;
+        while (const std::optional<OggPacket> packet{ in.nextPacket() }) {
+            packets.emplace_back(packet->data, packet->data + packet->size);
+        }
+        return packets;
+    }() };
+    return packets;
+}
+
+// Reads the frames of every packet as 16-bit samples, like a transcoder would.
+class PcmSink : public VorbisStream::PcmCallback {
+    std::vector<int16_t> samples_;
+
+public:
+    std::size_t numFrames{ 0 };
+
+    void onPcmAvailable(VorbisStream& stream, const std::size_t numFramesAvailable) override {
+        samples_.resize(numFramesAvailable * stream.getIdentification().numChannels);
+        numFrames += stream.readInterleaved(samples_.data(), numFramesAvailable);
+    }
+};
+
+// Decodes the whole stream with the given number of workers. The stream is short, so
+// it is decoded several times per iteration to keep the workers busy.
+static void BM_DecodeStream(benchmark::State& state) {
+    const std::vector<std::vector<uint8_t>>& packets{ getPackets() };
+    const auto sink{ std::make_shared<PcmSink>() };
+    for (auto _ : state) {
+        for (int repetition{ 0 }; repetition < 10; repetition++) {
+            VorbisStream stream{ unsigned(state.range(0)) };
+            stream.addPcmCallback(sink);
+            for (const std::vector<uint8_t>& packet : packets) {
+                stream.processPacket(packet.data(), packet.size());
+            }
+            stream.flush();
+        }
+    }
+    state.SetItemsProcessed(int64_t(sink->numFrames));
+    state.SetLabel("frames");
+}
+BENCHMARK(BM_DecodeStream)->Arg(0)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
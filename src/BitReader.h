@@ -0,0 +1,106 @@
+#ifndef BIT_READER_H
+#define BIT_READER_H
+
+#include "util.h"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace vcpp {
+
+    /**
+    * Reads the bitstream of a Vorbis packet. Values are packed starting at the lowest bit
+    * of each byte. Reading past the end of the packet yields zero bits and sets the
+    * end-of-packet condition, which the decoder has to check at certain points.
+    */
+    class BitReader {
+        const uint8_t* data_;
+        const uint8_t* const end_;
+
+        // Bits that were loaded from the packet but not consumed yet, starting with the lowest bit.
+        uint64_t bits_;
+        unsigned int numBits_;
+        bool isEndOfPacket_;
+
+        /**
+        * Loads bytes until at least 57 bits are available or the packet is used up. Away 
+        * from the end of the packet, this is a single unaligned 64 bit load.
+        */
+        void refill() {
+            if (end_ - data_ >= 8) {
+                bits_ |= readUInt64LE(data_) << numBits_;
+                const unsigned int numBytes{ (63 - numBits_) >> 3 };
+                data_ += numBytes;
+                numBits_ += numBytes * 8;
+                return;
+            }
+            while (numBits_ <= 56 && data_ != end_) {
+                bits_ |= uint64_t(*data_) << numBits_;
+                data_++;
+                numBits_ += 8;
+            }
+        }
+
+    public:
+        BitReader(const uint8_t* const data, const std::size_t size)
+            : data_{ data },
+              end_{ data + size },
+              bits_{ 0 },
+              numBits_{ 0 },
+              isEndOfPacket_{ false } {}
+
+        /**
+        * Returns the next count bits without consuming them. count must not be greater 
+        * than 32. Bits past the end of the packet are zero.
+        */
+        uint32_t peek(const unsigned int count) {
+            if (numBits_ < count) {
+                refill();
+            }
+            return uint32_t(bits_ & ((uint64_t(1) << count) - 1));
+        }
+
+        /**
+        * Consumes count bits, which must have been peeked before.
+        */
+        void skip(const unsigned int count) {
+            if (numBits_ < count) {
+                bits_ = 0;
+                numBits_ = 0;
+                isEndOfPacket_ = true;
+                return;
+            }
+            bits_ >>= count;
+            numBits_ -= count;
+        }
+
+        /**
+        * Reads an unsigned integer of count bits. count must not be greater than 32.
+        */
+        uint32_t read(const unsigned int count) {
+            const uint32_t value{ peek(count) };
+            skip(count);
+            return value;
+        }
+
+        bool readFlag() {
+            return read(1) != 0;
+        }
+
+        /**
+        * Returns the number of bits that were not read yet.
+        */
+        std::size_t getNumRemainingBits() const {
+            return std::size_t(end_ - data_) * 8 + numBits_;
+        }
+
+        /**
+        * Returns true if a read went past the end of the packet.
+        */
+        bool isEndOfPacket() const {
+            return isEndOfPacket_;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,255 @@
+#include "IoUring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#if defined(__linux__)
+#   include <linux/io_uring.h>
+#   include <sys/mman.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+using namespace vcpp;
+
+#if defined(__linux__)
+
+static int setupRing(const unsigned int numEntries, io_uring_params& params) {
+    return int(syscall(__NR_io_uring_setup, numEntries, &params));
+}
+
+static int enterRing(const int ringFd, const unsigned int toSubmit, const unsigned int minComplete, const unsigned int flags) {
+    return int(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static int registerRing(const int ringFd, const unsigned int opcode, void* const arg, const unsigned int numArgs) {
+    return int(syscall(__NR_io_uring_register, ringFd, opcode, arg, numArgs));
+}
+
+// IORING_OP_READ was added in Linux 5.6, while rings can be set up since 5.1. Kernels
+// without it reject the probe too, because IORING_REGISTER_PROBE came with the same release.
+static bool isReadSupported(const int ringFd) {
+    constexpr unsigned int numOps{ 256 };
+    alignas(io_uring_probe) uint8_t buffer[sizeof(io_uring_probe) + numOps * sizeof(io_uring_probe_op)]{};
+    io_uring_probe* const probe{ reinterpret_cast<io_uring_probe*>(buffer) };
+    if (registerRing(ringFd, IORING_REGISTER_PROBE, probe, numOps) < 0) {
+        return false;
+    }
+    return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+static void* mapRing(const int ringFd, const std::size_t size, const off_t offset) {
+    void* const ring{ mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, offset) };
+    return ring == MAP_FAILED ? nullptr : ring;
+}
+
+template<typename T>
+static T* ringField(void* const ring, const unsigned int offset) {
+    return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+IoUring::IoUring(const unsigned int numEntries)
+    : ringFd_{ -1 },
+      numEntries_{ 0 },
+      submissionRing_{ nullptr },
+      submissionRingSize_{ 0 },
+      completionRing_{ nullptr },
+      completionRingSize_{ 0 },
+      submissionEntries_{ nullptr },
+      submissionEntriesSize_{ 0 },
+      submissionTail_{ nullptr },
+      submissionMask_{ 0 },
+      submissionArray_{ nullptr },
+      completionHead_{ nullptr },
+      completionTail_{ nullptr },
+      completionMask_{ 0 },
+      completions_{ nullptr },
+      nextId_{ 0 },
+      numInKernel_{ 0 },
+      isReaping_{ false } {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    const int ringFd{ setupRing(numEntries, params) };
+    if (ringFd < 0) {
+        return;
+    }
+
+    submissionRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    completionRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+        submissionRingSize_ = std::max(submissionRingSize_, completionRingSize_);
+        submissionRing_ = mapRing(ringFd, submissionRingSize_, IORING_OFF_SQ_RING);
+        completionRing_ = submissionRing_;
+        completionRingSize_ = 0;
+    }
+    else {
+        submissionRing_ = mapRing(ringFd, submissionRingSize_, IORING_OFF_SQ_RING);
+        completionRing_ = mapRing(ringFd, completionRingSize_, IORING_OFF_CQ_RING);
+    }
+    submissionEntriesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    submissionEntries_ = mapRing(ringFd, submissionEntriesSize_, IORING_OFF_SQES);
+
+    ringFd_ = ringFd;
+    if (submissionRing_ == nullptr || completionRing_ == nullptr || submissionEntries_ == nullptr || !isReadSupported(ringFd)) {
+        release();
+        return;
+    }
+
+    numEntries_ = params.sq_entries;
+    submissionTail_ = ringField<unsigned int>(submissionRing_, params.sq_off.tail);
+    submissionMask_ = *ringField<unsigned int>(submissionRing_, params.sq_off.ring_mask);
+    submissionArray_ = ringField<unsigned int>(submissionRing_, params.sq_off.array);
+    completionHead_ = ringField<unsigned int>(completionRing_, params.cq_off.head);
+    completionTail_ = ringField<unsigned int>(completionRing_, params.cq_off.tail);
+    completionMask_ = *ringField<unsigned int>(completionRing_, params.cq_off.ring_mask);
+    completions_ = ringField<io_uring_cqe>(completionRing_, params.cq_off.cqes);
+}
+
+IoUring::~IoUring() {
+    release();
+}
+
+void IoUring::release() {
+    if (submissionEntries_ != nullptr) {
+        munmap(submissionEntries_, submissionEntriesSize_);
+        submissionEntries_ = nullptr;
+    }
+    if (completionRing_ != nullptr && completionRing_ != submissionRing_) {
+        munmap(completionRing_, completionRingSize_);
+    }
+    completionRing_ = nullptr;
+    if (submissionRing_ != nullptr) {
+        munmap(submissionRing_, submissionRingSize_);
+        submissionRing_ = nullptr;
+    }
+    if (ringFd_ >= 0) {
+        close(ringFd_);
+        ringFd_ = -1;
+    }
+}
+
+void IoUring::reap(std::unique_lock<std::mutex>& guard) {
+    if (isReaping_) {
+        reaped_.wait(guard);
+        return;
+    }
+
+    isReaping_ = true;
+    guard.unlock();
+    int result{ enterRing(ringFd_, 0, 1, IORING_ENTER_GETEVENTS) };
+    while (result < 0 && errno == EINTR) {
+        result = enterRing(ringFd_, 0, 1, IORING_ENTER_GETEVENTS);
+    }
+    const int error{ result < 0 ? errno : 0 };
+    guard.lock();
+    isReaping_ = false;
+
+    unsigned int head{ *completionHead_ };
+    const unsigned int tail{ __atomic_load_n(completionTail_, __ATOMIC_ACQUIRE) };
+    for (; head != tail; head++) {
+        const io_uring_cqe& completion{ static_cast<const io_uring_cqe*>(completions_)[head & completionMask_] };
+        results_[completion.user_data] = completion.res;
+        numInKernel_--;
+    }
+    __atomic_store_n(completionHead_, head, __ATOMIC_RELEASE);
+    reaped_.notify_all();
+
+    if (error != 0) {
+        throw std::system_error(error, std::generic_category(), "io_uring_enter failed.");
+    }
+}
+
+uint64_t IoUring::submitRead(const int fd, uint8_t* const buffer, const uint32_t size, const uint64_t offset) {
+    std::unique_lock<std::mutex> guard{ lock_ };
+    while (numInKernel_ >= numEntries_) {
+        reap(guard);
+    }
+
+    // The kernel consumes every entry in enterRing(), so the submission queue is empty here.
+    const unsigned int tail{ *submissionTail_ };
+    const unsigned int index{ tail & submissionMask_ };
+    io_uring_sqe& entry{ static_cast<io_uring_sqe*>(submissionEntries_)[index] };
+    std::memset(&entry, 0, sizeof(entry));
+    entry.opcode = IORING_OP_READ;
+    entry.fd = fd;
+    entry.addr = reinterpret_cast<uint64_t>(buffer);
+    entry.len = size;
+    entry.off = offset;
+    entry.user_data = nextId_;
+    submissionArray_[index] = index;
+    __atomic_store_n(submissionTail_, tail + 1, __ATOMIC_RELEASE);
+
+    int result{ enterRing(ringFd_, 1, 0, 0) };
+    while (result < 0 && errno == EINTR) {
+        result = enterRing(ringFd_, 1, 0, 0);
+    }
+    if (result < 1) {
+        // Take the entry back, so that the submission queue stays empty.
+        __atomic_store_n(submissionTail_, tail, __ATOMIC_RELEASE);
+        throw std::system_error(result < 0 ? errno : EAGAIN, std::generic_category(), "io_uring_enter failed.");
+    }
+    numInKernel_++;
+    return nextId_++;
+}
+
+int32_t IoUring::waitForRead(const uint64_t id) {
+    std::unique_lock<std::mutex> guard{ lock_ };
+    while (true) {
+        const auto resultIt{ results_.find(id) };
+        if (resultIt != results_.end()) {
+            const int32_t result{ resultIt->second };
+            results_.erase(resultIt);
+            return result;
+        }
+        reap(guard);
+    }
+}
+
+#else
+
+IoUring::IoUring(const unsigned int numEntries)
+    : ringFd_{ -1 },
+      numEntries_{ 0 },
+      submissionRing_{ nullptr },
+      submissionRingSize_{ 0 },
+      completionRing_{ nullptr },
+      completionRingSize_{ 0 },
+      submissionEntries_{ nullptr },
+      submissionEntriesSize_{ 0 },
+      submissionTail_{ nullptr },
+      submissionMask_{ 0 },
+      submissionArray_{ nullptr },
+      completionHead_{ nullptr },
+      completionTail_{ nullptr },
+      completionMask_{ 0 },
+      completions_{ nullptr },
+      nextId_{ 0 },
+      numInKernel_{ 0 },
+      isReaping_{ false } {
+    (void)numEntries;
+}
+
+IoUring::~IoUring() {}
+
+void IoUring::release() {}
+
+void IoUring::reap(std::unique_lock<std::mutex>& guard) {
+    (void)guard;
+}
+
+uint64_t IoUring::submitRead(const int fd, uint8_t* const buffer, const uint32_t size, const uint64_t offset) {
+    (void)fd;
+    (void)buffer;
+    (void)size;
+    (void)offset;
+    throw std::system_error(std::make_error_code(std::errc::function_not_supported), "io_uring is not supported.");
+}
+
+int32_t IoUring::waitForRead(const uint64_t id) {
+    (void)id;
+    return -ENOSYS;
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef IO_URING_H
+#define IO_URING_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+namespace vcpp {
+
+    /**
+    * An io_uring instance that can be shared by many inputs and threads. Reads are submitted
+    * with submitRead() and collected with waitForRead(). Whichever thread waits first reaps
+    * the completion queue for everybody, so completions of other requests are kept until their
+    * owner asks for them.
+    *
+    * io_uring is only available on Linux. On other systems, or if the kernel does not support
+    * it or its read operation (before Linux 5.6), isValid() returns false and the ring must
+    * not be used.
+    */
+    class IoUring {
+        int ringFd_;
+        unsigned int numEntries_;
+
+        // Memory shared with the kernel.
+        void* submissionRing_;
+        std::size_t submissionRingSize_;
+        void* completionRing_;
+        std::size_t completionRingSize_;
+        void* submissionEntries_;
+        std::size_t submissionEntriesSize_;
+
+        // Pointers into the shared memory.
+        unsigned int* submissionTail_;
+        unsigned int submissionMask_;
+        unsigned int* submissionArray_;
+        unsigned int* completionHead_;
+        unsigned int* completionTail_;
+        unsigned int completionMask_;
+        void* completions_;
+
+        std::mutex lock_;
+        std::condition_variable reaped_;
+        uint64_t nextId_;
+
+        // Number of requests that were submitted, but whose completion was not reaped yet.
+        unsigned int numInKernel_;
+
+        // True while a thread waits for completions in the kernel.
+        bool isReaping_;
+
+        // Results of reaped requests that were not collected by waitForRead() yet.
+        std::unordered_map<uint64_t, int32_t> results_;
+
+        /**
+        * Waits until the completion queue was reaped once, either by this thread or by
+        * another thread. Must be called with guard locked and at least one request in the kernel.
+        */
+        void reap(std::unique_lock<std::mutex>& guard);
+
+        /**
+        * Unmaps the shared memory and closes the ring.
+        */
+        void release();
+
+    public:
+        /**
+        * Sets up a ring.
+        *
+        * @param numEntries Maximum number of requests in the kernel at the same time.
+        */
+        explicit IoUring(const unsigned int numEntries = 64);
+        ~IoUring();
+
+        IoUring(const IoUring& other) = delete;
+        IoUring& operator=(const IoUring& other) = delete;
+
+        bool isValid() const {
+            return ringFd_ >= 0;
+        }
+
+        /**
+        * Submits a read of size bytes at offset from the file descriptor fd into buffer.
+        * The buffer must stay valid until waitForRead() returned for the request. Waits
+        * if the ring is full. Returns an id for waitForRead().
+        * Throws an std::system_error if the request can not be submitted.
+        */
+        uint64_t submitRead(const int fd, uint8_t* const buffer, const uint32_t size, const uint64_t offset);
+
+        /**
+        * Waits for the read with the given id and returns its result, which is the number of
+        * bytes read or a negative errno value. Must be called exactly once for every request.
+        */
+        int32_t waitForRead(const uint64_t id);
+    };
+}
+
+#endif
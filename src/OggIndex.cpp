@@ -0,0 +1,201 @@
+#include "OggIndex.h"
+#include "util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+
+using namespace vcpp;
+
+static const uint8_t indexMagic[8]{ 'V', 'C', 'P', 'P', 'O', 'I', 'D', 'X' };
+
+/**
+* Reads the size and modification time of a file. Returns false if the file does not exist.
+*/
+static bool readFileInfo(const std::string& path, uint64_t& size, int64_t& modificationTime) {
+    std::error_code error;
+    size = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    const auto time{ std::filesystem::last_write_time(path, error) };
+    if (error) {
+        return false;
+    }
+    modificationTime = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    return true;
+}
+
+void OggIndex::build(const std::string& oggPath, const std::string& indexPath, const uint64_t interval) {
+    uint64_t fileSize;
+    int64_t modificationTime;
+    if (!readFileInfo(oggPath, fileSize, modificationTime)) {
+        throw OggStreamError(OggStreamError::Cause::IOError, "Could not read " + oggPath + ".");
+    }
+
+    // Streams in the order in which they appear in the file.
+    std::vector<uint32_t> serials;
+    std::unordered_map<uint32_t, std::vector<Entry>> entries;
+    {
+        OggPhysicalStreamIn in{ oggPath };
+        while (const std::optional<OggPage> page{ in.nextPage() }) {
+            if (page->granulePosition == -1) {
+                continue;
+            }
+
+            const uint64_t offset{ in.getPageOffset() };
+            auto entriesIt{ entries.find(page->streamSerialNumber) };
+            if (entriesIt == entries.end()) {
+                serials.push_back(page->streamSerialNumber);
+                entriesIt = entries.emplace(page->streamSerialNumber, std::vector<Entry>{}).first;
+            }
+            std::vector<Entry>& streamEntries{ entriesIt->second };
+            if (streamEntries.empty() || offset - streamEntries.back().offset >= interval) {
+                streamEntries.push_back(Entry{ offset, page->granulePosition, page->pageSequenceNumber });
+            }
+        }
+    }
+
+    std::size_t numEntries{ 0 };
+    for (const auto& streamEntries : entries) {
+        numEntries += streamEntries.second.size();
+    }
+    std::vector<uint8_t> data(headerSize + serials.size() * streamSize + numEntries * entrySize);
+
+    std::copy_n(indexMagic, sizeof(indexMagic), data.begin());
+    writeUInt32LE(&data[8], version);
+    writeUInt32LE(&data[12], uint32_t(serials.size()));
+    writeUInt64LE(&data[16], fileSize);
+    writeUInt64LE(&data[24], uint64_t(modificationTime));
+
+    uint8_t* stream{ &data[headerSize] };
+    uint8_t* entry{ stream + serials.size() * streamSize };
+    uint64_t entryIndex{ 0 };
+    for (const uint32_t serial : serials) {
+        const std::vector<Entry>& streamEntries{ entries[serial] };
+        writeUInt32LE(stream, serial);
+        writeUInt32LE(stream + 4, uint32_t(streamEntries.size()));
+        writeUInt64LE(stream + 8, entryIndex);
+        stream += streamSize;
+
+        for (const Entry& e : streamEntries) {
+            writeUInt64LE(entry, e.offset);
+            writeUInt64LE(entry + 8, uint64_t(e.granulePosition));
+            writeUInt32LE(entry + 16, e.pageSequenceNumber);
+            writeUInt32LE(entry + 20, 0);
+            entry += entrySize;
+        }
+        entryIndex += streamEntries.size();
+    }
+
+    FILE* const file{ std::fopen(indexPath.c_str(), "wb") };
+    if (file == nullptr) {
+        throw OggStreamError(OggStreamError::Cause::IOError, "Could not open " + indexPath + ".");
+    }
+    const bool isWritten{ std::fwrite(data.data(), 1, data.size(), file) == data.size() };
+    if (std::fclose(file) != 0 || !isWritten) {
+        throw OggStreamError(OggStreamError::Cause::IOError, "Could not write " + indexPath + ".");
+    }
+}
+
+OggIndex::OggIndex(const std::string& indexPath, const std::string& oggPath)
+    : file_{ indexPath },
+      isValid_{ false },
+      numStreams_{ 0 },
+      oggFileSize_{ 0 } {
+    uint64_t fileSize;
+    int64_t modificationTime;
+    if (!file_.isValid() || file_.size() < headerSize || !readFileInfo(oggPath, fileSize, modificationTime)) {
+        return;
+    }
+
+    const uint8_t* const data{ file_.data() };
+    if (!std::equal(indexMagic, indexMagic + sizeof(indexMagic), data)
+        || readUInt32LE(&data[8]) != version
+        || readUInt64LE(&data[16]) != fileSize
+        || int64_t(readUInt64LE(&data[24])) != modificationTime) {
+        return;
+    }
+
+    // Check that the streams and their entries lie within the file.
+    const uint64_t numStreams{ readUInt32LE(&data[12]) };
+    if ((file_.size() - headerSize) / streamSize < numStreams) {
+        return;
+    }
+    const uint64_t maxEntries{ (file_.size() - headerSize - numStreams * streamSize) / entrySize };
+    for (uint64_t i{ 0 }; i < numStreams; i++) {
+        const uint8_t* const stream{ &data[headerSize + i * streamSize] };
+        const uint64_t firstEntry{ readUInt64LE(stream + 8) };
+        if (firstEntry > maxEntries || maxEntries - firstEntry < readUInt32LE(stream + 4)) {
+            return;
+        }
+    }
+
+    numStreams_ = uint32_t(numStreams);
+    oggFileSize_ = fileSize;
+    isValid_ = true;
+}
+
+OggIndex::Entry OggIndex::readEntry(const uint64_t index) const {
+    const uint8_t* const entry{ file_.data() + headerSize + numStreams_ * streamSize + index * entrySize };
+    return Entry{ readUInt64LE(entry), int64_t(readUInt64LE(entry + 8)), readUInt32LE(entry + 16) };
+}
+
+bool OggIndex::findStream(const uint32_t streamSerialNumber, uint64_t& firstEntry, uint64_t& numEntries) const {
+    for (uint32_t i{ 0 }; isValid_ && i < numStreams_; i++) {
+        const uint8_t* const stream{ file_.data() + headerSize + i * streamSize };
+        if (readUInt32LE(stream) == streamSerialNumber) {
+            numEntries = readUInt32LE(stream + 4);
+            firstEntry = readUInt64LE(stream + 8);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t OggIndex::findFirstEntryNotBefore(const uint64_t firstEntry, const uint64_t numEntries, const int64_t granulePosition) const {
+    uint64_t low{ firstEntry };
+    uint64_t high{ firstEntry + numEntries };
+    while (low < high) {
+        const uint64_t middle{ low + (high - low) / 2 };
+        if (readEntry(middle).granulePosition < granulePosition) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+std::optional<OggIndex::Entry> OggIndex::findEntryBefore(const uint32_t streamSerialNumber, const int64_t granulePosition) const {
+    uint64_t firstEntry;
+    uint64_t numEntries;
+    if (!findStream(streamSerialNumber, firstEntry, numEntries)) {
+        return std::optional<Entry>{};
+    }
+
+    const uint64_t entry{ findFirstEntryNotBefore(firstEntry, numEntries, granulePosition) };
+    if (entry == firstEntry) {
+        return std::optional<Entry>{};
+    }
+    return readEntry(entry - 1);
+}
+
+bool OggIndex::seekToGranule(OggPhysicalStreamIn& in, const uint32_t streamSerialNumber, const int64_t granulePosition) const {
+    uint64_t firstEntry;
+    uint64_t numEntries;
+    if (!findStream(streamSerialNumber, firstEntry, numEntries)) {
+        return in.seekToGranule(streamSerialNumber, granulePosition);
+    }
+
+    // The target page begins after the last entry before granulePosition and 
+    // at or before the entry after it.
+    const uint64_t entry{ findFirstEntryNotBefore(firstEntry, numEntries, granulePosition) };
+    const uint64_t begin{ entry > firstEntry ? readEntry(entry - 1).offset : 0 };
+    const uint64_t end{ entry < firstEntry + numEntries ? readEntry(entry).offset + 1 : oggFileSize_ };
+    return in.seekToGranule(streamSerialNumber, granulePosition, begin, end);
+}
@@ -0,0 +1,131 @@
+#ifndef OGG_INDEX_H
+#define OGG_INDEX_H
+
+#include "OggStream.h"
+#include "util.h"
+
+#include <cstdint>
+#include <string>
+#include <optional>
+
+namespace vcpp {
+
+    /**
+    * Index of the pages of an Ogg file, stored in a sidecar file next to it. For every logical
+    * stream, the index records the byte offset, granule position and page sequence number of
+    * some of its pages, so that a seek only has to read the part of the Ogg file between two
+    * entries.
+    *
+    * The sidecar file is memory-mapped. All values are stored in little endian:
+    *
+    *   Header (32 bytes): magic "VCPPOIDX", version (u32), number of streams (u32),
+    *                      size of the Ogg file (u64), modification time of the Ogg file (i64)
+    *   Streams (16 bytes each): stream serial number (u32), number of entries (u32),
+    *                            index of the stream's first entry (u64)
+    *   Entries (24 bytes each): page offset (u64), granule position (i64),
+    *                            page sequence number (u32), reserved (u32)
+    *
+    * The entries of each stream are sorted by offset and granule position.
+    */
+    class OggIndex {
+    public:
+        /**
+        * A page of a logical stream that was recorded in the index.
+        */
+        struct Entry {
+            // Offset of the page in the Ogg file.
+            uint64_t offset;
+
+            // Granule position of the page.
+            int64_t granulePosition;
+
+            // Page sequence number of the page.
+            uint32_t pageSequenceNumber;
+        };
+
+        // Version of the sidecar format written by build().
+        static constexpr uint32_t version = 1;
+
+        // Default distance in bytes between two entries of the same logical stream.
+        static constexpr uint64_t defaultInterval = 0x10000;
+
+    private:
+        static constexpr std::size_t headerSize = 32;
+        static constexpr std::size_t streamSize = 16;
+        static constexpr std::size_t entrySize = 24;
+
+        const MappedFile file_;
+        bool isValid_;
+        uint32_t numStreams_;
+        uint64_t oggFileSize_;
+
+        Entry readEntry(const uint64_t index) const;
+
+        /**
+        * Finds the entries of a logical stream. Returns false if the stream is not in the index.
+        */
+        bool findStream(const uint32_t streamSerialNumber, uint64_t& firstEntry, uint64_t& numEntries) const;
+
+        /**
+        * Returns the index of the first entry in [firstEntry, firstEntry + numEntries) whose granule 
+        * position is not lower than granulePosition, or firstEntry + numEntries if there is none.
+        */
+        uint64_t findFirstEntryNotBefore(const uint64_t firstEntry, const uint64_t numEntries, const int64_t granulePosition) const;
+
+    public:
+        /**
+        * Reads the Ogg file at oggPath once and writes an index for it to indexPath. An entry
+        * is recorded for the first page of every logical stream that has a granule position,
+        * and after that for the first such page that begins at least interval bytes after the
+        * stream's previous entry.
+        * Throws an OggStreamError if one of the files can not be read or written.
+        *
+        * @param oggPath Path of the Ogg file.
+        * @param indexPath Path of the sidecar file to be written.
+        * @param interval Minimum distance in bytes between two entries of the same logical stream.
+        */
+        static void build(
+            const std::string& oggPath,
+            const std::string& indexPath,
+            const uint64_t interval = defaultInterval);
+
+        /**
+        * Opens the index at indexPath for the Ogg file at oggPath. If the index can not be read,
+        * has a different version or does not match the current size and modification time of
+        * the Ogg file, isValid() returns false.
+        *
+        * @param indexPath Path of the sidecar file.
+        * @param oggPath Path of the Ogg file that the index belongs to.
+        */
+        OggIndex(const std::string& indexPath, const std::string& oggPath);
+
+        OggIndex(const OggIndex& other) = delete;
+        OggIndex& operator=(const OggIndex& other) = delete;
+
+        bool isValid() const {
+            return isValid_;
+        }
+
+        /**
+        * Returns the last entry of a logical stream whose granule position is lower than the
+        * given one. Returns an empty optional if there is no such entry.
+        *
+        * @param streamSerialNumber Serial number of the logical stream.
+        * @param granulePosition Granule position to search for.
+        */
+        std::optional<Entry> findEntryBefore(const uint32_t streamSerialNumber, const int64_t granulePosition) const;
+
+        /**
+        * Seeks an OggPhysicalStreamIn reading the indexed Ogg file to the page of a logical stream
+        * that contains the given granule position. Only the range between the two entries around
+        * the granule position is searched. See OggPhysicalStreamIn::seekToGranule().
+        *
+        * @param in The stream to seek. It must read the Ogg file from its beginning.
+        * @param streamSerialNumber Serial number of the logical stream.
+        * @param granulePosition Granule position to seek to.
+        */
+        bool seekToGranule(OggPhysicalStreamIn& in, const uint32_t streamSerialNumber, const int64_t granulePosition) const;
+    };
+}
+
+#endif
@@ -1,4 +1,5 @@
 ﻿#include "OggStream.h"
+#include "SpscQueue.h"
 #include "util.h"
 
 #include <string>
@@ -6,10 +7,28 @@
 #include <istream>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <condition_variable>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#if defined(_WIN32)
+#   include <io.h>
+#else
+#   include <climits>
+#   include <sys/uio.h>
+#endif
 
 using namespace vcpp;
 
-const CRC32 oggCRC(0x04C11DB7);
+constexpr StaticCRC32<0x04C11DB7> oggCRC{};
 
 const unsigned int maxPageSize = 255 * 255;
 
@@ -37,20 +56,64 @@ OggPage::OggPage(OggPage::Params&& params)
       streamSerialNumber{ std::move(params.streamSerialNumber) },
       pageSequenceNumber{ std::move(params.pageSequenceNumber) },
       pageChecksum{ std::move(params.pageChecksum) },
+      numSegments{ std::move(params.numSegments) },
+      segmentTable{ std::move(params.segmentTable) },
       dataSize{ std::move(params.dataSize) },
-      data{ std::move(params.data) } {
+      data_{ std::move(params.data) } {
     params.data = nullptr;
 }
 
+//----------------------------------------------
+//               PageBufferPool
+//----------------------------------------------
+
+PageBufferPool::PageBufferPool(std::pmr::memory_resource* const resource, const std::size_t maxFreeBuffers)
+    : resource_{ resource }, maxFreeBuffers_{ maxFreeBuffers } {
+    freeBuffers_.reserve(maxFreeBuffers);
+}
+
+PageBufferPool::~PageBufferPool() {
+    for (uint8_t* const buffer : freeBuffers_) {
+        resource_->deallocate(buffer, bufferSize);
+    }
+}
+
+uint8_t* PageBufferPool::acquire() {
+    {
+        const std::lock_guard<std::mutex> guard{ lock_ };
+        if (!freeBuffers_.empty()) {
+            uint8_t* const buffer{ freeBuffers_.back() };
+            freeBuffers_.pop_back();
+            return buffer;
+        }
+    }
+    return static_cast<uint8_t*>(resource_->allocate(bufferSize));
+}
+
+void PageBufferPool::release(const uint8_t* const buffer) {
+    uint8_t* const writableBuffer{ const_cast<uint8_t*>(buffer) };
+    {
+        const std::lock_guard<std::mutex> guard{ lock_ };
+        if (freeBuffers_.size() < maxFreeBuffers_) {
+            freeBuffers_.push_back(writableBuffer);
+            return;
+        }
+    }
+    resource_->deallocate(writableBuffer, bufferSize);
+}
+
 //----------------------------------------------
 //             OggLogicalStreamIn
 //----------------------------------------------
 
 OggLogicalStreamIn::OggLogicalStreamIn(uint32_t streamSerialNumber)
-    : streamSerialNumber_{ streamSerialNumber },
-      granulePosition_{ -1 }, 
+    : granulePosition_{ -1 },
+      streamSerialNumber_{ streamSerialNumber },
       pageSequenceNumber_{ 0 },
-      isOpen_{ false } {}
+      isOpen_{ false },
+      isPageSequenceUnknown_{ false },
+      hasPartialPacket_{ false },
+      cursor_{ nullptr, 0, 0, -1, 0, 0 } {}
 
 void OggLogicalStreamIn::addDataCallback(const std::shared_ptr<DataCallback> callback) {
     dataCallbacks_.emplace_back(callback);
@@ -63,10 +126,88 @@ void OggLogicalStreamIn::removeDataCallback(const std::shared_ptr<DataCallback>&
     }
 }
 
-void OggLogicalStreamIn::processPage(const OggPage& page) {
+void OggLogicalStreamIn::addPacketCallback(const std::shared_ptr<PacketCallback> callback) {
+    packetCallbacks_.emplace_back(callback);
+}
+
+void OggLogicalStreamIn::removePacketCallback(const std::shared_ptr<PacketCallback>& callback) {
+    auto callbackIt{ find(packetCallbacks_.cbegin(), packetCallbacks_.cend(), callback) };
+    if (callbackIt != packetCallbacks_.cend()) {
+        packetCallbacks_.erase(callbackIt);
+    }
+}
+
+void OggLogicalStreamIn::beginPacketExtraction(const OggPage& page, const unsigned int numSkippedPages) {
+    int lastCompleteSegment{ -1 };
+    for (int i{ 0 }; i < page.numSegments; i++) {
+        if (page.segmentTable[i] < 255) {
+            lastCompleteSegment = i;
+        }
+    }
+    cursor_ = PacketCursor{ &page, 0, 0, lastCompleteSegment, 0, numSkippedPages };
+
+    // The rest of an unfinished packet was lost.
+    if (numSkippedPages > 0 || !page.isContinuedPacket) {
+        hasPartialPacket_ = false;
+    }
+}
+
+std::optional<OggLogicalStreamIn::PacketView> OggLogicalStreamIn::nextPacket() {
+    const OggPage& page{ *cursor_.page };
+    while (cursor_.segmentIndex < page.numSegments) {
+        const bool isContinuation{ cursor_.segmentIndex == 0 && page.isContinuedPacket };
+        const std::size_t start{ cursor_.dataOffset };
+        std::size_t size{ 0 };
+        bool isComplete{ false };
+        int endSegment{ 0 };
+        while (cursor_.segmentIndex < page.numSegments && !isComplete) {
+            const uint8_t lacingValue{ page.segmentTable[cursor_.segmentIndex] };
+            endSegment = int(cursor_.segmentIndex);
+            size += lacingValue;
+            isComplete = lacingValue < 255;
+            cursor_.segmentIndex++;
+        }
+        cursor_.dataOffset += size;
+        const uint8_t* const fragment{ page.getData() + start };
+
+        if (isContinuation && !hasPartialPacket_) {
+            // The beginning of this packet is missing.
+            continue;
+        }
+
+        const uint8_t* packetData{ fragment };
+        std::size_t packetSize{ size };
+        if (isContinuation || !isComplete) {
+            if (!isContinuation) {
+                packetBuffer_.clear();
+            }
+            packetBuffer_.insert(packetBuffer_.end(), fragment, fragment + size);
+            hasPartialPacket_ = !isComplete;
+            if (!isComplete) {
+                break;
+            }
+            packetData = packetBuffer_.data();
+            packetSize = packetBuffer_.size();
+        }
+
+        const bool isLastOnPage{ endSegment == cursor_.lastCompleteSegment };
+        const PacketMetaData meta{
+            isLastOnPage ? page.granulePosition : -1,
+            cursor_.numSkippedPages,
+            page.isFirstPage && cursor_.numPacketsReturned == 0,
+            page.isLastPage && isLastOnPage
+        };
+        cursor_.numPacketsReturned++;
+        cursor_.numSkippedPages = 0;
+        return PacketView{ packetData, packetSize, meta };
+    }
+    return std::optional<PacketView>{};
+}
+
+unsigned int OggLogicalStreamIn::updatePageSequence(const OggPage& page) {
     unsigned int numSkippedPages{ 0 };
 
-    if (!page.isFirstPage) {
+    if (!page.isFirstPage && !isPageSequenceUnknown_) {
         oggAssert(
             page.pageSequenceNumber > pageSequenceNumber_,
             "Page sequence number is lower than expected.",
@@ -75,6 +216,19 @@ void OggLogicalStreamIn::processPage(const OggPage& page) {
         numSkippedPages = page.pageSequenceNumber - (pageSequenceNumber_ + 1);
     }
 
+    pageSequenceNumber_ = page.pageSequenceNumber;
+    isPageSequenceUnknown_ = false;
+    return numSkippedPages;
+}
+
+void OggLogicalStreamIn::resetPosition() {
+    hasPartialPacket_ = false;
+    isPageSequenceUnknown_ = true;
+}
+
+void OggLogicalStreamIn::processPage(const OggPage& page) {
+    const unsigned int numSkippedPages{ updatePageSequence(page) };
+
     const MetaData meta {
         page.granulePosition,
         numSkippedPages,
@@ -83,26 +237,41 @@ void OggLogicalStreamIn::processPage(const OggPage& page) {
         page.isLastPage
     };
     for (std::shared_ptr<DataCallback>& callback : dataCallbacks_) {
-        callback->onDataAvailable(page.data.get(), page.dataSize, meta);
+        callback->onDataAvailable(page.getData(), page.dataSize, meta);
     }
 
-    pageSequenceNumber_ = page.pageSequenceNumber;
+    if (!packetCallbacks_.empty()) {
+        beginPacketExtraction(page, numSkippedPages);
+        while (const std::optional<PacketView> packet{ nextPacket() }) {
+            for (std::shared_ptr<PacketCallback>& callback : packetCallbacks_) {
+                callback->onPacketAvailable(packet->data, packet->size, packet->meta);
+            }
+        }
+    }
 }
 
 //----------------------------------------------
 //            OggPhysicalStreamIn
 //----------------------------------------------
 
-OggPhysicalStreamIn::FileInput::FileInput(FILE* file) : file_{ file } {}
+static int64_t tellFile(FILE* const file) {
+#ifdef _WIN32
+    return _ftelli64(file);
+#else
+    return ftello(file);
+#endif
+}
 
-uint8_t OggPhysicalStreamIn::FileInput::read() {
-    uint8_t out{ uint8_t(fgetc(file_)) };
-    if (ferror(file_)) {
-        throw OggStreamError(OggStreamError::Cause::IOError, "IOError occured.");
-    }
-    return out;
+static bool seekFile(FILE* const file, const int64_t offset, const int origin) {
+#ifdef _WIN32
+    return _fseeki64(file, offset, origin) == 0;
+#else
+    return fseeko(file, off_t(offset), origin) == 0;
+#endif
 }
 
+OggPhysicalStreamIn::FileInput::FileInput(FILE* file) : file_{ file }, origin_{ tellFile(file) } {}
+
 std::size_t OggPhysicalStreamIn::FileInput::read(uint8_t* const buffer, const std::size_t count) {
     std::size_t numChars{ fread(buffer, sizeof(uint8_t), count, file_) };
     if (ferror(file_)) {
@@ -111,20 +280,25 @@ std::size_t OggPhysicalStreamIn::FileInput::read(uint8_t* const buffer, const st
     return numChars;
 }
 
-bool OggPhysicalStreamIn::FileInput::eof() const {
-    return feof(file_);
+bool OggPhysicalStreamIn::FileInput::isSeekable() const {
+    return origin_ >= 0;
 }
 
-OggPhysicalStreamIn::StreamInput::StreamInput(std::basic_istream<uint8_t>& in) : in_{ in } {}
+void OggPhysicalStreamIn::FileInput::seek(const uint64_t offset) {
+    oggAssert(seekFile(file_, origin_ + int64_t(offset), SEEK_SET), "IOError occured.", OggStreamError::Cause::IOError);
+}
 
-uint8_t OggPhysicalStreamIn::StreamInput::read() {
-    uint8_t out{ uint8_t(in_.get()) };
-    if (in_.fail() && !in_.eof()) {
-        throw OggStreamError(OggStreamError::Cause::IOError, "IOError occured.");
-    }
-    return out;
+uint64_t OggPhysicalStreamIn::FileInput::size() {
+    const int64_t position{ tellFile(file_) };
+    oggAssert(seekFile(file_, 0, SEEK_END), "IOError occured.", OggStreamError::Cause::IOError);
+    const int64_t end{ tellFile(file_) };
+    oggAssert(seekFile(file_, position, SEEK_SET), "IOError occured.", OggStreamError::Cause::IOError);
+    return uint64_t(end - origin_);
 }
 
+OggPhysicalStreamIn::StreamInput::StreamInput(std::basic_istream<uint8_t>& in) 
+    : in_{ in }, origin_{ std::streamoff(in.tellg()) } {}
+
 std::size_t OggPhysicalStreamIn::StreamInput::read(uint8_t* const buffer, const std::size_t count) {
     in_.read(buffer, count);
     if (in_.fail() && !in_.eof()) {
@@ -133,13 +307,284 @@ std::size_t OggPhysicalStreamIn::StreamInput::read(uint8_t* const buffer, const
     return in_.gcount();
 }
 
-bool OggPhysicalStreamIn::StreamInput::eof() const {
-    return in_.eof();
+bool OggPhysicalStreamIn::StreamInput::isSeekable() const {
+    return origin_ >= 0;
+}
+
+void OggPhysicalStreamIn::StreamInput::seek(const uint64_t offset) {
+    in_.clear();
+    in_.seekg(std::streamoff(origin_ + int64_t(offset)));
+    oggAssert(!in_.fail(), "IOError occured.", OggStreamError::Cause::IOError);
+}
+
+uint64_t OggPhysicalStreamIn::StreamInput::size() {
+    in_.clear();
+    const auto position{ in_.tellg() };
+    in_.seekg(0, std::ios_base::end);
+    const int64_t end{ std::streamoff(in_.tellg()) };
+    in_.seekg(position);
+    oggAssert(!in_.fail(), "IOError occured.", OggStreamError::Cause::IOError);
+    return uint64_t(end - origin_);
+}
+
+OggPhysicalStreamIn::MappedInput::MappedInput(const std::string& path)
+    : file_{ path }, position_{ 0 } {
+    oggAssert(file_.isValid(), "Could not map file " + path + ".", OggStreamError::Cause::IOError);
+}
+
+std::size_t OggPhysicalStreamIn::MappedInput::read(uint8_t* const buffer, const std::size_t count) {
+    const std::size_t numChars{ std::min(count, file_.size() - position_) };
+    std::copy_n(file_.data() + position_, numChars, buffer);
+    position_ += numChars;
+    return numChars;
+}
+
+const uint8_t* OggPhysicalStreamIn::MappedInput::map(std::size_t& size) {
+    const uint8_t* const out{ file_.data() + position_ };
+    size = file_.size() - position_;
+    position_ = file_.size();
+    return out;
+}
+
+bool OggPhysicalStreamIn::MappedInput::isSeekable() const {
+    return true;
 }
 
-OggPhysicalStreamIn::OggPhysicalStreamIn(std::basic_istream<uint8_t>& in) : input_{ std::make_unique<StreamInput>(in) } {}
+void OggPhysicalStreamIn::MappedInput::seek(const uint64_t offset) {
+    position_ = std::size_t(std::min(offset, uint64_t(file_.size())));
+}
+
+uint64_t OggPhysicalStreamIn::MappedInput::size() {
+    return file_.size();
+}
+
+static int fileDescriptor(FILE* const file) {
+#ifdef _WIN32
+    return _fileno(file);
+#else
+    return fileno(file);
+#endif
+}
+
+static uint64_t submitRingRead(IoUring& ring, FILE* const file, uint8_t* const buffer, const std::size_t size, const uint64_t offset) {
+    try {
+        return ring.submitRead(fileDescriptor(file), buffer, uint32_t(size), offset);
+    }
+    catch (const std::system_error& e) {
+        throw OggStreamError(OggStreamError::Cause::IOError, e.what());
+    }
+}
+
+std::size_t OggPhysicalStreamIn::FedInput::read(uint8_t* const buffer, const std::size_t count) {
+    (void)buffer;
+    (void)count;
+    return 0;
+}
+
+OggPhysicalStreamIn::UringInput::UringInput(const std::string& path, const std::shared_ptr<IoUring> ring)
+    : ring_{ ring != nullptr && ring->isValid() ? ring : nullptr },
+      file_{ std::fopen(path.c_str(), "rb") },
+      fileSize_{ 0 },
+      requests_{},
+      front_{ 0 },
+      numActive_{ 0 },
+      nextOffset_{ 0 } {
+    oggAssert(file_ != nullptr, "Could not open file " + path + ".", OggStreamError::Cause::IOError);
+    if (ring_ != nullptr) {
+        const bool isSized{ seekFile(file_, 0, SEEK_END) };
+        const int64_t end{ tellFile(file_) };
+        if (!isSized || end < 0) {
+            std::fclose(file_);
+            throw OggStreamError(OggStreamError::Cause::IOError, "IOError occured.");
+        }
+        fileSize_ = uint64_t(end);
+        for (Request& request : requests_) {
+            request.buffer = std::unique_ptr<uint8_t[]>{ new uint8_t[requestSize] };
+            request.isPending = false;
+        }
+    }
+}
 
-OggPhysicalStreamIn::OggPhysicalStreamIn(FILE* file) : input_{ std::make_unique<FileInput>(file) } {}
+OggPhysicalStreamIn::UringInput::~UringInput() {
+    try {
+        cancelRequests();
+    }
+    catch (...) {
+        // The ring failed, the buffers can not be freed safely.
+        for (Request& request : requests_) {
+            if (request.isPending) {
+                request.buffer.release();
+            }
+        }
+    }
+    std::fclose(file_);
+}
+
+void OggPhysicalStreamIn::UringInput::submitRequests() {
+    while (numActive_ < numRequests && nextOffset_ < fileSize_) {
+        Request& request{ requests_[(front_ + numActive_) % numRequests] };
+        request.offset = nextOffset_;
+        request.size = std::size_t(std::min(uint64_t(requestSize), fileSize_ - nextOffset_));
+        request.available = 0;
+        request.consumed = 0;
+        request.id = submitRingRead(*ring_, file_, request.buffer.get(), request.size, request.offset);
+        request.isPending = true;
+        nextOffset_ += request.size;
+        numActive_++;
+    }
+}
+
+bool OggPhysicalStreamIn::UringInput::completeRequest(Request& request) {
+    int32_t result{ ring_->waitForRead(request.id) };
+    request.isPending = false;
+    while (result > 0) {
+        request.available += std::size_t(result);
+        if (request.available == request.size) {
+            return true;
+        }
+
+        // Short read, ask for the rest.
+        request.isPending = true;
+        request.id = submitRingRead(
+            *ring_, file_, &request.buffer[request.available], request.size - request.available, request.offset + request.available);
+        result = ring_->waitForRead(request.id);
+        request.isPending = false;
+    }
+    if (result == -EINVAL || result == -EOPNOTSUPP) {
+        return false;
+    }
+    oggAssert(result == 0, "IOError occured.", OggStreamError::Cause::IOError);
+    return true;
+}
+
+void OggPhysicalStreamIn::UringInput::fallBackToBlockingReads() {
+    const uint64_t position{ numActive_ > 0 ? requests_[front_].offset + requests_[front_].consumed : nextOffset_ };
+    cancelRequests();
+    ring_.reset();
+    oggAssert(seekFile(file_, int64_t(position), SEEK_SET), "IOError occured.", OggStreamError::Cause::IOError);
+}
+
+void OggPhysicalStreamIn::UringInput::cancelRequests() {
+    for (Request& request : requests_) {
+        if (request.isPending) {
+            ring_->waitForRead(request.id);
+            request.isPending = false;
+        }
+    }
+    front_ = 0;
+    numActive_ = 0;
+}
+
+std::size_t OggPhysicalStreamIn::UringInput::read(uint8_t* const buffer, const std::size_t count) {
+    if (ring_ == nullptr) {
+        const std::size_t numChars{ fread(buffer, sizeof(uint8_t), count, file_) };
+        oggAssert(!ferror(file_), "IOError occured.", OggStreamError::Cause::IOError);
+        return numChars;
+    }
+
+    std::size_t numRead{ 0 };
+    while (numRead < count) {
+        submitRequests();
+        if (numActive_ == 0) {
+            break;
+        }
+
+        Request& request{ requests_[front_] };
+        if (request.isPending && !completeRequest(request)) {
+            fallBackToBlockingReads();
+            return numRead + read(buffer + numRead, count - numRead);
+        }
+        const std::size_t numCopied{ std::min(count - numRead, request.available - request.consumed) };
+        std::copy_n(&request.buffer[request.consumed], numCopied, &buffer[numRead]);
+        request.consumed += numCopied;
+        numRead += numCopied;
+
+        if (request.consumed == request.available) {
+            // A request that came up short means that the file ended early.
+            if (request.available < request.size) {
+                nextOffset_ = fileSize_;
+            }
+            front_ = (front_ + 1) % numRequests;
+            numActive_--;
+        }
+    }
+    return numRead;
+}
+
+bool OggPhysicalStreamIn::UringInput::isSeekable() const {
+    return true;
+}
+
+void OggPhysicalStreamIn::UringInput::seek(const uint64_t offset) {
+    if (ring_ == nullptr) {
+        oggAssert(seekFile(file_, int64_t(offset), SEEK_SET), "IOError occured.", OggStreamError::Cause::IOError);
+        return;
+    }
+    cancelRequests();
+    nextOffset_ = std::min(offset, fileSize_);
+}
+
+uint64_t OggPhysicalStreamIn::UringInput::size() {
+    if (ring_ == nullptr) {
+        const int64_t position{ tellFile(file_) };
+        oggAssert(seekFile(file_, 0, SEEK_END), "IOError occured.", OggStreamError::Cause::IOError);
+        const int64_t end{ tellFile(file_) };
+        oggAssert(seekFile(file_, position, SEEK_SET), "IOError occured.", OggStreamError::Cause::IOError);
+        return uint64_t(end);
+    }
+    return fileSize_;
+}
+
+OggPhysicalStreamIn::OggPhysicalStreamIn(std::unique_ptr<Input>&& input, std::pmr::memory_resource* const resource)
+    : pagePool_{ resource },
+      input_{ std::move(input) },
+      currentStream_{ nullptr },
+      bufferBegin_{ nullptr },
+      bufferEnd_{ nullptr },
+      mappedBegin_{ nullptr },
+      inputOffset_{ 0 },
+      pageOffset_{ 0 },
+      isMapped_{ false },
+      isInputExhausted_{ false },
+      numSkippedBytes_{ 0 },
+      isFed_{ false },
+      hasSeeked_{ false } {
+    std::size_t mappedSize{ 0 };
+    const uint8_t* const mappedData{ input_->map(mappedSize) };
+    if (mappedData != nullptr) {
+        bufferBegin_ = mappedData;
+        bufferEnd_ = mappedData + mappedSize;
+        mappedBegin_ = mappedData;
+        inputOffset_ = mappedSize;
+        isMapped_ = true;
+        isInputExhausted_ = true;
+    }
+    else {
+        buffer_ = std::unique_ptr<uint8_t[]>{ new uint8_t[bufferCapacity] };
+        bufferBegin_ = buffer_.get();
+        bufferEnd_ = buffer_.get();
+    }
+}
+
+OggPhysicalStreamIn::OggPhysicalStreamIn(std::basic_istream<uint8_t>& in, std::pmr::memory_resource* const resource)
+    : OggPhysicalStreamIn{ std::make_unique<StreamInput>(in), resource } {}
+
+OggPhysicalStreamIn::OggPhysicalStreamIn(FILE* file, std::pmr::memory_resource* const resource)
+    : OggPhysicalStreamIn{ std::make_unique<FileInput>(file), resource } {}
+
+OggPhysicalStreamIn::OggPhysicalStreamIn(const std::string& path) 
+    : OggPhysicalStreamIn{ std::make_unique<MappedInput>(path), std::pmr::get_default_resource() } {}
+
+OggPhysicalStreamIn::OggPhysicalStreamIn(std::pmr::memory_resource* const resource)
+    : OggPhysicalStreamIn{ std::make_unique<FedInput>(), resource } {
+    isFed_ = true;
+}
+
+OggPhysicalStreamIn::OggPhysicalStreamIn(
+    const std::string& path,
+    const std::shared_ptr<IoUring> ring,
+    std::pmr::memory_resource* const resource)
+    : OggPhysicalStreamIn{ std::make_unique<UringInput>(path, ring), resource } {}
 
 void OggPhysicalStreamIn::addNewStreamCallback(const std::shared_ptr<NewStreamCallback> callback) {
     newStreamCallbacks_.emplace_back(callback);
@@ -150,11 +595,48 @@ void OggPhysicalStreamIn::removeNewStreamCallback(const std::shared_ptr<NewStrea
     newStreamCallbacks_.erase(callbackIt);
 }
 
+uint64_t OggPhysicalStreamIn::getNumSkippedBytes() const {
+    return numSkippedBytes_;
+}
+
+uint64_t OggPhysicalStreamIn::getPageOffset() const {
+    return pageOffset_;
+}
+
+std::size_t OggPhysicalStreamIn::fillBuffer(const std::size_t count) {
+    std::size_t available{ std::size_t(bufferEnd_ - bufferBegin_) };
+    if (available >= count || isInputExhausted_) {
+        return available;
+    }
+
+    // Move the remaining bytes to the front to make room for new data.
+    std::copy(bufferBegin_, bufferEnd_, buffer_.get());
+    bufferBegin_ = buffer_.get();
+
+    while (available < count && !isInputExhausted_) {
+        const std::size_t wanted{ bufferCapacity - available };
+        const std::size_t numRead{ input_->read(&buffer_[available], wanted) };
+        isInputExhausted_ = numRead < wanted;
+        inputOffset_ += numRead;
+        available += numRead;
+    }
+    bufferEnd_ = bufferBegin_ + available;
+    return available;
+}
+
 OggPage OggPhysicalStreamIn::readPage() {
+    OggPage::Params params{};
+    const uint32_t headerChecksum{ framePage(params) };
+    verifyPage(params, headerChecksum);
+    return OggPage(std::move(params));
+}
+
+uint32_t OggPhysicalStreamIn::framePage(OggPage::Params& params) {
     uint8_t headerData[23];
-    oggAssert(input_->read(headerData, 23) == 23, "Unexpected End Of File", OggStreamError::Cause::UnexpectedEOF);
+    oggAssert(fillBuffer(23) >= 23, "Unexpected End Of File", OggStreamError::Cause::UnexpectedEOF);
+    std::copy_n(bufferBegin_, 23, headerData);
+    bufferBegin_ += 23;
 
-    OggPage::Params params{};
     params.streamStructureVersion = headerData[0];
     const uint8_t headerTypeFlag{ headerData[1] };
     params.isContinuedPacket = (headerTypeFlag & 0x01) != 0;
@@ -176,82 +658,684 @@ OggPage OggPhysicalStreamIn::readPage() {
 
     const uint8_t pageSegments = headerData[22];
 
-    uint8_t segmentTable[256];
     oggAssert(
-        input_->read(segmentTable, pageSegments) == pageSegments,
+        fillBuffer(pageSegments) >= pageSegments,
         "Unexpected End Of File", 
         OggStreamError::Cause::UnexpectedEOF
     );
+    const uint8_t* const segmentTable{ bufferBegin_ };
     checksum = oggCRC(segmentTable, pageSegments, checksum);
+    params.numSegments = pageSegments;
+    std::copy_n(segmentTable, pageSegments, params.segmentTable.begin());
 
     std::size_t dataSize{ 0 };
     for (std::size_t i{ 0 }; i < pageSegments; i++) {
         dataSize += segmentTable[i];
     }
+    bufferBegin_ += pageSegments;
     params.dataSize = dataSize;
-    params.data = std::unique_ptr<uint8_t[]>{ new uint8_t[dataSize] };
 
-#define BLOCK_SIZE 0x2000
-    const auto eof = std::basic_istream<uint8_t>::traits_type::eof();
-    const std::size_t strip{ dataSize % BLOCK_SIZE };
-    for (std::size_t i{ 0 }; i < dataSize - strip; i += BLOCK_SIZE) {
+    if (isMapped_) {
         oggAssert(
-            input_->read(&params.data[i], BLOCK_SIZE) == BLOCK_SIZE,
+            std::size_t(bufferEnd_ - bufferBegin_) >= dataSize,
             "Unexpected End Of File",
             OggStreamError::Cause::UnexpectedEOF
         );
-        checksum = oggCRC(&params.data[i], BLOCK_SIZE, checksum);
+        params.data = OggPage::DataPtr{ bufferBegin_, OggPage::DataDeleter{ false } };
+        bufferBegin_ += dataSize;
     }
-    oggAssert(
-        input_->read(&params.data[dataSize - strip], strip) == int(strip),
-        "Unexpected End Of File",
-        OggStreamError::Cause::UnexpectedEOF
-    );
+    else {
+        uint8_t* const data{ pagePool_.acquire() };
+        OggPage::DataPtr pageData{ data, OggPage::DataDeleter{ pagePool_ } };
+
+        // Take what is already buffered, then read the rest directly into the page.
+        const std::size_t numBuffered{ std::min(dataSize, std::size_t(bufferEnd_ - bufferBegin_)) };
+        std::copy_n(bufferBegin_, numBuffered, data);
+        bufferBegin_ += numBuffered;
+        const std::size_t numRemaining{ dataSize - numBuffered };
+        if (numRemaining > 0) {
+            oggAssert(
+                !isInputExhausted_ && input_->read(&data[numBuffered], numRemaining) == numRemaining,
+                "Unexpected End Of File",
+                OggStreamError::Cause::UnexpectedEOF
+            );
+            inputOffset_ += numRemaining;
+
+            // The buffer is empty now, keep it aligned with inputOffset_ for seekInput().
+            bufferBegin_ = buffer_.get();
+            bufferEnd_ = buffer_.get();
+        }
 
-    checksum = oggCRC(&params.data[dataSize - strip], strip, checksum);
-#undef BLOCK_SIZE
+        params.data = std::move(pageData);
+    }
+    return checksum;
+}
 
+void OggPhysicalStreamIn::verifyPage(const OggPage::Params& params, const uint32_t headerChecksum) {
+    const uint32_t checksum{ oggCRC(params.data.get(), params.dataSize, headerChecksum) };
     oggAssert(checksum == params.pageChecksum, "Bad checksum.", OggStreamError::Cause::BadChecksum);
+}
 
-    return OggPage(std::move(params));
+/**
+* Returns a pointer to the first occurance of the capture pattern in [begin, end),
+* or nullptr if there is none.
+*/
+static const uint8_t* findCapturePattern(const uint8_t* begin, const uint8_t* const end) {
+    const std::size_t capturePatternLength{ sizeof(capturePattern) / sizeof(uint8_t) };
+
+#if defined(__SSE2__) || defined(_M_X64)
+    // Compare 16 candidate positions at once against all four bytes of the pattern.
+    const __m128i first{ _mm_set1_epi8(char(capturePattern[0])) };
+    const __m128i second{ _mm_set1_epi8(char(capturePattern[1])) };
+    const __m128i fourth{ _mm_set1_epi8(char(capturePattern[3])) };
+    for (; end - begin >= 16 + 3; begin += 16) {
+        const __m128i match{ _mm_and_si128(
+            _mm_and_si128(
+                _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)), first),
+                _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 1)), second)),
+            _mm_and_si128(
+                _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 2)), second),
+                _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 3)), fourth))) };
+        const int mask{ _mm_movemask_epi8(match) };
+        if (mask != 0) {
+            int offset{ 0 };
+            while (((mask >> offset) & 1) == 0) {
+                offset++;
+            }
+            return begin + offset;
+        }
+    }
+#endif
+
+    while (std::size_t(end - begin) >= capturePatternLength) {
+        const void* const candidate{ std::memchr(begin, capturePattern[0], end - begin - (capturePatternLength - 1)) };
+        if (candidate == nullptr) {
+            return nullptr;
+        }
+        begin = static_cast<const uint8_t*>(candidate);
+        if (std::equal(capturePattern, capturePattern + capturePatternLength, begin)) {
+            return begin;
+        }
+        begin++;
+    }
+    return nullptr;
+}
+
+bool OggPhysicalStreamIn::resync() {
+    return resync(numSkippedBytes_);
 }
 
-void OggPhysicalStreamIn::resync() {
-    std::size_t matches{ 0 };
-    std::size_t capturePatternLength = sizeof(capturePattern) / sizeof(uint8_t);
-    while (matches < capturePatternLength && !input_->eof()) {
-        const uint8_t c{ input_->read() };
-        if (capturePattern[matches] == c) {
-            matches++;
+bool OggPhysicalStreamIn::resync(uint64_t& numSkippedBytes) {
+    const std::size_t capturePatternLength{ sizeof(capturePattern) / sizeof(uint8_t) };
+    while (true) {
+        const std::size_t available{ fillBuffer(capturePatternLength) };
+        if (available < capturePatternLength) {
+            numSkippedBytes += available;
+            bufferBegin_ = bufferEnd_;
+            return false;
         }
-        else if (capturePattern[0] == c) {
-            matches = 1;
+
+        const uint8_t* const match{ findCapturePattern(bufferBegin_, bufferEnd_) };
+        if (match != nullptr) {
+            numSkippedBytes += match - bufferBegin_;
+            bufferBegin_ = match + capturePatternLength;
+            return true;
+        }
+
+        // The last bytes might be the beginning of a capture pattern, so keep them.
+        const std::size_t numDiscarded{ available - (capturePatternLength - 1) };
+        numSkippedBytes += numDiscarded;
+        bufferBegin_ += numDiscarded;
+    }
+}
+
+uint64_t OggPhysicalStreamIn::tell() const {
+    return inputOffset_ - uint64_t(bufferEnd_ - bufferBegin_);
+}
+
+void OggPhysicalStreamIn::seekInput(const uint64_t offset) {
+    if (isMapped_) {
+        bufferBegin_ = mappedBegin_ + std::min(offset, inputOffset_);
+        return;
+    }
+
+    const uint64_t bufferOffset{ inputOffset_ - uint64_t(bufferEnd_ - buffer_.get()) };
+    if (offset >= bufferOffset && offset <= inputOffset_) {
+        bufferBegin_ = buffer_.get() + (offset - bufferOffset);
+        return;
+    }
+
+    input_->seek(offset);
+    inputOffset_ = offset;
+    bufferBegin_ = buffer_.get();
+    bufferEnd_ = buffer_.get();
+    isInputExhausted_ = false;
+}
+
+std::optional<OggPhysicalStreamIn::PageHeader> OggPhysicalStreamIn::nextPageHeader(const uint64_t end) {
+    const std::size_t capturePatternLength{ sizeof(capturePattern) / sizeof(uint8_t) };
+    while (resync()) {
+        const uint64_t offset{ tell() - capturePatternLength };
+        if (offset >= end || fillBuffer(23) < 23) {
+            break;
+        }
+
+        // Without the checksum, the version and flags are the only hints for a false capture pattern.
+        if (bufferBegin_[0] != 0 || bufferBegin_[1] > 0x07) {
+            continue;
+        }
+
+        const std::size_t headerSize{ std::size_t(23) + bufferBegin_[22] };
+        if (fillBuffer(headerSize) < headerSize) {
+            break;
+        }
+
+        uint64_t size{ capturePatternLength + headerSize };
+        for (std::size_t i{ 23 }; i < headerSize; i++) {
+            size += bufferBegin_[i];
+        }
+        const PageHeader header{
+            offset,
+            size,
+            int64_t(readUInt64LE(&bufferBegin_[2])),
+            readUInt32LE(&bufferBegin_[10])
+        };
+        seekInput(offset + size);
+        return header;
+    }
+    return std::optional<PageHeader>{};
+}
+
+bool OggPhysicalStreamIn::isPageIntact(const PageHeader& header) {
+    const std::size_t capturePatternLength{ sizeof(capturePattern) / sizeof(uint8_t) };
+
+    // A page is at most 65307 bytes, so it always fits into the read-ahead buffer.
+    seekInput(header.offset);
+    bool isIntact{ false };
+    if (fillBuffer(std::size_t(header.size)) >= header.size) {
+        // The checksum field counts as zero. It is at offset 22, counting the capture pattern.
+        const uint8_t* const page{ bufferBegin_ };
+        const uint8_t zeros[4]{};
+        uint32_t checksum{ oggCRC(page, 22) };
+        checksum = oggCRC(zeros, 4, checksum);
+        checksum = oggCRC(page + 26, std::size_t(header.size) - 26, checksum);
+        isIntact = checksum == readUInt32LE(page + 22);
+    }
+    seekInput(header.offset + (isIntact ? header.size : capturePatternLength));
+    return isIntact;
+}
+
+bool OggPhysicalStreamIn::seekToGranule(const uint32_t streamSerialNumber, const int64_t granulePosition) {
+    oggAssert(isMapped_ || input_->isSeekable(), "Input is not seekable.", OggStreamError::Cause::IOError);
+    return seekToGranule(streamSerialNumber, granulePosition, 0, isMapped_ ? inputOffset_ : input_->size());
+}
+
+bool OggPhysicalStreamIn::seekToGranule(
+    const uint32_t streamSerialNumber, 
+    const int64_t granulePosition, 
+    const uint64_t begin, 
+    const uint64_t end) {
+    oggAssert(isMapped_ || input_->isSeekable(), "Input is not seekable.", OggStreamError::Cause::IOError);
+
+    currentStream_ = nullptr;
+    currentPage_.reset();
+
+    // Bytes passed over while seeking are not part of the stream's damage.
+    const uint64_t numSkippedBytes{ numSkippedBytes_ };
+
+    // A capture pattern within packet data can look like a page header, so the granule 
+    // position of a matching page is only trusted if its checksum is correct.
+    const auto isMatch{ [=](const PageHeader& header) {
+        return header.streamSerialNumber == streamSerialNumber 
+            && header.granulePosition != -1 
+            && isPageIntact(header);
+    } };
+
+    // The target page begins at or after rangeBegin. It either begins before rangeEnd, 
+    // or it is the page at candidate.
+    uint64_t rangeBegin{ begin };
+    uint64_t rangeEnd{ end };
+    std::optional<uint64_t> candidate;
+    while (rangeBegin < rangeEnd && rangeEnd - rangeBegin > seekScanThreshold) {
+        const uint64_t middle{ rangeBegin + (rangeEnd - rangeBegin) / 2 };
+        seekInput(middle);
+
+        std::optional<PageHeader> header{ nextPageHeader(rangeEnd) };
+        while (header && !isMatch(*header)) {
+            header = nextPageHeader(rangeEnd);
+        }
+
+        if (header && header->granulePosition < granulePosition) {
+            rangeBegin = header->offset + header->size;
         }
         else {
-            matches = 0;
+            if (header) {
+                candidate = header->offset;
+            }
+            rangeEnd = middle;
+        }
+    }
+
+    std::optional<uint64_t> target;
+    seekInput(rangeBegin);
+    while (std::optional<PageHeader> header{ nextPageHeader(rangeEnd) }) {
+        if (header->granulePosition >= granulePosition && isMatch(*header)) {
+            target = header->offset;
+            break;
+        }
+    }
+    if (!target) {
+        target = candidate;
+    }
+
+    for (auto& logicalStream : logicalStreams_) {
+        logicalStream.second.resetPosition();
+    }
+    numSkippedBytes_ = numSkippedBytes;
+    hasSeeked_ = true;
+
+    if (!target) {
+        seekInput(isMapped_ ? inputOffset_ : input_->size());
+        return false;
+    }
+    seekInput(*target);
+    return true;
+}
+
+OggLogicalStreamIn& OggPhysicalStreamIn::getLogicalStream(const uint32_t streamSerialNumber, const bool invokeCallbacks) {
+    auto logicalStreamIt{ logicalStreams_.find(streamSerialNumber) };
+    if (logicalStreamIt != logicalStreams_.end()) {
+        return logicalStreamIt->second;
+    }
+
+    logicalStreams_.emplace(streamSerialNumber, OggLogicalStreamIn(streamSerialNumber));
+    OggLogicalStreamIn& newStream{ logicalStreams_.find(streamSerialNumber)->second };
+    if (hasSeeked_) {
+        newStream.resetPosition();
+    }
+    if (invokeCallbacks) {
+        for (std::shared_ptr<NewStreamCallback>& callback : newStreamCallbacks_) {
+            callback->onNewStream(newStream);
         }
     }
+    return newStream;
 }
 
 void OggPhysicalStreamIn::process() {
-    resync();
-    while (!input_->eof()) {
+    currentStream_ = nullptr;
+    currentPage_.reset();
+
+    while (resync()) {
+        pageOffset_ = tell() - sizeof(capturePattern);
         const OggPage page{ readPage() };
+        getLogicalStream(page.streamSerialNumber, true).processPage(page);
+    }
+}
 
-        auto logicalStreamIt{ logicalStreams_.find(page.streamSerialNumber) };
-        if (logicalStreamIt != logicalStreams_.end()) {
-            logicalStreamIt->second.processPage(page);
+void OggPhysicalStreamIn::processBufferedPages(std::exception_ptr& error) {
+    const std::size_t capturePatternLength{ sizeof(capturePattern) / sizeof(uint8_t) };
+    while (true) {
+        const uint8_t* const match{ findCapturePattern(bufferBegin_, bufferEnd_) };
+        if (match == nullptr) {
+            // The last bytes might be the beginning of a capture pattern, so keep them.
+            const std::size_t available{ std::size_t(bufferEnd_ - bufferBegin_) };
+            if (available >= capturePatternLength) {
+                numSkippedBytes_ += available - (capturePatternLength - 1);
+                bufferBegin_ = bufferEnd_ - (capturePatternLength - 1);
+            }
+            return;
         }
-        else {
-            logicalStreams_.emplace(page.streamSerialNumber, OggLogicalStreamIn(page.streamSerialNumber));
-            OggLogicalStreamIn& newStream{ logicalStreams_.find(page.streamSerialNumber)->second };
-            for (std::shared_ptr<NewStreamCallback>& callback : newStreamCallbacks_) {
-                callback->onNewStream(newStream);
+        numSkippedBytes_ += match - bufferBegin_;
+        bufferBegin_ = match;
+
+        // readPage() must find the whole page in the buffer, because there is nothing to read.
+        const std::size_t available{ std::size_t(bufferEnd_ - bufferBegin_) };
+        if (available < 27) {
+            return;
+        }
+        const std::size_t headerSize{ std::size_t(27) + bufferBegin_[26] };
+        if (available < headerSize) {
+            return;
+        }
+        std::size_t pageSize{ headerSize };
+        for (std::size_t i{ 27 }; i < headerSize; i++) {
+            pageSize += bufferBegin_[i];
+        }
+        if (available < pageSize) {
+            return;
+        }
+
+        pageOffset_ = tell();
+        bufferBegin_ += capturePatternLength;
+        try {
+            const OggPage page{ readPage() };
+            getLogicalStream(page.streamSerialNumber, true).processPage(page);
+        }
+        catch (const OggStreamError&) {
+            if (!error) {
+                error = std::current_exception();
             }
-            newStream.processPage(page);
         }
+    }
+}
+
+void OggPhysicalStreamIn::feed(const uint8_t* const data, const std::size_t size) {
+    oggAssert(isFed_, "Only streams without an input can be fed.", OggStreamError::Cause::Other);
+
+    std::exception_ptr error;
+    std::size_t numConsumed{ 0 };
+    while (numConsumed < size) {
+        // An incomplete page is always smaller than the buffer, so there is room after moving it to the front.
+        uint8_t* const bufferStorageEnd{ buffer_.get() + bufferCapacity };
+        if (bufferBegin_ != buffer_.get() && std::size_t(bufferStorageEnd - bufferEnd_) < size - numConsumed) {
+            const std::size_t available{ std::size_t(bufferEnd_ - bufferBegin_) };
+            std::copy(bufferBegin_, bufferEnd_, buffer_.get());
+            bufferBegin_ = buffer_.get();
+            bufferEnd_ = buffer_.get() + available;
+        }
+
+        const std::size_t numTaken{ std::min(size - numConsumed, std::size_t(bufferStorageEnd - bufferEnd_)) };
+        std::copy_n(&data[numConsumed], numTaken, buffer_.get() + (bufferEnd_ - buffer_.get()));
+        bufferEnd_ += numTaken;
+        inputOffset_ += numTaken;
+        numConsumed += numTaken;
 
-        resync();
+        processBufferedPages(error);
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+* Pages travel through a ring of slots: the reader frames them, the workers verify 
+* them and the calling thread delivers them in order. A slot is only accessed by the 
+* thread that currently owns it, which is determined by the counters.
+*/
+struct OggPhysicalStreamIn::Pipeline {
+    struct Slot {
+        OggPage::Params params;
+        uint32_t headerChecksum;
+        bool isVerified;
+        std::exception_ptr error;
+
+        // Values of pageOffset_ and numSkippedBytes_ for this page, which the calling 
+        // thread takes over when it delivers the page.
+        uint64_t pageOffset;
+        uint64_t numSkippedBytes;
+    };
+
+    const std::size_t depth;
+    const std::unique_ptr<Slot[]> slots;
+
+    std::mutex lock;
+    std::condition_variable pageFramed;
+    std::condition_variable pageVerified;
+    std::condition_variable pageDelivered;
+
+    // Number of pages that were framed, claimed by a worker and delivered so far.
+    uint64_t numFramed;
+    uint64_t numClaimed;
+    uint64_t numDelivered;
+
+    bool isInputDone;
+    std::exception_ptr inputError;
+    bool isStopping;
+
+    // Skipped bytes counted by the reader, including those after the last page.
+    uint64_t numSkippedBytes;
+
+    explicit Pipeline(const std::size_t depth) 
+        : depth{ std::max(depth, std::size_t(1)) },
+          slots{ new Slot[this->depth] },
+          numFramed{ 0 },
+          numClaimed{ 0 },
+          numDelivered{ 0 },
+          isInputDone{ false },
+          isStopping{ false },
+          numSkippedBytes{ 0 } {}
+
+    void read(OggPhysicalStreamIn& in) {
+        uint64_t numSkippedBytesRead{ in.numSkippedBytes_ };
+        try {
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> guard{ lock };
+                    pageDelivered.wait(guard, [this] { return isStopping || numFramed - numDelivered < depth; });
+                    if (isStopping) {
+                        break;
+                    }
+                }
+
+                if (!in.resync(numSkippedBytesRead)) {
+                    break;
+                }
+
+                Slot& slot{ slots[numFramed % depth] };
+                slot.pageOffset = in.tell() - sizeof(capturePattern);
+                slot.numSkippedBytes = numSkippedBytesRead;
+                slot.headerChecksum = in.framePage(slot.params);
+                slot.isVerified = false;
+                slot.error = nullptr;
+                {
+                    std::lock_guard<std::mutex> guard{ lock };
+                    numFramed++;
+                }
+                pageFramed.notify_one();
+            }
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> guard{ lock };
+            inputError = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard{ lock };
+            isInputDone = true;
+            numSkippedBytes = numSkippedBytesRead;
+        }
+        pageFramed.notify_all();
+        pageVerified.notify_all();
+    }
+
+    void verify() {
+        std::unique_lock<std::mutex> guard{ lock };
+        while (true) {
+            pageFramed.wait(guard, [this] { return isStopping || isInputDone || numClaimed < numFramed; });
+            if (isStopping || numClaimed == numFramed) {
+                return;
+            }
+
+            Slot& slot{ slots[numClaimed % depth] };
+            numClaimed++;
+            guard.unlock();
+            try {
+                verifyPage(slot.params, slot.headerChecksum);
+            }
+            catch (...) {
+                slot.error = std::current_exception();
+            }
+            guard.lock();
+            slot.isVerified = true;
+            pageVerified.notify_all();
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> guard{ lock };
+            isStopping = true;
+        }
+        pageFramed.notify_all();
+        pageVerified.notify_all();
+        pageDelivered.notify_all();
+    }
+};
+
+void OggPhysicalStreamIn::processPipelined(const unsigned int numWorkers, const std::size_t queueDepth) {
+    if (numWorkers == 0) {
+        process();
+        return;
+    }
+
+    currentStream_ = nullptr;
+    currentPage_.reset();
+
+    Pipeline pipeline{ queueDepth };
+    std::vector<std::thread> threads;
+    const auto joinThreads{ [&]() {
+        pipeline.stop();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    } };
+
+    try {
+        threads.emplace_back([&]() { pipeline.read(*this); });
+        for (unsigned int i{ 0 }; i < numWorkers; i++) {
+            threads.emplace_back([&]() { pipeline.verify(); });
+        }
+
+        while (true) {
+            std::unique_lock<std::mutex> guard{ pipeline.lock };
+            pipeline.pageVerified.wait(guard, [&]() {
+                return pipeline.numDelivered < pipeline.numFramed 
+                    ? pipeline.slots[pipeline.numDelivered % pipeline.depth].isVerified 
+                    : pipeline.isInputDone;
+            });
+            if (pipeline.numDelivered == pipeline.numFramed) {
+                numSkippedBytes_ = pipeline.numSkippedBytes;
+                if (pipeline.inputError) {
+                    std::rethrow_exception(pipeline.inputError);
+                }
+                break;
+            }
+            Pipeline::Slot& slot{ pipeline.slots[pipeline.numDelivered % pipeline.depth] };
+            guard.unlock();
+
+            // The callbacks see the offset and the skipped bytes of the delivered page, 
+            // like under process(), rather than those of the reader.
+            pageOffset_ = slot.pageOffset;
+            numSkippedBytes_ = slot.numSkippedBytes;
+            if (slot.error) {
+                std::rethrow_exception(slot.error);
+            }
+            {
+                const OggPage page{ std::move(slot.params) };
+                getLogicalStream(page.streamSerialNumber, true).processPage(page);
+            }
+
+            guard.lock();
+            pipeline.numDelivered++;
+            guard.unlock();
+            pipeline.pageDelivered.notify_one();
+        }
+    }
+    catch (...) {
+        joinThreads();
+        throw;
+    }
+    joinThreads();
+}
+
+struct OggPhysicalStreamIn::StreamWorker {
+    SpscQueue<OggPage> queue;
+    std::exception_ptr error;
+    std::thread thread;
+
+    explicit StreamWorker(const std::size_t queueCapacity) : queue{ queueCapacity } {}
+
+    void run(OggLogicalStreamIn& stream) {
+        try {
+            while (const std::optional<OggPage> page{ queue.pop() }) {
+                stream.processPage(*page);
+            }
+        }
+        catch (...) {
+            // Closing the queue tells the reading thread that this worker stopped.
+            error = std::current_exception();
+            queue.close();
+        }
+    }
+};
+
+void OggPhysicalStreamIn::processConcurrently(const std::size_t queueCapacity) {
+    currentStream_ = nullptr;
+    currentPage_.reset();
+
+    std::unordered_map<uint32_t, std::unique_ptr<StreamWorker>> workers;
+    std::exception_ptr error;
+    try {
+        while (resync()) {
+            pageOffset_ = tell() - sizeof(capturePattern);
+            OggPage page{ readPage() };
+
+            std::unique_ptr<StreamWorker>& worker{ workers[page.streamSerialNumber] };
+            if (!worker) {
+                OggLogicalStreamIn& stream{ getLogicalStream(page.streamSerialNumber, true) };
+                worker = std::make_unique<StreamWorker>(queueCapacity);
+                StreamWorker* const newWorker{ worker.get() };
+                worker->thread = std::thread{ [newWorker, &stream]() { newWorker->run(stream); } };
+            }
+            if (!worker->queue.push(std::move(page))) {
+                break;
+            }
+        }
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+
+    // Let every worker finish its queued pages.
+    for (auto& worker : workers) {
+        worker.second->queue.close();
+    }
+    for (auto& worker : workers) {
+        if (worker.second->thread.joinable()) {
+            worker.second->thread.join();
+        }
+        if (!error && worker.second->error) {
+            error = worker.second->error;
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+std::optional<OggPage> OggPhysicalStreamIn::nextPage() {
+    currentStream_ = nullptr;
+    currentPage_.reset();
+
+    if (!resync()) {
+        return std::optional<OggPage>{};
+    }
+    pageOffset_ = tell() - sizeof(capturePattern);
+    return std::optional<OggPage>{ readPage() };
+}
+
+std::optional<OggPacket> OggPhysicalStreamIn::nextPacket() {
+    while (true) {
+        if (currentStream_ != nullptr) {
+            const std::optional<OggLogicalStreamIn::PacketView> packet{ currentStream_->nextPacket() };
+            if (packet) {
+                return OggPacket{ packet->data, packet->size, currentPage_->streamSerialNumber, packet->meta };
+            }
+            currentStream_ = nullptr;
+        }
+
+        currentPage_.reset();
+        if (!resync()) {
+            return std::optional<OggPacket>{};
+        }
+        pageOffset_ = tell() - sizeof(capturePattern);
+        currentPage_.emplace(readPage());
+
+        OggLogicalStreamIn& stream{ getLogicalStream(currentPage_->streamSerialNumber, false) };
+        const unsigned int numSkippedPages{ stream.updatePageSequence(*currentPage_) };
+        stream.beginPacketExtraction(*currentPage_, numSkippedPages);
+        currentStream_ = &stream;
     }
 }
 
@@ -259,13 +1343,41 @@ void OggPhysicalStreamIn::process() {
 //            OggLogicalStreamOut
 //----------------------------------------------
 
+/**
+* Queue between a muxed OggLogicalStreamOut and the muxer thread of its physical stream.
+*/
+struct OggLogicalStreamOut::MuxerStream {
+    struct Page {
+        std::vector<uint8_t> data;
+        double time;
+    };
+
+    SpscQueue<Page> queue;
+
+    // Only used by the muxer thread.
+    std::optional<Page> head;
+    bool isFinished;
+
+    explicit MuxerStream(const std::size_t queueCapacity) : queue{ queueCapacity }, isFinished{ false } {}
+};
+
 OggLogicalStreamOut::OggLogicalStreamOut(OggPhysicalStreamOut& sink, const uint32_t streamSerialNumber) :
     sink_{ sink },
     streamSerialNumber_{ streamSerialNumber },
     pageSequenceNumber_{ 0 },
     isPacketOpen_{ false },
     isStreamOpen_{ true },
-    isFirstWrite_{ true } {}
+    isFirstWrite_{ true },
+    targetPageSize_{ 0 },
+    maxGranuleSpan_{ -1 },
+    pendingSegmentTable_{},
+    pendingNumSegments_{ 0 },
+    pendingUnlacedSize_{ 0 },
+    isPendingContinued_{ false },
+    pendingFirstGranulePosition_{ -1 },
+    pendingGranulePosition_{ -1 },
+    hasPendingGranulePosition_{ false },
+    lastPageTime_{ -std::numeric_limits<double>::infinity() } {}
 
 OggLogicalStreamOut::OggLogicalStreamOut(OggLogicalStreamOut&& other) noexcept
     : sink_{ other.sink_ },
@@ -273,105 +1385,472 @@ OggLogicalStreamOut::OggLogicalStreamOut(OggLogicalStreamOut&& other) noexcept
       pageSequenceNumber_{ std::move(other.pageSequenceNumber_) },
       isPacketOpen_{ std::move(other.isPacketOpen_) },
       isStreamOpen_{ std::move(other.isStreamOpen_) },
-      isFirstWrite_{ std::move(other.isFirstWrite_) } {}
+      isFirstWrite_{ std::move(other.isFirstWrite_) },
+      targetPageSize_{ other.targetPageSize_ },
+      maxGranuleSpan_{ other.maxGranuleSpan_ },
+      pendingData_{ std::move(other.pendingData_) },
+      pendingSegmentTable_{ other.pendingSegmentTable_ },
+      pendingNumSegments_{ other.pendingNumSegments_ },
+      pendingUnlacedSize_{ other.pendingUnlacedSize_ },
+      isPendingContinued_{ other.isPendingContinued_ },
+      pendingFirstGranulePosition_{ other.pendingFirstGranulePosition_ },
+      pendingGranulePosition_{ other.pendingGranulePosition_ },
+      hasPendingGranulePosition_{ other.hasPendingGranulePosition_ },
+      muxerStream_{ std::move(other.muxerStream_) },
+      timeMapping_{ std::move(other.timeMapping_) },
+      lastPageTime_{ other.lastPageTime_ } {
+    // The moved-from stream must not write the pending page again.
+    other.pendingData_.clear();
+    other.pendingNumSegments_ = 0;
+    other.pendingUnlacedSize_ = 0;
+}
 
-void OggLogicalStreamOut::writePage(
-        const uint8_t* const data,
+OggLogicalStreamOut::~OggLogicalStreamOut() {
+    try {
+        flush();
+    }
+    catch (...) {
+        // Destructors must not throw. Call flush() explicitly to see errors.
+    }
+    if (muxerStream_ != nullptr) {
+        muxerStream_->queue.close();
+    }
+}
+
+void OggLogicalStreamOut::addPage(
+        const OggFragment* const fragments,
+        const std::size_t numFragments,
         const unsigned int size,
+        const uint8_t* const segmentTable,
+        const uint8_t numSegments,
         const int64_t granulePosition,
-        const bool closePacket,
+        const bool isContinuedPacket,
         const bool closeStream) {
-    if (!isStreamOpen_) {
-        throw OggStreamError(OggStreamError::Cause::StreamClosed, "Attempting to write to a closed stream.");
-    }
-    if (size > maxPageSize) {
-        throw OggStreamError(OggStreamError::Cause::Other, "Too much data for a single page.");
+    // The payload does not depend on the header, so its checksum is calculated
+    // independently and combined with the header checksum afterwards.
+    uint32_t dataChecksum{ 0 };
+    for (std::size_t i{ 0 }; i < numFragments; i++) {
+        dataChecksum = oggCRC(fragments[i].data, fragments[i].size, dataChecksum);
     }
 
     uint32_t checksum{ oggCRC(capturePattern, 4) };
 
     uint8_t headerData[23];
     headerData[0] = 0; // stream_structure_version
-    uint8_t headerTypeFlag{ uint8_t((isPacketOpen_ ? 0x1 : 0) + (isFirstWrite_ ? 0x2 : 0) + (closeStream ? 0x4 : 0)) };
+    uint8_t headerTypeFlag{ uint8_t((isContinuedPacket ? 0x1 : 0) + (isFirstWrite_ ? 0x2 : 0) + (closeStream ? 0x4 : 0)) };
     headerData[1] = headerTypeFlag;
     writeUInt64LE(&headerData[2], granulePosition);
     writeUInt32LE(&headerData[10], streamSerialNumber_);
     writeUInt32LE(&headerData[14], pageSequenceNumber_);
     writeUInt32LE(&headerData[18], 0); // checksum
-    const uint8_t pageSegments{ uint8_t((size + 254) / 255) };
-    headerData[22] = pageSegments;
+    headerData[22] = numSegments;
     checksum = oggCRC(headerData, 23, checksum);
+    checksum = oggCRC(segmentTable, numSegments, checksum);
+
+    checksum = oggCRC.combine(checksum, dataChecksum, size);
 
-    uint8_t segmentTable[256];
-    if (pageSegments > 0) {
-        for (std::size_t i = 0; i < pageSegments - 1; i++) {
-            segmentTable[i] = 255;
+    writeUInt32LE(&headerData[18], checksum);
+
+    batchHeaders_.insert(batchHeaders_.end(), capturePattern, capturePattern + 4);
+    batchHeaders_.insert(batchHeaders_.end(), headerData, headerData + 23);
+    batchHeaders_.insert(batchHeaders_.end(), segmentTable, segmentTable + numSegments);
+    batch_.push_back(OggFragment{ nullptr, std::size_t(27 + numSegments) });
+    for (std::size_t i{ 0 }; i < numFragments; i++) {
+        if (fragments[i].size > 0) {
+            batch_.push_back(fragments[i]);
         }
+    }
 
-        const uint8_t lastSegment{ size % 255 };
-        if (lastSegment == 0) {
-            segmentTable[pageSegments - 1] = 255;
+    pageSequenceNumber_++;
+    isFirstWrite_ = false;
+    if (closeStream) {
+        isStreamOpen_ = false;
+    }
+}
+
+void OggLogicalStreamOut::queueBatch() {
+    std::size_t headerOffset{ 0 };
+    std::size_t fragmentIndex{ 0 };
+    while (fragmentIndex < batch_.size()) {
+        // Every page consists of its header, followed by the fragments of its payload.
+        const uint8_t* const header{ &batchHeaders_[headerOffset] };
+        MuxerStream::Page page{};
+        page.data.insert(page.data.end(), header, header + batch_[fragmentIndex].size);
+        headerOffset += batch_[fragmentIndex].size;
+        for (fragmentIndex++; fragmentIndex < batch_.size() && batch_[fragmentIndex].data != nullptr; fragmentIndex++) {
+            const OggFragment& fragment{ batch_[fragmentIndex] };
+            page.data.insert(page.data.end(), fragment.data, fragment.data + fragment.size);
         }
-        else {
-            segmentTable[pageSegments - 1] = lastSegment;
+
+        const int64_t granulePosition{ int64_t(readUInt64LE(&header[6])) };
+        if (granulePosition != -1) {
+            lastPageTime_ = timeMapping_ ? timeMapping_(granulePosition) : double(granulePosition);
+        }
+        page.time = lastPageTime_;
+
+        const bool isLastPage{ (header[5] & 0x4) != 0 };
+        if (!muxerStream_->queue.push(std::move(page))) {
+            throw OggStreamError(OggStreamError::Cause::IOError, "The muxer stopped because writing failed.");
+        }
+        if (isLastPage) {
+            muxerStream_->queue.close();
         }
-        checksum = oggCRC(segmentTable, pageSegments, checksum);
     }
+}
 
-    checksum = oggCRC(data, size, checksum);
+void OggLogicalStreamOut::writeBatch() {
+    if (muxerStream_ != nullptr) {
+        try {
+            queueBatch();
+        }
+        catch (...) {
+            batch_.clear();
+            batchHeaders_.clear();
+            throw;
+        }
+        batch_.clear();
+        batchHeaders_.clear();
+        return;
+    }
 
-    writeUInt32LE(&headerData[18], checksum);
+    // The headers are only located now, because batchHeaders_ may have been reallocated.
+    std::size_t headerOffset{ 0 };
+    for (OggFragment& fragment : batch_) {
+        if (fragment.data == nullptr) {
+            fragment.data = &batchHeaders_[headerOffset];
+            headerOffset += fragment.size;
+        }
+    }
 
-    sink_.writeLock.lock();
-    sink_.output_->write(capturePattern, 4);
-    sink_.output_->write(headerData, 23);
-    sink_.output_->write(segmentTable, pageSegments);
-    sink_.output_->write(data, size);
-    sink_.writeLock.unlock();
+    try {
+        std::lock_guard<std::mutex> guard{ sink_.writeLock };
+        sink_.output_->write(batch_.data(), batch_.size());
+    }
+    catch (...) {
+        batch_.clear();
+        batchHeaders_.clear();
+        throw;
+    }
+    batch_.clear();
+    batchHeaders_.clear();
+}
 
-    pageSequenceNumber_++;
-    isFirstWrite_ = false;
+void OggLogicalStreamOut::writePage(
+        const uint8_t* const data,
+        const unsigned int size,
+        const int64_t granulePosition,
+        const bool closePacket,
+        const bool closeStream) {
+    const OggFragment fragment{ data, size };
+    addPage(&fragment, 1, size, granulePosition, closePacket, closeStream);
+    writeBatch();
+}
+
+void OggLogicalStreamOut::addPage(
+        const OggFragment* const fragments,
+        const std::size_t numFragments,
+        const unsigned int size,
+        const int64_t granulePosition,
+        const bool closePacket,
+        const bool closeStream) {
+    if (!isStreamOpen_) {
+        throw OggStreamError(OggStreamError::Cause::StreamClosed, "Attempting to write to a closed stream.");
+    }
+    // A packet ends with the first lacing value below 255, so closing a packet whose
+    // size is a multiple of 255 takes an additional lacing value of 0.
+    const unsigned int numSegments{ closePacket ? size / 255 + 1 : (size + 254) / 255 };
+    if (numSegments > 255) {
+        throw OggStreamError(OggStreamError::Cause::Other, "Too much data for a single page.");
+    }
+
+    uint8_t segmentTable[255];
+    const unsigned int numFullSegments{ size / 255 };
+    std::fill_n(segmentTable, numFullSegments, uint8_t(255));
+    if (numSegments > numFullSegments) {
+        segmentTable[numFullSegments] = uint8_t(size % 255);
+    }
+
+    addPage(fragments, numFragments, size, segmentTable, uint8_t(numSegments), granulePosition, isPacketOpen_, closeStream);
     isPacketOpen_ = !closePacket;
 }
 
+void OggLogicalStreamOut::writePendingPage(const bool closeStream) {
+    if (pendingNumSegments_ == 0 && !closeStream) {
+        return;
+    }
+
+    const std::size_t size{ pendingData_.size() - pendingUnlacedSize_ };
+    const OggFragment fragment{ pendingData_.data(), size };
+    addPage(
+        &fragment,
+        1,
+        unsigned(size),
+        pendingSegmentTable_.data(),
+        uint8_t(pendingNumSegments_),
+        hasPendingGranulePosition_ ? pendingGranulePosition_ : -1,
+        isPendingContinued_,
+        closeStream);
+    writeBatch();
+
+    // A last lacing value of 255 means that the packet continues on the next page.
+    isPendingContinued_ = pendingNumSegments_ > 0 && pendingSegmentTable_[pendingNumSegments_ - 1] == 255;
+    pendingData_.erase(pendingData_.begin(), pendingData_.begin() + size);
+    pendingNumSegments_ = 0;
+    hasPendingGranulePosition_ = false;
+}
+
+void OggLogicalStreamOut::writePacked(
+        const uint8_t* const data,
+        const unsigned int size,
+        const int64_t granulePosition,
+        const bool closePacket,
+        const bool closeStream) {
+    if (!isStreamOpen_) {
+        throw OggStreamError(OggStreamError::Cause::StreamClosed, "Attempting to write to a closed stream.");
+    }
+
+    std::size_t bytesWritten{ 0 };
+    while (true) {
+        // Take as much data as the remaining lacing values can describe.
+        const std::size_t capacity{ (255 - pendingNumSegments_) * std::size_t(255) - pendingUnlacedSize_ };
+        const std::size_t numTaken{ std::min(capacity, size - bytesWritten) };
+        pendingData_.insert(pendingData_.end(), data + bytesWritten, data + bytesWritten + numTaken);
+        pendingUnlacedSize_ += numTaken;
+        bytesWritten += numTaken;
+
+        while (pendingUnlacedSize_ >= 255) {
+            pendingSegmentTable_[pendingNumSegments_++] = 255;
+            pendingUnlacedSize_ -= 255;
+        }
+        if (bytesWritten == size) {
+            break;
+        }
+        writePendingPage(false);
+    }
+    isPacketOpen_ = !closePacket;
+
+    // Closing the stream laces the tail of an open packet as well, like addPage() does,
+    // so that it is not dropped from the last page.
+    if (closePacket || (closeStream && pendingUnlacedSize_ > 0)) {
+        // The packet needs one more lacing value to end.
+        if (pendingNumSegments_ == 255) {
+            writePendingPage(false);
+        }
+        pendingSegmentTable_[pendingNumSegments_++] = uint8_t(pendingUnlacedSize_);
+        pendingUnlacedSize_ = 0;
+
+        if (!hasPendingGranulePosition_) {
+            pendingFirstGranulePosition_ = granulePosition;
+            hasPendingGranulePosition_ = true;
+        }
+        pendingGranulePosition_ = granulePosition;
+    }
+
+    const bool isPageFull{ 
+        pendingData_.size() >= targetPageSize_ 
+        || (maxGranuleSpan_ >= 0 && hasPendingGranulePosition_ 
+            && pendingGranulePosition_ - pendingFirstGranulePosition_ >= maxGranuleSpan_) };
+    if (closeStream || (closePacket && isPageFull)) {
+        writePendingPage(closeStream);
+    }
+}
+
+void OggLogicalStreamOut::enablePacking(const unsigned int targetPageSize, const int64_t maxGranuleSpan) {
+    targetPageSize_ = std::max(targetPageSize, 1u);
+    maxGranuleSpan_ = maxGranuleSpan;
+}
+
+void OggLogicalStreamOut::flush() {
+    writePendingPage(false);
+}
+
+void OggLogicalStreamOut::setTimeMapping(std::function<double(const int64_t)> timeMapping) {
+    timeMapping_ = std::move(timeMapping);
+}
+
 void OggLogicalStreamOut::write(
         const uint8_t* const data,
         const unsigned int size,
         const int64_t granulePosition,
         const bool closePacket,
         const bool closeStream) {
-    const std::ldiv_t sizeDiv{ ldiv(size, maxPageSize) };
+    const OggFragment fragment{ data, size };
+    write(&fragment, 1, granulePosition, closePacket, closeStream);
+}
+
+void OggLogicalStreamOut::write(
+        const OggFragment* const fragments,
+        const std::size_t numFragments,
+        const int64_t granulePosition,
+        const bool closePacket,
+        const bool closeStream) {
+    if (targetPageSize_ > 0) {
+        for (std::size_t i{ 0 }; i + 1 < numFragments; i++) {
+            writePacked(fragments[i].data, unsigned(fragments[i].size), granulePosition, false, false);
+        }
+        const OggFragment last{ numFragments > 0 ? fragments[numFragments - 1] : OggFragment{ nullptr, 0 } };
+        writePacked(last.data, unsigned(last.size), granulePosition, closePacket, closeStream);
+        return;
+    }
+
+    std::size_t size{ 0 };
+    for (std::size_t i{ 0 }; i < numFragments; i++) {
+        size += fragments[i].size;
+    }
+
+    // The last page of a packet needs room for the terminating lacing value.
+    const unsigned int maxLastPageSize{ closePacket ? maxPageSize - 1 : maxPageSize };
+
+    // Splits the fragments at the page boundaries. The pieces of each page 
+    // refer to the original buffers, so nothing is copied.
+    std::size_t fragmentIndex{ 0 };
+    std::size_t fragmentOffset{ 0 };
+    const auto takePage = [&](const std::size_t pageSize) {
+        pageFragments_.clear();
+        std::size_t remaining{ pageSize };
+        while (remaining > 0) {
+            const OggFragment& fragment{ fragments[fragmentIndex] };
+            const std::size_t pieceSize{ std::min(remaining, fragment.size - fragmentOffset) };
+            pageFragments_.push_back(OggFragment{ fragment.data + fragmentOffset, pieceSize });
+            remaining -= pieceSize;
+            fragmentOffset += pieceSize;
+            if (fragmentOffset == fragment.size) {
+                fragmentIndex++;
+                fragmentOffset = 0;
+            }
+        }
+    };
 
     std::size_t bytesWritten{ 0 };
-    for (std::size_t i = 0; i < sizeDiv.quot; i++) {
-        writePage(&data[bytesWritten], maxPageSize, granulePosition, false, false);
+    while (size - bytesWritten > maxLastPageSize) {
+        takePage(maxPageSize);
+        addPage(pageFragments_.data(), pageFragments_.size(), maxPageSize, granulePosition, false, false);
         bytesWritten += maxPageSize;
     }
-    writePage(&data[bytesWritten], sizeDiv.rem, granulePosition, closePacket, closeStream);
+    takePage(size - bytesWritten);
+    addPage(pageFragments_.data(), pageFragments_.size(), unsigned(size - bytesWritten), granulePosition, closePacket, closeStream);
+    writeBatch();
 }
 
 //----------------------------------------------
 //            OggPhysicalStreamOut
 //----------------------------------------------
 
+void OggPhysicalStreamOut::GatheringOutput::flushBuffer() {
+    if (!buffer_.empty()) {
+        // The buffer is dropped even if the write fails, so that its bytes are not
+        // written again with the next fragments.
+        try {
+            writeContiguous(buffer_.data(), buffer_.size());
+        }
+        catch (...) {
+            buffer_.clear();
+            throw;
+        }
+        buffer_.clear();
+    }
+}
+
+void OggPhysicalStreamOut::GatheringOutput::write(const OggFragment* const fragments, const std::size_t numFragments) {
+    for (std::size_t i{ 0 }; i < numFragments; i++) {
+        const OggFragment& fragment{ fragments[i] };
+        if (buffer_.size() + fragment.size > bufferSize) {
+            flushBuffer();
+        }
+        if (fragment.size >= bufferSize) {
+            writeContiguous(fragment.data, fragment.size);
+        }
+        else {
+            buffer_.insert(buffer_.end(), fragment.data, fragment.data + fragment.size);
+        }
+    }
+    flushBuffer();
+}
+
 OggPhysicalStreamOut::FileOutput::FileOutput(FILE* file) : file_{ file } {}
 
-void OggPhysicalStreamOut::FileOutput::write(const uint8_t val) {
-    fputc(val, file_);
+void OggPhysicalStreamOut::FileOutput::writeContiguous(const uint8_t* buffer, const std::size_t count) {
+    if (fwrite(buffer, sizeof(uint8_t), count, file_) != count) {
+        throw OggStreamError(OggStreamError::Cause::IOError, "Failed to write to file.");
+    }
 }
 
-void OggPhysicalStreamOut::FileOutput::write(const uint8_t* buffer, const std::size_t count) {
-    fwrite(buffer, sizeof(uint8_t), count, file_);
+void OggPhysicalStreamOut::FileOutput::flush() {
+    if (fflush(file_) != 0) {
+        throw OggStreamError(OggStreamError::Cause::IOError, "Failed to flush file.");
+    }
 }
 
 OggPhysicalStreamOut::StreamOutput::StreamOutput(std::basic_ostream<uint8_t>& out) : out_{ out } {}
 
-void OggPhysicalStreamOut::StreamOutput::write(const uint8_t val) {
-    out_.put(val);
+void OggPhysicalStreamOut::StreamOutput::writeContiguous(const uint8_t* buffer, const std::size_t count) {
+    if (!out_.write(buffer, count)) {
+        throw OggStreamError(OggStreamError::Cause::IOError, "Failed to write to stream.");
+    }
+}
+
+void OggPhysicalStreamOut::StreamOutput::flush() {
+    if (!out_.flush()) {
+        throw OggStreamError(OggStreamError::Cause::IOError, "Failed to flush stream.");
+    }
+}
+
+OggPhysicalStreamOut::DescriptorOutput::DescriptorOutput(const int fileDescriptor) : fileDescriptor_{ fileDescriptor } {}
+
+#ifdef _WIN32
+
+void OggPhysicalStreamOut::DescriptorOutput::write(const OggFragment* const fragments, const std::size_t numFragments) {
+    for (std::size_t i{ 0 }; i < numFragments; i++) {
+        std::size_t bytesWritten{ 0 };
+        while (bytesWritten < fragments[i].size) {
+            const unsigned int count{ unsigned(std::min<std::size_t>(fragments[i].size - bytesWritten, 0x40000000)) };
+            const int result{ _write(fileDescriptor_, fragments[i].data + bytesWritten, count) };
+            if (result < 0) {
+                throw OggStreamError(OggStreamError::Cause::IOError, std::strerror(errno));
+            }
+            bytesWritten += std::size_t(result);
+        }
+    }
+}
+
+#else
+
+void OggPhysicalStreamOut::DescriptorOutput::write(const OggFragment* const fragments, const std::size_t numFragments) {
+    std::vector<iovec> vectors(std::min<std::size_t>(numFragments, IOV_MAX));
+    std::size_t fragmentIndex{ 0 };
+    std::size_t fragmentOffset{ 0 };
+    while (fragmentIndex < numFragments) {
+        std::size_t numVectors{ 0 };
+        for (std::size_t i{ fragmentIndex }; i < numFragments && numVectors < vectors.size(); i++) {
+            const std::size_t offset{ i == fragmentIndex ? fragmentOffset : 0 };
+            vectors[numVectors].iov_base = const_cast<uint8_t*>(fragments[i].data + offset);
+            vectors[numVectors].iov_len = fragments[i].size - offset;
+            numVectors++;
+        }
+
+        const ssize_t result{ writev(fileDescriptor_, vectors.data(), int(numVectors)) };
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw OggStreamError(OggStreamError::Cause::IOError, std::strerror(errno));
+        }
+
+        // Skip what was written. A short write continues in the middle of a fragment.
+        std::size_t bytesWritten{ std::size_t(result) };
+        while (fragmentIndex < numFragments && bytesWritten >= fragments[fragmentIndex].size - fragmentOffset) {
+            bytesWritten -= fragments[fragmentIndex].size - fragmentOffset;
+            fragmentIndex++;
+            fragmentOffset = 0;
+        }
+        fragmentOffset += bytesWritten;
+    }
 }
 
-void OggPhysicalStreamOut::StreamOutput::write(const uint8_t* buffer, const std::size_t count) {
-    out_.write(buffer, count);
+#endif
+
+void OggPhysicalStreamOut::DescriptorOutput::flush() {
+    // Data written with writev() is not buffered in user space.
 }
 
 OggPhysicalStreamOut::OggPhysicalStreamOut(FILE* file) 
@@ -380,6 +1859,128 @@ OggPhysicalStreamOut::OggPhysicalStreamOut(FILE* file)
 OggPhysicalStreamOut::OggPhysicalStreamOut(std::basic_ostream<uint8_t>& out) 
     : output_{ std::make_unique<StreamOutput>(out) } {}
 
+OggPhysicalStreamOut::OggPhysicalStreamOut(const int fileDescriptor) 
+    : output_{ std::make_unique<DescriptorOutput>(fileDescriptor) } {}
+
+OggPhysicalStreamOut::~OggPhysicalStreamOut() {
+    try {
+        finishMuxing();
+    }
+    catch (...) {
+        // Destructors must not throw. Call finishMuxing() explicitly to see errors.
+    }
+}
+
+void OggPhysicalStreamOut::flush() {
+    std::lock_guard<std::mutex> guard{ writeLock };
+    output_->flush();
+}
+
+struct OggPhysicalStreamOut::Muxer {
+    const std::size_t queueCapacity;
+
+    std::mutex lock;
+    std::condition_variable changed;
+
+    // Muxed streams that are not finished yet. New streams are added by newLogicalStream().
+    std::vector<std::shared_ptr<OggLogicalStreamOut::MuxerStream>> streams;
+    std::size_t numStreamsAdded;
+    bool isStopping;
+    std::exception_ptr error;
+
+    std::thread thread;
+
+    explicit Muxer(const std::size_t queueCapacity) : queueCapacity{ queueCapacity }, numStreamsAdded{ 0 }, isStopping{ false } {}
+};
+
+void OggPhysicalStreamOut::runMuxer() {
+    Muxer& muxer{ *muxer_ };
+    std::vector<std::shared_ptr<OggLogicalStreamOut::MuxerStream>> streams;
+    std::size_t numStreamsAdded{ 0 };
+    try {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard{ muxer.lock };
+                muxer.streams.erase(
+                    std::remove_if(muxer.streams.begin(), muxer.streams.end(), [](const auto& stream) { return stream->isFinished; }),
+                    muxer.streams.end());
+                muxer.changed.wait(guard, [&] { return !muxer.streams.empty() || muxer.isStopping; });
+                if (muxer.streams.empty()) {
+                    return;
+                }
+                streams = muxer.streams;
+                numStreamsAdded = muxer.numStreamsAdded;
+            }
+
+            // The earliest page is only known once every open stream has a page queued.
+            OggLogicalStreamOut::MuxerStream* earliest{ nullptr };
+            for (const auto& stream : streams) {
+                if (!stream->head) {
+                    stream->head = stream->queue.pop();
+                    if (!stream->head) {
+                        stream->isFinished = true;
+                        continue;
+                    }
+                }
+                if (earliest == nullptr || stream->head->time < earliest->head->time) {
+                    earliest = stream.get();
+                }
+            }
+
+            // A stream that was added while waiting for pages may have an earlier page.
+            {
+                std::lock_guard<std::mutex> guard{ muxer.lock };
+                if (muxer.numStreamsAdded != numStreamsAdded) {
+                    continue;
+                }
+            }
+
+            if (earliest != nullptr) {
+                const OggFragment fragment{ earliest->head->data.data(), earliest->head->data.size() };
+                std::lock_guard<std::mutex> guard{ writeLock };
+                output_->write(&fragment, 1);
+                earliest->head.reset();
+            }
+        }
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> guard{ muxer.lock };
+        muxer.error = std::current_exception();
+
+        // Closing the queues makes the writing threads fail instead of waiting for space.
+        for (const auto& stream : muxer.streams) {
+            stream->queue.close();
+        }
+        muxer.streams.clear();
+    }
+}
+
+void OggPhysicalStreamOut::startMuxing(const std::size_t queueCapacity) {
+    if (muxer_ != nullptr) {
+        return;
+    }
+    muxer_ = std::make_unique<Muxer>(queueCapacity);
+    muxer_->thread = std::thread{ &OggPhysicalStreamOut::runMuxer, this };
+}
+
+void OggPhysicalStreamOut::finishMuxing() {
+    if (muxer_ == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard{ muxer_->lock };
+        muxer_->isStopping = true;
+    }
+    muxer_->changed.notify_all();
+    muxer_->thread.join();
+
+    const std::exception_ptr error{ muxer_->error };
+    muxer_.reset();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
 static uint32_t lfsrNext(const uint32_t lfsr) {
     unsigned int bit{ (lfsr ^ (lfsr >> 1) ^ (lfsr >> 21) ^ (lfsr >> 31)) & 1 };
     return (lfsr << 1) + bit;
@@ -401,5 +2002,19 @@ std::optional<OggLogicalStreamOut> OggPhysicalStreamOut:: newLogicalStream(const
         return std::optional<OggLogicalStreamOut>{};
     }
     assignedSerialNums_.insert(streamSerialNumber);
-    return std::optional<OggLogicalStreamOut>{ OggLogicalStreamOut{ *this, streamSerialNumber } };
+    OggLogicalStreamOut stream{ *this, streamSerialNumber };
+
+    if (muxer_ != nullptr) {
+        stream.muxerStream_ = std::make_shared<OggLogicalStreamOut::MuxerStream>(muxer_->queueCapacity);
+        std::lock_guard<std::mutex> guard{ muxer_->lock };
+        if (muxer_->error) {
+            stream.muxerStream_->queue.close();
+        }
+        else {
+            muxer_->streams.push_back(stream.muxerStream_);
+            muxer_->numStreamsAdded++;
+            muxer_->changed.notify_all();
+        }
+    }
+    return std::optional<OggLogicalStreamOut>{ std::move(stream) };
 }
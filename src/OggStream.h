@@ -2,18 +2,22 @@
 #define VORBIS_CPP_H
 
 #include "util.h"
+#include "IoUring.h"
 
 #include <istream>
 #include <ostream>
 #include <stdexcept>
 #include <cstdint>
 #include <vector>
+#include <array>
 #include <unordered_map>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
 #include <set>
 #include <functional>
+#include <exception>
 
 namespace vcpp {
     class OggStreamError : public std::runtime_error {
@@ -38,12 +42,79 @@ namespace vcpp {
         }
     };
 
+    /**
+    * Recycles payload buffers for OggPages. Every buffer has room for the largest possible
+    * payload of a page. Memory is obtained from a std::pmr::memory_resource and returned
+    * to it when the pool is destroyed. All buffers must have been released by then.
+    */
+    class PageBufferPool {
+        std::pmr::memory_resource* const resource_;
+        const std::size_t maxFreeBuffers_;
+        std::vector<uint8_t*> freeBuffers_;
+        std::mutex lock_;
+
+    public:
+        // Size of each buffer, which is the maximum payload size of a page.
+        static constexpr std::size_t bufferSize = 255 * 255;
+
+        /**
+        * Constructs a PageBufferPool.
+        * 
+        * @param resource The memory resource to allocate buffers from.
+        * @param maxFreeBuffers Maximum number of unused buffers kept for reuse.
+        */
+        explicit PageBufferPool(
+            std::pmr::memory_resource* const resource = std::pmr::get_default_resource(),
+            const std::size_t maxFreeBuffers = 8);
+        ~PageBufferPool();
+
+        PageBufferPool(const PageBufferPool& other) = delete;
+        PageBufferPool& operator=(const PageBufferPool& other) = delete;
+
+        /**
+        * Returns a buffer of size bufferSize, reusing a released buffer if possible.
+        */
+        uint8_t* acquire();
+
+        /**
+        * Returns a buffer obtained from acquire() to the pool.
+        */
+        void release(const uint8_t* const buffer);
+    };
+
     /**
     * Read-only representation of a single page of an Ogg stream.
     */
     class OggPage {
     public:
 
+        /**
+        * Deleter for the payload of a page. The payload is either owned by the page, borrowed
+        * from a PageBufferPool, or it points into memory that is owned by the OggPhysicalStreamIn 
+        * the page was read from (e.g. a memory mapped file). In the latter two cases, the page 
+        * must not outlive the stream.
+        */
+        class DataDeleter {
+            PageBufferPool* pool_;
+            bool isOwned_;
+
+        public:
+            DataDeleter() : pool_{ nullptr }, isOwned_{ true } {}
+            explicit DataDeleter(const bool isOwned) : pool_{ nullptr }, isOwned_{ isOwned } {}
+            explicit DataDeleter(PageBufferPool& pool) : pool_{ &pool }, isOwned_{ true } {}
+
+            void operator()(const uint8_t* const data) const {
+                if (pool_ != nullptr) {
+                    pool_->release(data);
+                }
+                else if (isOwned_) {
+                    delete[] data;
+                }
+            }
+        };
+
+        using DataPtr = std::unique_ptr<const uint8_t[], DataDeleter>;
+
         /**
         * Helper type to construct an OggPage.
         * This struct contains the same members as OggPage, but is writable.
@@ -58,8 +129,11 @@ namespace vcpp {
             uint32_t pageSequenceNumber;
             uint32_t pageChecksum;
 
+            uint8_t numSegments;
+            std::array<uint8_t, 255> segmentTable;
+
             std::size_t dataSize;
-            std::unique_ptr<uint8_t[]> data;
+            DataPtr data;
 
             inline Params(): 
                 streamStructureVersion{ 0 },
@@ -70,6 +144,8 @@ namespace vcpp {
                 streamSerialNumber{ 0 },
                 pageSequenceNumber{ 0 },
                 pageChecksum{ 0 },
+                numSegments{ 0 },
+                segmentTable{},
                 dataSize{ 0 },
                 data{ nullptr }
             {}
@@ -103,12 +179,15 @@ namespace vcpp {
         // CRC32 checksum of this page.
         const uint32_t pageChecksum;
 
+        // Number of entries in segmentTable.
+        const uint8_t numSegments;
+
+        // Lacing values of this page. A packet ends with the first lacing value below 255.
+        const std::array<uint8_t, 255> segmentTable;
+
         // Length of the payload contained in this page.
         const std::size_t dataSize;
 
-        // Payload of this page.
-        const std::unique_ptr<const uint8_t[]> data;
-
         /**
         * Constructs an OggPage from a OggPage::Params object.
         * 
@@ -116,12 +195,23 @@ namespace vcpp {
         */
         explicit OggPage(Params&& params);
 
+        /**
+        * Returns the payload of this page, dataSize bytes.
+        */
+        const uint8_t* getData() const {
+            return data_.get();
+        }
+
         OggPage(const OggPage& other) = delete;
         OggPage& operator=(const OggPage& other) = delete;
 
         OggPage(OggPage&& other) = default;
         OggPage& operator=(OggPage&& other) = default;
 
+    private:
+        // Payload of this page. Not const, so that pages can be moved through queues, 
+        // but only replaced by the constructors.
+        DataPtr data_;
     };
 
     class OggPhysicalStreamIn;
@@ -166,16 +256,104 @@ namespace vcpp {
             virtual void onDataAvailable(const uint8_t* const data, const std::size_t size, const MetaData meta) = 0;
         };
 
+        /**
+        * Meta information about the packets passed to PacketCallback::onPacketAvailable().
+        */
+        struct PacketMetaData {
+            // Granule position of the page on which the packet ends, if this is the last packet
+            // ending on that page. Otherwise -1, because the granule position is unknown.
+            const int64_t granulePosition;
+
+            // If there were any pages missing from the logical stream, this field indicates how many
+            // pages were skipped since the last packet. Packets affected by missing pages are dropped.
+            const unsigned int numSkippedPages;
+
+            // True if this is the first packet of the logical stream.
+            const bool isFirstPacket;
+
+            // True if this is the last packet of the logical stream.
+            const bool isLastPacket;
+        };
+
+        class PacketCallback {
+        public:
+            /**
+            * Called when a complete packet is available for the logical stream. The data 
+            * is only valid for the duration of the call.
+            * 
+            * @param data Pointer to the packet.
+            * @param size Size of the packet.
+            * @param meta Meta information about the packet.
+            */
+            virtual void onPacketAvailable(const uint8_t* const data, const std::size_t size, const PacketMetaData meta) = 0;
+        };
+
     private:
+        struct PacketView {
+            const uint8_t* const data;
+            const std::size_t size;
+            const PacketMetaData meta;
+        };
+
+        /**
+        * Position of the packet extraction within the current page.
+        */
+        struct PacketCursor {
+            const OggPage* page;
+            std::size_t segmentIndex;
+            std::size_t dataOffset;
+            int lastCompleteSegment;
+            unsigned int numPacketsReturned;
+            unsigned int numSkippedPages;
+        };
+
         std::vector<std::shared_ptr<DataCallback>> dataCallbacks_;
+        std::vector<std::shared_ptr<PacketCallback>> packetCallbacks_;
         int64_t granulePosition_;
         uint32_t streamSerialNumber_;
         uint32_t pageSequenceNumber_;
         bool isOpen_;
 
+        // True after the physical stream was seeked. The sequence number of the next page 
+        // is then not checked against pageSequenceNumber_.
+        bool isPageSequenceUnknown_;
+
+        // Reassembly state for packets that span multiple pages. packetBuffer_ is 
+        // reused for every such packet.
+        std::vector<uint8_t> packetBuffer_;
+        bool hasPartialPacket_;
+        PacketCursor cursor_;
+
         explicit OggLogicalStreamIn(uint32_t streamSerialNumber);
 
+        /**
+        * Checks the sequence number of a page and returns the number of pages 
+        * that were skipped before it.
+        */
+        unsigned int updatePageSequence(const OggPage& page);
+
         void processPage(const OggPage& page);
+
+        /**
+        * Discards any unfinished packet and the page sequence. Called when the
+        * physical stream jumps to a different position.
+        */
+        void resetPosition();
+
+        /**
+        * Starts extracting packets from a page. The page must stay valid until 
+        * nextPacket() returns an empty optional.
+        */
+        void beginPacketExtraction(const OggPage& page, const unsigned int numSkippedPages);
+
+        /**
+        * Extracts the next complete packet from the current page. Packets that lie entirely
+        * within the page point into the page's payload, packets that span multiple pages
+        * point into packetBuffer_. Returns an empty optional if no more packets end on the 
+        * current page.
+        */
+        std::optional<PacketView> nextPacket();
+
     public:
 
         OggLogicalStreamIn(const OggLogicalStreamIn& other) = delete;
@@ -200,9 +378,42 @@ namespace vcpp {
         */
         void removeDataCallback(const std::shared_ptr<DataCallback>& callback);
 
+        /**
+        * Adds a PacketCallback to this OggLogicalStreamIn. The callback will be called for every 
+        * complete packet of the stream.
+        * 
+        * @param callback The callback.
+        */
+        void addPacketCallback(const std::shared_ptr<PacketCallback> callback);
+
+        /**
+        * Removes a PacketCallback from this OggLogicalStreamIn. If the callback is not found, this method 
+        * does nothing.
+        * 
+        * @param callback Reference to the callback to be removed.
+        */
+        void removePacketCallback(const std::shared_ptr<PacketCallback>& callback);
+
         friend OggPhysicalStreamIn;
     };
 
+    /**
+    * A complete packet returned by OggPhysicalStreamIn::nextPacket().
+    */
+    struct OggPacket {
+        // Pointer to the packet.
+        const uint8_t* const data;
+
+        // Size of the packet.
+        const std::size_t size;
+
+        // Serial number of the logical stream that this packet belongs to.
+        const uint32_t streamSerialNumber;
+
+        // Meta information about the packet.
+        const OggLogicalStreamIn::PacketMetaData meta;
+    };
+
     /**
     * Represents a physical Ogg stream. A physical stream can contain one or more 
     * logical streams (OggLogicalStreamIn).
@@ -227,48 +438,304 @@ namespace vcpp {
         public:
             virtual ~Input() = default;
 
-            virtual uint8_t read() = 0;
+            /**
+            * Reads up to count bytes into buffer. Returns the number of bytes read, which is
+            * only less than count if the end of the input has been reached.
+            */
             virtual std::size_t read(uint8_t* const buffer, const std::size_t count) = 0;
-            virtual bool eof() const = 0;
+
+            /**
+            * If the input resides in memory, returns a pointer to all remaining bytes, stores 
+            * their number in size and advances the input to its end. The pointer stays valid 
+            * for the lifetime of the input. Returns nullptr if the input does not support this.
+            */
+            virtual const uint8_t* map(std::size_t& size) {
+                (void)size;
+                return nullptr;
+            }
+
+            /**
+            * Returns true if the input supports seek() and size().
+            */
+            virtual bool isSeekable() const {
+                return false;
+            }
+
+            /**
+            * Moves the input to the given offset. Offsets are relative to the position 
+            * of the input when it was created.
+            */
+            virtual void seek(const uint64_t offset) {
+                (void)offset;
+            }
+
+            /**
+            * Returns the number of bytes between the position of the input when it was 
+            * created and its end.
+            */
+            virtual uint64_t size() {
+                return 0;
+            }
         };
 
         class FileInput : public Input {
             FILE* const file_;
 
+            // Position of file_ at construction, or -1 if file_ is not seekable.
+            const int64_t origin_;
+
         public:
             FileInput(FILE* file);
 
-            uint8_t read() override;
             std::size_t read(uint8_t* const buffer, const std::size_t count) override;
-            bool eof() const override;
+            bool isSeekable() const override;
+            void seek(const uint64_t offset) override;
+            uint64_t size() override;
         };
 
         class StreamInput : public Input {
             std::basic_istream<uint8_t>& in_;
 
+            // Position of in_ at construction, or -1 if in_ is not seekable.
+            const int64_t origin_;
+
         public:
             StreamInput(std::basic_istream<uint8_t>& in);
 
-            uint8_t read() override;
             std::size_t read(uint8_t* const buffer, const std::size_t count) override;
-            bool eof() const override;
+            bool isSeekable() const override;
+            void seek(const uint64_t offset) override;
+            uint64_t size() override;
+        };
+
+        class MappedInput : public Input {
+            const MappedFile file_;
+            std::size_t position_;
+
+        public:
+            MappedInput(const std::string& path);
+
+            std::size_t read(uint8_t* const buffer, const std::size_t count) override;
+            const uint8_t* map(std::size_t& size) override;
+            bool isSeekable() const override;
+            void seek(const uint64_t offset) override;
+            uint64_t size() override;
         };
 
+        class UringInput : public Input {
+            /**
+            * A read-ahead request and its buffer.
+            */
+            struct Request {
+                std::unique_ptr<uint8_t[]> buffer;
+                uint64_t id;
+                uint64_t offset;
+                std::size_t size;
+                std::size_t available;
+                std::size_t consumed;
+                bool isPending;
+            };
+
+            // Number of requests kept in flight and size of each request.
+            static constexpr std::size_t numRequests = 4;
+            static constexpr std::size_t requestSize = 0x10000;
+
+            // Released if the kernel turns out not to support the reads.
+            std::shared_ptr<IoUring> ring_;
+            FILE* const file_;
+            uint64_t fileSize_;
+
+            // Requests form a queue that starts at requests_[front_].
+            std::array<Request, numRequests> requests_;
+            std::size_t front_;
+            std::size_t numActive_;
+
+            // Offset of the next request to submit.
+            uint64_t nextOffset_;
+
+            /**
+            * Submits requests until numRequests are in flight or the end of the file is reached.
+            */
+            void submitRequests();
+
+            /**
+            * Waits until the request has completed, reading the rest of it if the read was short.
+            * Returns false if the kernel does not support the read.
+            */
+            bool completeRequest(Request& request);
+
+            /**
+            * Stops using the ring and continues with blocking reads from the position of the
+            * first request.
+            */
+            void fallBackToBlockingReads();
+
+            /**
+            * Waits for all requests and discards them.
+            */
+            void cancelRequests();
+
+        public:
+            UringInput(const std::string& path, const std::shared_ptr<IoUring> ring);
+            ~UringInput() override;
+
+            std::size_t read(uint8_t* const buffer, const std::size_t count) override;
+            bool isSeekable() const override;
+            void seek(const uint64_t offset) override;
+            uint64_t size() override;
+        };
+
+        /**
+        * Input of an OggPhysicalStreamIn whose data is passed in with feed(). 
+        * There is never anything to read.
+        */
+        class FedInput : public Input {
+        public:
+            std::size_t read(uint8_t* const buffer, const std::size_t count) override;
+        };
+
+        /**
+        * State shared by the threads of processPipelined().
+        */
+        struct Pipeline;
+
+        /**
+        * Thread and page queue of a logical stream in processConcurrently().
+        */
+        struct StreamWorker;
+
+        /**
+        * Fields of a page header that seekToGranule() needs.
+        */
+        struct PageHeader {
+            // Offset of the capture pattern in the input.
+            uint64_t offset;
+
+            // Size of the whole page, including the header.
+            uint64_t size;
+
+            int64_t granulePosition;
+            uint32_t streamSerialNumber;
+        };
+
+        // Size of the read-ahead buffer.
+        static constexpr std::size_t bufferCapacity = 0x10000;
+
+        // seekToGranule() stops bisecting and scans linearly once the remaining range 
+        // is smaller than this.
+        static constexpr uint64_t seekScanThreshold = 0x10000;
+
+        // Declared first, so that it outlives every other member that may hold pages.
+        PageBufferPool pagePool_;
         const std::unique_ptr<Input> input_;
         std::vector<std::shared_ptr<NewStreamCallback>> newStreamCallbacks_;
         std::unordered_map<uint32_t, OggLogicalStreamIn> logicalStreams_;
 
+        // Page and logical stream that nextPacket() currently extracts packets from.
+        std::optional<OggPage> currentPage_;
+        OggLogicalStreamIn* currentStream_;
+
+        // Read-ahead buffer shared by resync() and readPage(). If the input resides 
+        // in memory, bufferBegin_ and bufferEnd_ point into the input directly and
+        // buffer_ is not allocated.
+        std::unique_ptr<uint8_t[]> buffer_;
+        const uint8_t* bufferBegin_;
+        const uint8_t* bufferEnd_;
+
+        // Beginning of the input if it resides in memory, nullptr otherwise.
+        const uint8_t* mappedBegin_;
+
+        // Offset in the input that corresponds to bufferEnd_.
+        uint64_t inputOffset_;
+
+        // Offset in the input of the page that was read last.
+        uint64_t pageOffset_;
+        bool isMapped_;
+        bool isInputExhausted_;
+        uint64_t numSkippedBytes_;
+
+        // True if the data is passed in with feed().
+        bool isFed_;
+
+        // True after seekToGranule(). Logical streams that are first seen after a seek
+        // do not know their page sequence.
+        bool hasSeeked_;
+
+        OggPhysicalStreamIn(std::unique_ptr<Input>&& input, std::pmr::memory_resource* const resource);
+
+        /**
+        * Makes at least count bytes available between bufferBegin_ and bufferEnd_, 
+        * unless the input ends first. Returns the number of available bytes.
+        */
+        std::size_t fillBuffer(const std::size_t count);
+
         /**
         * Reads a page from the physical stream. The stream is expected to be
         * right after the capture pattern 'OggS'.
         */
         OggPage readPage();
 
+        /**
+        * Reads a page like readPage() into params, but does not verify its checksum.
+        * Returns the checksum of the page header, which verifyPage() continues over the payload.
+        */
+        uint32_t framePage(OggPage::Params& params);
+
+        /**
+        * Throws an OggStreamError if the checksum of a page read by framePage() does not match.
+        */
+        static void verifyPage(const OggPage::Params& params, const uint32_t headerChecksum);
+
         /**
         * Advances the underlying stream to after the next occurance of the 
-        * capture patter 'OggS'.
+        * capture patter 'OggS'. Returns false if the input ended before the
+        * capture pattern was found.
+        */
+        bool resync();
+
+        /**
+        * Same as resync(), but adds the skipped bytes to numSkippedBytes instead of
+        * numSkippedBytes_. The reader thread of processPipelined() uses this, so that
+        * it does not touch the counter that callbacks may read.
+        */
+        bool resync(uint64_t& numSkippedBytes);
+
+        /**
+        * Returns the offset in the input that corresponds to bufferBegin_.
+        */
+        uint64_t tell() const;
+
+        /**
+        * Moves reading to the given offset in the input. Reuses the read-ahead buffer
+        * if it already contains the offset.
+        */
+        void seekInput(const uint64_t offset);
+
+        /**
+        * Finds the next page that begins before end and skips over it without reading 
+        * its payload or verifying its checksum. Returns an empty optional if there is 
+        * no such page.
         */
-        void resync();
+        std::optional<PageHeader> nextPageHeader(const uint64_t end);
+
+        /**
+        * Verifies the checksum of a page returned by nextPageHeader(). If it matches, reading
+        * continues after the page. Otherwise the capture pattern was part of other data, and
+        * reading continues right after it, where the actual next page may begin.
+        */
+        bool isPageIntact(const PageHeader& header);
+
+        /**
+        * Returns the logical stream with the given serial number, creating it if necessary. 
+        * If the stream was created and invokeCallbacks is true, the NewStreamCallbacks are called.
+        */
+        OggLogicalStreamIn& getLogicalStream(const uint32_t streamSerialNumber, const bool invokeCallbacks);
+
+        /**
+        * Processes all complete pages in the read-ahead buffer, leaving an incomplete page
+        * at bufferBegin_. Stores the first error in error and continues with the next page.
+        */
+        void processBufferedPages(std::exception_ptr& error);
 
     public:
         /**
@@ -277,16 +744,57 @@ namespace vcpp {
         * object exists.
         * 
         * @param in Reference to the input stream to be used as a source.
+        * @param resource Memory resource used to allocate page payloads.
         */
-        explicit OggPhysicalStreamIn(std::basic_istream<uint8_t>& in);
+        explicit OggPhysicalStreamIn(
+            std::basic_istream<uint8_t>& in,
+            std::pmr::memory_resource* const resource = std::pmr::get_default_resource());
 
         /**
         * Constructs an OggPhysicalStreamIn that reads from a file. If the 
         * input comes from a file, this is faster than using std::ifstream.
         * 
         * @param file FILE handle to be used as a source for the stream.
+        * @param resource Memory resource used to allocate page payloads.
+        */
+        explicit OggPhysicalStreamIn(
+            FILE* file,
+            std::pmr::memory_resource* const resource = std::pmr::get_default_resource());
+
+        /**
+        * Constructs an OggPhysicalStreamIn that memory-maps the file at the given path.
+        * The payloads passed to the DataCallbacks point directly into the mapping,
+        * which is released when the OggPhysicalStreamIn is destroyed.
+        * Throws an OggStreamError if the file can not be mapped.
+        * 
+        * @param path Path of the file to be used as a source for the stream.
+        */
+        explicit OggPhysicalStreamIn(const std::string& path);
+
+        /**
+        * Constructs an OggPhysicalStreamIn that reads the file at the given path through
+        * an io_uring. Several reads ahead of the current position are kept in flight, so
+        * reading overlaps with processing. Any number of OggPhysicalStreamIn objects, also
+        * on different threads, can share one IoUring. If ring is nullptr or not valid, the
+        * file is read with blocking reads instead.
+        * Throws an OggStreamError if the file can not be opened.
+        * 
+        * @param path Path of the file to be used as a source for the stream.
+        * @param ring The io_uring to submit reads to.
+        * @param resource Memory resource used to allocate page payloads.
         */
-        explicit OggPhysicalStreamIn(FILE* file);
+        OggPhysicalStreamIn(
+            const std::string& path,
+            const std::shared_ptr<IoUring> ring,
+            std::pmr::memory_resource* const resource = std::pmr::get_default_resource());
+
+        /**
+        * Constructs an OggPhysicalStreamIn without an input. Instead, the data is passed 
+        * in with feed(), in chunks of any size, e.g. as it arrives from a socket.
+        * 
+        * @param resource Memory resource used to allocate page payloads.
+        */
+        explicit OggPhysicalStreamIn(std::pmr::memory_resource* const resource = std::pmr::get_default_resource());
 
         OggPhysicalStreamIn(const OggPhysicalStreamIn& other) = delete;
         OggPhysicalStreamIn& operator=(const OggPhysicalStreamIn& other) = delete;
@@ -311,11 +819,116 @@ namespace vcpp {
         * NewStreamCallbacks and DataCallbacks are called accordingly.
         */
         void process();
+
+        /**
+        * Processes the next chunk of data of an OggPhysicalStreamIn that was constructed without 
+        * an input. Complete pages are passed to the NewStreamCallbacks and DataCallbacks like in 
+        * process(). The beginning of an incomplete page is kept until later chunks complete it, 
+        * so feed() returns as soon as the chunk is used up. At most one page is kept, regardless 
+        * of the chunk sizes. If pages are damaged, the rest of the chunk is processed anyway and 
+        * the first OggStreamError is thrown afterwards.
+        * 
+        * @param data The next bytes of the physical stream.
+        * @param size Number of bytes in data.
+        */
+        void feed(const uint8_t* const data, const std::size_t size);
+
+        /**
+        * Same as process(), but spreads the work over several threads. One thread reads 
+        * and frames the pages, numWorkers threads verify their checksums, and the calling 
+        * thread calls the NewStreamCallbacks and DataCallbacks in the same order as process().
+        * If numWorkers is 0, this is the same as process().
+        * 
+        * @param numWorkers Number of threads that verify checksums.
+        * @param queueDepth Maximum number of pages that are read ahead of the callbacks.
+        */
+        void processPipelined(const unsigned int numWorkers, const std::size_t queueDepth = 64);
+
+        /**
+        * Same as process(), but every logical stream gets its own thread, which calls the 
+        * DataCallbacks and PacketCallbacks of that stream. Callbacks of different logical 
+        * streams run concurrently, while the pages of each logical stream keep their order. 
+        * The pages are read on the calling thread, which also calls the NewStreamCallbacks.
+        * If a logical stream's thread falls behind by queueCapacity pages, reading waits 
+        * for it. If any thread throws, the exception is rethrown after all threads stopped.
+        * The DataCallbacks and PacketCallbacks must not call getPageOffset() or 
+        * getNumSkippedBytes(), because the calling thread updates both while it reads ahead.
+        * 
+        * @param queueCapacity Maximum number of pages queued for each logical stream.
+        */
+        void processConcurrently(const std::size_t queueCapacity = 16);
+
+        /**
+        * Reads the next page of the physical stream. No callbacks are called and the 
+        * page is not associated with its logical stream. Returns an empty optional 
+        * at the end of the stream. The payload of the page may belong to this 
+        * OggPhysicalStreamIn, either to its page buffers or to its memory mapped input, 
+        * so the page must not outlive the stream.
+        */
+        std::optional<OggPage> nextPage();
+
+        /**
+        * Reads the next complete packet of any logical stream in this physical stream.
+        * No callbacks are called. The packet's data stays valid until the next call to 
+        * nextPacket(), nextPage() or process(), and at most as long as this 
+        * OggPhysicalStreamIn. Returns an empty optional at the end of the stream.
+        */
+        std::optional<OggPacket> nextPacket();
+
+        /**
+        * Moves the physical stream to the page of a logical stream that contains the given 
+        * granule position, i.e. the first page of the logical stream whose granule position 
+        * is not lower than the given one. The position is found by bisecting over the input, 
+        * so only page headers are read on the way. Afterwards, process(), nextPage() and 
+        * nextPacket() continue at that page. Packets that began before the page are dropped.
+        * Returns false and moves to the end of the input if there is no such page.
+        * Throws an OggStreamError if the input is not seekable.
+        * 
+        * @param streamSerialNumber Serial number of the logical stream.
+        * @param granulePosition Granule position to seek to.
+        */
+        bool seekToGranule(const uint32_t streamSerialNumber, const int64_t granulePosition);
+
+        /**
+        * Same as seekToGranule(streamSerialNumber, granulePosition), but only searches for pages
+        * that begin in [begin, end). This is useful if the range of the target page is already 
+        * known, e.g. from an OggIndex.
+        * 
+        * @param streamSerialNumber Serial number of the logical stream.
+        * @param granulePosition Granule position to seek to.
+        * @param begin Offset of the first byte to search.
+        * @param end Offset after the last byte to search.
+        */
+        bool seekToGranule(
+            const uint32_t streamSerialNumber, 
+            const int64_t granulePosition, 
+            const uint64_t begin, 
+            const uint64_t end);
+
+        /**
+        * Returns the offset in the input of the page that was read last. Offsets are relative to
+        * the position of the input when the OggPhysicalStreamIn was created.
+        */
+        uint64_t getPageOffset() const;
+
+        /**
+        * Returns the number of bytes that were skipped so far because they did not belong
+        * to any page, e.g. junk before the first page or damaged parts of the stream.
+        */
+        uint64_t getNumSkippedBytes() const;
         
     };
 
     class OggPhysicalStreamOut;
 
+    /**
+    * A contiguous piece of memory. Used to pass data that is split over several buffers.
+    */
+    struct OggFragment {
+        const uint8_t* data;
+        std::size_t size;
+    };
+
     /**
     * Represents a logical output stream. Objects of this type are obtained by calling
     * OggPhysicalStreamOut.newLogicalStream() and are thereby associated with a specific
@@ -330,8 +943,91 @@ namespace vcpp {
         bool isStreamOpen_;
         bool isFirstWrite_;
 
+        // Packing mode, see enablePacking(). targetPageSize_ is 0 if packing is disabled.
+        unsigned int targetPageSize_;
+        int64_t maxGranuleSpan_;
+
+        // The page that is being packed. The last pendingUnlacedSize_ bytes of pendingData_ 
+        // belong to the open packet and are not covered by lacing values yet.
+        std::vector<uint8_t> pendingData_;
+        std::array<uint8_t, 255> pendingSegmentTable_;
+        unsigned int pendingNumSegments_;
+        std::size_t pendingUnlacedSize_;
+        bool isPendingContinued_;
+
+        // Granule positions of the first and the last packet that end on the pending page.
+        int64_t pendingFirstGranulePosition_;
+        int64_t pendingGranulePosition_;
+        bool hasPendingGranulePosition_;
+
+        // Pages that were assembled, but not passed to the physical stream yet. Fragments
+        // with a null data pointer stand for the next page header in batchHeaders_.
+        std::vector<OggFragment> batch_;
+        std::vector<uint8_t> batchHeaders_;
+
+        // Pieces of the written fragments that make up the next page. Kept between
+        // writes, so that writing a packet does not allocate.
+        std::vector<OggFragment> pageFragments_;
+
+        // Queue to the muxer of the physical stream, or nullptr if the stream is not muxed.
+        // See OggPhysicalStreamOut::startMuxing().
+        struct MuxerStream;
+        std::shared_ptr<MuxerStream> muxerStream_;
+        std::function<double(const int64_t)> timeMapping_;
+        double lastPageTime_;
+
         OggLogicalStreamOut(OggPhysicalStreamOut& sink, const uint32_t streamSerialNumber);
 
+        /**
+        * Passes the pages of the batch to the muxer of the physical stream.
+        */
+        void queueBatch();
+
+        /**
+        * Adds a single page with the given segment table to the batch. The payload is
+        * the concatenation of the fragments, which together contain size bytes.
+        */
+        void addPage(
+            const OggFragment* const fragments,
+            const std::size_t numFragments,
+            const unsigned int size,
+            const uint8_t* const segmentTable,
+            const uint8_t numSegments,
+            const int64_t granulePosition,
+            const bool isContinuedPacket,
+            const bool closeStream);
+
+        /**
+        * Adds a single page containing the fragments to the batch.
+        */
+        void addPage(
+            const OggFragment* const fragments,
+            const std::size_t numFragments,
+            const unsigned int size,
+            const int64_t granulePosition,
+            const bool closePacket,
+            const bool closeStream);
+
+        /**
+        * Passes all pages of the batch to the physical stream in a single write.
+        */
+        void writeBatch();
+
+        /**
+        * Appends data to the pending page in packing mode, writing pages as they fill up.
+        */
+        void writePacked(
+            const uint8_t* const data,
+            const unsigned int size,
+            const int64_t granulePosition,
+            const bool closePacket,
+            const bool closeStream);
+
+        /**
+        * Writes the pending page of packing mode, if it contains any complete segments.
+        */
+        void writePendingPage(const bool closeStream);
+
     public:
         OggLogicalStreamOut(const OggLogicalStreamOut& other) = delete;
         OggLogicalStreamOut& operator=(const OggLogicalStreamOut& other) = delete;
@@ -339,6 +1035,12 @@ namespace vcpp {
         OggLogicalStreamOut(OggLogicalStreamOut&& other) noexcept;
         OggLogicalStreamOut& operator=(OggLogicalStreamOut&& other) = delete;
 
+        /**
+        * Flushes the pending page in packing mode. If the stream is muxed, the muxer 
+        * stops waiting for its pages.
+        */
+        ~OggLogicalStreamOut();
+
         void writePage(
             const uint8_t* const data,
             const unsigned int size,
@@ -348,6 +1050,7 @@ namespace vcpp {
 
         /**
         * Writes data to this logical stream. The data is transparently transformed into pages.
+        * In packing mode, consecutive packets share pages, see enablePacking().
         * 
         * @param data The data to be written.
         * @param size Size of data.
@@ -362,6 +1065,51 @@ namespace vcpp {
             const bool closePacket = true,
             const bool closeStream = false);
 
+        /**
+        * Writes data that is split over several buffers, as if the fragments were concatenated
+        * and passed to write(). Outside of packing mode, the pages refer to the fragments 
+        * directly, so the data is not copied.
+        * 
+        * @param fragments The buffers containing the data, in order.
+        * @param numFragments Number of fragments.
+        * @param granulePosition Value for the granulePosition field.
+        * @param closePacket Whether to close the current packet after the data has been written.
+        * @param closeStream Whether to close the logical stream after the data has been written.
+        */
+        void write(
+            const OggFragment* const fragments,
+            const std::size_t numFragments,
+            const int64_t granulePosition,
+            const bool closePacket = true,
+            const bool closeStream = false);
+
+        /**
+        * Enables packing mode. Instead of writing at least one page per call, write() then 
+        * collects packets in a pending page with the proper lacing values. The pending page 
+        * is written once its payload reaches targetPageSize bytes, once the granule positions 
+        * of the packets ending on it span maxGranuleSpan or more, when it runs out of lacing
+        * values, when the stream is closed, or when flush() is called. The granule position 
+        * of each page is that of the last packet ending on it, or -1 if no packet ends on it.
+        * 
+        * @param targetPageSize Payload size at which a page is written.
+        * @param maxGranuleSpan Maximum span of granule positions on a page, or -1 for no limit.
+        */
+        void enablePacking(const unsigned int targetPageSize = 4096, const int64_t maxGranuleSpan = -1);
+
+        /**
+        * Writes the pending page in packing mode. Data of an open packet that does not fill a 
+        * whole segment stays pending until more data arrives. Does nothing outside packing mode.
+        */
+        void flush();
+
+        /**
+        * Sets the function that converts granule positions of this stream to the time base 
+        * that the muxer of the physical stream orders pages by, e.g. to seconds. By default, 
+        * granule positions are used directly. Must be set before the first page is written.
+        * See OggPhysicalStreamOut::startMuxing().
+        */
+        void setTimeMapping(std::function<double(const int64_t)> timeMapping);
+
         friend OggPhysicalStreamOut;
     };
 
@@ -377,33 +1125,84 @@ namespace vcpp {
         public:
             virtual ~Output() = default;
 
-            virtual void write(const uint8_t val) = 0;
-            virtual void write(const uint8_t* const buffer, std::size_t count) = 0;
+            /**
+            * Writes the fragments in order. Throws an OggStreamError with Cause::IOError 
+            * if the data can not be written.
+            */
+            virtual void write(const OggFragment* const fragments, const std::size_t numFragments) = 0;
+
+            /**
+            * Passes data buffered by the underlying file or stream on to the system.
+            */
+            virtual void flush() = 0;
         };
 
-        class FileOutput : public Output {
+        /**
+        * Output that copies small fragments into a buffer, so that they are passed
+        * to the underlying file or stream in as few calls as possible.
+        */
+        class GatheringOutput : public Output {
+            static constexpr std::size_t bufferSize = 0x10000;
+
+            std::vector<uint8_t> buffer_;
+
+            void flushBuffer();
+
+        protected:
+            virtual void writeContiguous(const uint8_t* const buffer, const std::size_t count) = 0;
+
+        public:
+            void write(const OggFragment* const fragments, const std::size_t numFragments) override;
+        };
+
+        class FileOutput : public GatheringOutput {
             FILE* file_;
 
+        protected:
+            void writeContiguous(const uint8_t* const buffer, const std::size_t count) override;
+
         public:
             FileOutput(FILE* file);
 
-            void write(const uint8_t val) override;
-            void write(const uint8_t* const buffer, const std::size_t count) override;
+            void flush() override;
         };
 
-        class StreamOutput : public Output {
+        class StreamOutput : public GatheringOutput {
             std::basic_ostream<uint8_t>& out_;
 
+        protected:
+            void writeContiguous(const uint8_t* const buffer, const std::size_t count) override;
+
         public:
             StreamOutput(std::basic_ostream<uint8_t>& out);
 
-            void write(const uint8_t val) override;
-            void write(const uint8_t* const buffer, const std::size_t count) override;
+            void flush() override;
+        };
+
+        /**
+        * Output that writes all fragments with a single writev() call, without copying them.
+        */
+        class DescriptorOutput : public Output {
+            const int fileDescriptor_;
+
+        public:
+            DescriptorOutput(const int fileDescriptor);
+
+            void write(const OggFragment* const fragments, const std::size_t numFragments) override;
+            void flush() override;
         };
 
+        struct Muxer;
+
         std::mutex writeLock;
         std::unique_ptr<Output> output_;
         std::set<uint32_t> assignedSerialNums_;
+        std::unique_ptr<Muxer> muxer_;
+
+        /**
+        * Body of the muxer thread.
+        */
+        void runMuxer();
 
     public:
         /**
@@ -422,6 +1221,57 @@ namespace vcpp {
         */
         explicit OggPhysicalStreamOut(std::basic_ostream<uint8_t>& out);
 
+        /**
+        * Constructs an OggPhysicalStreamOut that writes to a file descriptor, e.g. a file, 
+        * pipe or socket. The pages of each write are passed to the system in a single call, 
+        * without copying them. The file descriptor is not closed by the OggPhysicalStreamOut.
+        * 
+        * @param fileDescriptor The file descriptor to write to.
+        */
+        explicit OggPhysicalStreamOut(const int fileDescriptor);
+
+        /**
+        * Waits for the muxer to finish, if it was started. Errors of the muxer are ignored, 
+        * call finishMuxing() to see them.
+        */
+        ~OggPhysicalStreamOut();
+
+        OggPhysicalStreamOut(const OggPhysicalStreamOut& other) = delete;
+        OggPhysicalStreamOut& operator=(const OggPhysicalStreamOut& other) = delete;
+
+        /**
+        * Starts a muxer thread that interleaves the pages of logical streams by time. 
+        * Logical streams that are created afterwards queue their pages in a lock-free queue 
+        * instead of writing them, so that the writing threads never wait for the output, 
+        * only for free space in their queue. The muxer writes the page with the earliest time 
+        * among the first queued pages of all open streams, so it waits until every open stream 
+        * has a page queued. The time of a page is obtained from its granule position, see 
+        * OggLogicalStreamOut::setTimeMapping(). Pages without a granule position keep the time 
+        * of the stream's previous page.
+        * 
+        * Pages are only ordered against streams that exist when they are written, so all 
+        * streams that start together should be created before any of them is written to.
+        * Since the muxer waits for every open stream, each muxed stream should be written by 
+        * its own thread. A thread writing several streams must not let one of them run more 
+        * than queueCapacity pages ahead of the others.
+        * 
+        * @param queueCapacity Maximum number of pages queued per logical stream.
+        */
+        void startMuxing(const std::size_t queueCapacity = 64);
+
+        /**
+        * Waits until all muxed logical streams are closed or destroyed and all of their pages
+        * were written, then stops the muxer thread. If writing failed, the error is rethrown here, 
+        * while the writing threads receive an OggStreamError with Cause::IOError.
+        */
+        void finishMuxing();
+
+        /**
+        * Flushes the buffers of the underlying file or stream.
+        * Throws an OggStreamError with Cause::IOError if this fails.
+        */
+        void flush();
+
         /**
         * Obtains a new OggLogicalStreamOut which is associated with this physical stream.
         * Its stream serial number is random.
@@ -437,12 +1287,7 @@ namespace vcpp {
         */
         std::optional<OggLogicalStreamOut> newLogicalStream(const uint32_t streamSerialNumber);
 
-        friend void OggLogicalStreamOut::writePage(
-            const uint8_t* const data, 
-            const unsigned int size,
-            const int64_t granulePosition,
-            const bool closePacket,
-            const bool closeStream);
+        friend void OggLogicalStreamOut::writeBatch();
     };
 }
 
@@ -0,0 +1,159 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace vcpp {
+
+    /**
+    * Bounded queue for exactly one producer thread and one consumer thread. Pushing
+    * and popping are lock-free as long as the queue is neither full nor empty. Only
+    * a thread that has to wait for the other side takes the mutex and sleeps.
+    */
+    template<typename T>
+    class SpscQueue {
+        // Keeps the indices of the two threads in different cache lines.
+        static constexpr std::size_t cacheLineSize = 64;
+
+        const std::size_t capacity_;
+        const std::unique_ptr<std::optional<T>[]> slots_;
+
+        // Number of elements pushed so far. Only written by the producer.
+        alignas(cacheLineSize) std::atomic<std::size_t> tail_;
+
+        // Number of elements popped so far. Only written by the consumer.
+        alignas(cacheLineSize) std::atomic<std::size_t> head_;
+
+        alignas(cacheLineSize) std::atomic<bool> isClosed_;
+        std::atomic<bool> isProducerWaiting_;
+        std::atomic<bool> isConsumerWaiting_;
+        std::mutex lock_;
+        std::condition_variable changed_;
+
+        /**
+        * Wakes up the other thread if it waits. The fence orders the preceding index update
+        * before the check of the flag, while the waiting thread sets the flag before checking
+        * the index again, so one of them always sees the other.
+        */
+        void notify(std::atomic<bool>& isWaiting) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (isWaiting.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> guard{ lock_ };
+                changed_.notify_all();
+            }
+        }
+
+        template<typename Predicate>
+        void wait(std::atomic<bool>& isWaiting, Predicate isDone) {
+            std::unique_lock<std::mutex> guard{ lock_ };
+            isWaiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            changed_.wait(guard, isDone);
+            isWaiting.store(false, std::memory_order_relaxed);
+        }
+
+    public:
+        /**
+        * Constructs an SpscQueue.
+        *
+        * @param capacity Maximum number of elements in the queue.
+        */
+        explicit SpscQueue(const std::size_t capacity)
+            : capacity_{ capacity > 0 ? capacity : 1 },
+              slots_{ new std::optional<T>[capacity_] },
+              tail_{ 0 },
+              head_{ 0 },
+              isClosed_{ false },
+              isProducerWaiting_{ false },
+              isConsumerWaiting_{ false } {}
+
+        SpscQueue(const SpscQueue& other) = delete;
+        SpscQueue& operator=(const SpscQueue& other) = delete;
+
+        /**
+        * Adds an element if the queue is not full. Returns false without moving
+        * from value otherwise. May only be called by the producer.
+        */
+        bool tryPush(T&& value) {
+            const std::size_t tail{ tail_.load(std::memory_order_relaxed) };
+            if (tail - head_.load(std::memory_order_acquire) == capacity_) {
+                return false;
+            }
+            slots_[tail % capacity_].emplace(std::move(value));
+            tail_.store(tail + 1, std::memory_order_release);
+            notify(isConsumerWaiting_);
+            return true;
+        }
+
+        /**
+        * Removes the oldest element if the queue is not empty. May only be called
+        * by the consumer.
+        */
+        std::optional<T> tryPop() {
+            const std::size_t head{ head_.load(std::memory_order_relaxed) };
+            if (head == tail_.load(std::memory_order_acquire)) {
+                return std::optional<T>{};
+            }
+            std::optional<T>& slot{ slots_[head % capacity_] };
+            std::optional<T> value{ std::move(slot) };
+            slot.reset();
+            head_.store(head + 1, std::memory_order_release);
+            notify(isProducerWaiting_);
+            return value;
+        }
+
+        /**
+        * Adds an element, waiting while the queue is full. Returns false without
+        * moving from value if the queue was closed. May only be called by the producer.
+        */
+        bool push(T&& value) {
+            while (!isClosed_.load(std::memory_order_acquire)) {
+                if (tryPush(std::move(value))) {
+                    return true;
+                }
+                wait(isProducerWaiting_, [this] {
+                    return isClosed_.load() || tail_.load() - head_.load() < capacity_;
+                });
+            }
+            return false;
+        }
+
+        /**
+        * Removes the oldest element, waiting while the queue is empty. Returns an empty
+        * optional once the queue is closed and empty. May only be called by the consumer.
+        */
+        std::optional<T> pop() {
+            while (true) {
+                std::optional<T> value{ tryPop() };
+                if (value || (isClosed_.load(std::memory_order_acquire) && head_.load() == tail_.load())) {
+                    return value;
+                }
+                wait(isConsumerWaiting_, [this] {
+                    return isClosed_.load() || head_.load() != tail_.load();
+                });
+            }
+        }
+
+        /**
+        * Closes the queue. Afterwards, push() fails and pop() returns the remaining
+        * elements. Can be called by both threads.
+        */
+        void close() {
+            isClosed_.store(true, std::memory_order_release);
+            std::lock_guard<std::mutex> guard{ lock_ };
+            changed_.notify_all();
+        }
+
+        bool isClosed() const {
+            return isClosed_.load(std::memory_order_acquire);
+        }
+    };
+}
+
+#endif
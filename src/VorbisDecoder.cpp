@@ -0,0 +1,388 @@
+#include "VorbisDecoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace vcpp {
+
+    // Range of the Y values of floor type 1 for each multiplier.
+    static constexpr int floor1Ranges[4]{ 256, 128, 86, 64 };
+
+    // render_point() from the Vorbis specification.
+    static int renderPoint(const int x0, const int y0, const int x1, const int y1, const int x) {
+        const int dy{ y1 - y0 };
+        const int adx{ x1 - x0 };
+        const int offset{ std::abs(dy) * (x - x0) / adx };
+        return dy < 0 ? y0 - offset : y0 + offset;
+    }
+
+    /**
+    * Writes the Y values of the line from (x0, y0) to (x1, y1) to curve[x0] to curve[x1 - 1],
+    * like render_line() from the Vorbis specification. Values at or after size are dropped.
+    */
+    static void renderLine(const int x0, const int y0, const int x1, const int y1, uint8_t* const curve, const int size) {
+        const int end{ std::min(x1, size) };
+        if (x0 >= end) {
+            return;
+        }
+        const int dy{ y1 - y0 };
+        if (dy == 0) {
+            std::fill(curve + x0, curve + end, uint8_t(y0));
+            return;
+        }
+
+        const int adx{ x1 - x0 };
+        const int base{ dy / adx };
+        const int step{ dy < 0 ? base - 1 : base + 1 };
+        const int ady{ std::abs(dy) - std::abs(base) * adx };
+        int y{ y0 };
+        int error{ 0 };
+        curve[x0] = uint8_t(y);
+        for (int x{ x0 + 1 }; x < end; x++) {
+            error += ady;
+            if (error >= adx) {
+                error -= adx;
+                y += step;
+            }
+            else {
+                y += base;
+            }
+            curve[x] = uint8_t(y);
+        }
+    }
+
+    VorbisDecoder::VorbisDecoder(
+        const VorbisIdentification& identification,
+        VorbisSetup setup,
+        const VorbisDspKernels& kernels
+    ) : identification_{ identification },
+        setup_{ std::move(setup) },
+        kernels_{ kernels },
+        modeBits_{ vorbisILog(uint32_t(setup_.modes.size() - 1)) },
+        imdcts_{ VorbisImdct::get(identification.blockSizes[0], kernels), VorbisImdct::get(identification.blockSizes[1], kernels) } {}
+
+    bool VorbisDecoder::readPacketHeader(BitReader& reader, PacketHeader& header) const {
+        if (reader.readFlag()) {
+            return false;
+        }
+        header.modeNumber = uint8_t(reader.read(modeBits_));
+        if (header.modeNumber >= setup_.modes.size()) {
+            return false;
+        }
+        header.blockFlag = setup_.modes[header.modeNumber].blockFlag;
+        header.isPreviousBlockLong = header.blockFlag && reader.readFlag();
+        header.isNextBlockLong = header.blockFlag && reader.readFlag();
+        return !reader.isEndOfPacket();
+    }
+
+    bool VorbisDecoder::decodeFloor(BitReader& reader, const VorbisFloor1& floor, int16_t* const values) const {
+        if (!reader.readFlag()) {
+            return false;
+        }
+
+        const unsigned int rangeBits{ vorbisILog(uint32_t(floor1Ranges[floor.multiplier - 1] - 1)) };
+        values[0] = int16_t(reader.read(rangeBits));
+        values[1] = int16_t(reader.read(rangeBits));
+
+        std::size_t offset{ 2 };
+        for (const uint8_t partitionClass : floor.partitionClasses) {
+            const unsigned int subclassBits{ floor.classSubclassBits[partitionClass] };
+            const uint32_t subclassMask{ (uint32_t(1) << subclassBits) - 1 };
+            uint32_t subclasses{ 0 };
+            if (subclassBits != 0) {
+                const int32_t entry{ setup_.codebooks[floor.classMasterbooks[partitionClass]].decodeEntry(reader) };
+                if (entry < 0) {
+                    return false;
+                }
+                subclasses = uint32_t(entry);
+            }
+
+            const int16_t* const books{ floor.subclassBooks.data() + partitionClass * VorbisFloor1::maxSubclasses };
+            for (unsigned int i{ 0 }; i < floor.classDimensions[partitionClass]; i++) {
+                const int16_t book{ books[subclasses & subclassMask] };
+                subclasses >>= subclassBits;
+                if (book < 0) {
+                    values[offset + i] = 0;
+                    continue;
+                }
+                const int32_t entry{ setup_.codebooks[book].decodeEntry(reader) };
+                if (entry < 0) {
+                    return false;
+                }
+                values[offset + i] = int16_t(std::min<int32_t>(entry, INT16_MAX));
+            }
+            offset += floor.classDimensions[partitionClass];
+        }
+        return !reader.isEndOfPacket();
+    }
+
+    void VorbisDecoder::applyFloor(
+        const VorbisFloor1& floor,
+        const int16_t* const values,
+        float* const spectrum,
+        const std::size_t size,
+        Workspace& workspace
+    ) const {
+        const std::size_t numValues{ floor.xList.size() };
+        const int range{ floor1Ranges[floor.multiplier - 1] };
+
+        // Amplitude value synthesis. Values that the packet leaves at their predicted
+        // Y are not used as end points of the lines.
+        int finalValues[VorbisFloor1::maxValues];
+        bool isUsed[VorbisFloor1::maxValues];
+        // Damaged packets can produce values out of range.
+        finalValues[0] = std::min<int>(values[0], range - 1);
+        finalValues[1] = std::min<int>(values[1], range - 1);
+        isUsed[0] = true;
+        isUsed[1] = true;
+        for (std::size_t i{ 2 }; i < numValues; i++) {
+            const uint8_t low{ floor.lowNeighbors[i] };
+            const uint8_t high{ floor.highNeighbors[i] };
+            const int predicted{ renderPoint(
+                floor.xList[low], finalValues[low], floor.xList[high], finalValues[high], floor.xList[i]) };
+            const int value{ values[i] };
+            const int highRoom{ range - predicted };
+            const int lowRoom{ predicted };
+            const int room{ 2 * std::min(highRoom, lowRoom) };
+            if (value == 0) {
+                isUsed[i] = false;
+                finalValues[i] = predicted;
+                continue;
+            }
+
+            isUsed[low] = true;
+            isUsed[high] = true;
+            isUsed[i] = true;
+            if (value >= room) {
+                finalValues[i] = highRoom > lowRoom ? value - lowRoom + predicted : predicted - value + highRoom - 1;
+            }
+            else {
+                finalValues[i] = (value & 1) != 0 ? predicted - (value + 1) / 2 : predicted + value / 2;
+            }
+            finalValues[i] = std::clamp(finalValues[i], 0, range - 1);
+        }
+
+        // Curve synthesis. The lines connect the used values in the order of their X coordinates.
+        workspace.floorCurve.resize(size);
+        uint8_t* const curve{ workspace.floorCurve.data() };
+        const int curveSize{ int(size) };
+        int lowX{ 0 };
+        int lowY{ finalValues[floor.sortedOrder[0]] * floor.multiplier };
+        for (std::size_t i{ 1 }; i < numValues; i++) {
+            const uint8_t index{ floor.sortedOrder[i] };
+            if (!isUsed[index]) {
+                continue;
+            }
+            const int highX{ floor.xList[index] };
+            const int highY{ finalValues[index] * floor.multiplier };
+            renderLine(lowX, lowY, highX, highY, curve, curveSize);
+            lowX = highX;
+            lowY = highY;
+        }
+        if (lowX < curveSize) {
+            std::fill(curve + lowX, curve + curveSize, uint8_t(lowY));
+        }
+
+        kernels_.applyFloor(spectrum, curve, size);
+    }
+
+    void VorbisDecoder::decodeResidue(
+        BitReader& reader,
+        const VorbisResidue& residue,
+        float* const* const vectors,
+        const uint8_t* const isUsed,
+        const std::size_t numChannels,
+        const std::size_t size,
+        Workspace& workspace
+    ) const {
+        // Type 2 decodes all channels as one interleaved vector with format 1.
+        const bool isInterleaved{ residue.type == 2 };
+        float* interleavedVector{ nullptr };
+        std::size_t numVectors{ numChannels };
+        std::size_t vectorSize{ size };
+        if (isInterleaved) {
+            if (std::none_of(isUsed, isUsed + numChannels, [](const uint8_t used) { return used != 0; })) {
+                return;
+            }
+            workspace.interleavedResidue.assign(numChannels * size, 0.0f);
+            interleavedVector = workspace.interleavedResidue.data();
+            numVectors = 1;
+            vectorSize = numChannels * size;
+        }
+        float* const* const outputs{ isInterleaved ? &interleavedVector : vectors };
+        static const uint8_t interleavedIsUsed{ 1 };
+        const uint8_t* const isOutputUsed{ isInterleaved ? &interleavedIsUsed : isUsed };
+
+        const std::size_t begin{ std::min<std::size_t>(residue.begin, vectorSize) };
+        const std::size_t end{ std::min<std::size_t>(residue.end, vectorSize) };
+        const std::size_t partitionSize{ residue.partitionSize };
+        const std::size_t numPartitions{ end > begin ? (end - begin) / partitionSize : 0 };
+        const VorbisCodebook& classbook{ setup_.codebooks[residue.classbook] };
+        const std::size_t classesPerCodeword{ classbook.dimensions };
+
+        // Room for the classes of the last codeword, which can reach past the last partition.
+        const std::size_t classificationsStride{ numPartitions + classesPerCodeword };
+        workspace.classifications.resize(numVectors * classificationsStride);
+        uint8_t* const classifications{ workspace.classifications.data() };
+
+        // Decodes the partitions until the packet ends.
+        auto decodePasses = [&]() {
+            for (std::size_t pass{ 0 }; pass < VorbisResidue::numPasses; pass++) {
+                std::size_t partition{ 0 };
+                while (partition < numPartitions) {
+                    if (pass == 0) {
+                        for (std::size_t j{ 0 }; j < numVectors; j++) {
+                            if (isOutputUsed[j] == 0) {
+                                continue;
+                            }
+                            const int32_t entry{ classbook.decodeEntry(reader) };
+                            if (entry < 0) {
+                                return;
+                            }
+                            uint32_t classes{ uint32_t(entry) };
+                            uint8_t* const channelClassifications{ classifications + j * classificationsStride + partition };
+                            for (std::size_t i{ classesPerCodeword }; i-- > 0;) {
+                                channelClassifications[i] = uint8_t(classes % residue.numClassifications);
+                                classes /= residue.numClassifications;
+                            }
+                        }
+                    }
+
+                    for (std::size_t i{ 0 }; i < classesPerCodeword && partition < numPartitions; i++, partition++) {
+                        for (std::size_t j{ 0 }; j < numVectors; j++) {
+                            if (isOutputUsed[j] == 0) {
+                                continue;
+                            }
+                            const uint8_t classification{ classifications[j * classificationsStride + partition] };
+                            const int16_t book{ residue.books[classification * VorbisResidue::numPasses + pass] };
+                            if (book < 0) {
+                                continue;
+                            }
+
+                            const VorbisCodebook& codebook{ setup_.codebooks[book] };
+                            const std::size_t dimensions{ codebook.dimensions };
+                            float* const out{ outputs[j] + begin + partition * partitionSize };
+                            if (residue.type == 0) {
+                                // The values of each vector are spread over the partition.
+                                const std::size_t step{ partitionSize / dimensions };
+                                for (std::size_t k{ 0 }; k < step; k++) {
+                                    const float* const vector{ codebook.decodeVector(reader) };
+                                    if (vector == nullptr) {
+                                        return;
+                                    }
+                                    for (std::size_t d{ 0 }; d < dimensions; d++) {
+                                        out[k + d * step] += vector[d];
+                                    }
+                                }
+                            }
+                            else {
+                                for (std::size_t k{ 0 }; k < partitionSize;) {
+                                    const float* const vector{ codebook.decodeVector(reader) };
+                                    if (vector == nullptr) {
+                                        return;
+                                    }
+                                    const std::size_t count{ std::min(dimensions, partitionSize - k) };
+                                    for (std::size_t d{ 0 }; d < count; d++) {
+                                        out[k + d] += vector[d];
+                                    }
+                                    k += count;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        };
+        decodePasses();
+
+        if (isInterleaved) {
+            kernels_.deinterleave(interleavedVector, vectors, numChannels, size);
+        }
+    }
+
+    void VorbisDecoder::decodeSpectrum(
+        BitReader& reader,
+        const PacketHeader& header,
+        float* const spectra,
+        const std::size_t stride,
+        Workspace& workspace
+    ) const {
+        const std::size_t numChannels{ identification_.numChannels };
+        const std::size_t size{ getBlockSize(header) / 2 };
+        const VorbisMapping& mapping{ setup_.mappings[setup_.modes[header.modeNumber].mapping] };
+
+        workspace.floorValues.resize(numChannels * VorbisFloor1::maxValues);
+        workspace.isFloorUsed.resize(numChannels);
+        workspace.isResidueUsed.resize(numChannels);
+
+        for (std::size_t channel{ 0 }; channel < numChannels; channel++) {
+            std::fill(spectra + channel * stride, spectra + channel * stride + size, 0.0f);
+            const VorbisFloor1& floor{ setup_.floors[mapping.submapFloors[mapping.channelMux[channel]]] };
+            const bool isUsed{ decodeFloor(reader, floor, workspace.floorValues.data() + channel * VorbisFloor1::maxValues) };
+            workspace.isFloorUsed[channel] = isUsed;
+            workspace.isResidueUsed[channel] = isUsed;
+        }
+
+        // Coupled channels have to be decoded if either of them has a floor.
+        for (const VorbisMapping::CouplingStep& step : mapping.couplingSteps) {
+            if (workspace.isResidueUsed[step.magnitude] != 0 || workspace.isResidueUsed[step.angle] != 0) {
+                workspace.isResidueUsed[step.magnitude] = 1;
+                workspace.isResidueUsed[step.angle] = 1;
+            }
+        }
+
+        float* submapVectors[256];
+        uint8_t submapIsUsed[256];
+        for (std::size_t submap{ 0 }; submap < mapping.submapResidues.size(); submap++) {
+            std::size_t numSubmapChannels{ 0 };
+            for (std::size_t channel{ 0 }; channel < numChannels; channel++) {
+                if (mapping.channelMux[channel] == submap) {
+                    submapVectors[numSubmapChannels] = spectra + channel * stride;
+                    submapIsUsed[numSubmapChannels] = workspace.isResidueUsed[channel];
+                    numSubmapChannels++;
+                }
+            }
+            const VorbisResidue& residue{ setup_.residues[mapping.submapResidues[submap]] };
+            decodeResidue(reader, residue, submapVectors, submapIsUsed, numSubmapChannels, size, workspace);
+        }
+
+        for (std::size_t i{ mapping.couplingSteps.size() }; i-- > 0;) {
+            const VorbisMapping::CouplingStep& step{ mapping.couplingSteps[i] };
+            kernels_.decouple(spectra + step.magnitude * stride, spectra + step.angle * stride, size);
+        }
+
+        for (std::size_t channel{ 0 }; channel < numChannels; channel++) {
+            float* const spectrum{ spectra + channel * stride };
+            if (workspace.isFloorUsed[channel] == 0) {
+                std::fill(spectrum, spectrum + size, 0.0f);
+                continue;
+            }
+            const VorbisFloor1& floor{ setup_.floors[mapping.submapFloors[mapping.channelMux[channel]]] };
+            applyFloor(floor, workspace.floorValues.data() + channel * VorbisFloor1::maxValues, spectrum, size, workspace);
+        }
+    }
+
+    void VorbisDecoder::decodeBlock(
+        BitReader& reader,
+        const PacketHeader& header,
+        float* const blocks,
+        const std::size_t stride,
+        Workspace& workspace
+    ) const {
+        const std::size_t blockSize{ getBlockSize(header) };
+        const VorbisImdct& imdct{ getImdct(header) };
+        decodeSpectrum(reader, header, blocks, stride, workspace);
+
+        workspace.imdctScratch.resize(blockSize / 2);
+        for (std::size_t channel{ 0 }; channel < identification_.numChannels; channel++) {
+            float* const block{ blocks + channel * stride };
+            if (workspace.isFloorUsed[channel] == 0) {
+                std::fill(block, block + blockSize, 0.0f);
+            }
+            else {
+                imdct.transform(block, block, workspace.imdctScratch.data());
+            }
+        }
+    }
+}
@@ -0,0 +1,179 @@
+#ifndef VORBIS_DECODER_H
+#define VORBIS_DECODER_H
+
+#include "BitReader.h"
+#include "VorbisDsp.h"
+#include "VorbisImdct.h"
+#include "VorbisSetup.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace vcpp {
+
+    /**
+    * Decodes the audio packets of a Vorbis stream into spectra, using the parameters from
+    * the stream's headers. The methods are const, so that several threads can decode packets
+    * of the same stream at once, each with its own Workspace.
+    */
+    class VorbisDecoder {
+    public:
+        /**
+        * Fields at the beginning of an audio packet.
+        */
+        struct PacketHeader {
+            uint8_t modeNumber;
+
+            // True for long blocks.
+            bool blockFlag;
+
+            // True if the previous and next blocks are long. Only stored in long blocks,
+            // false for short blocks.
+            bool isPreviousBlockLong;
+            bool isNextBlockLong;
+        };
+
+        /**
+        * Buffers used while decoding a packet. A Workspace can be reused for any number of
+        * packets, but must not be used by several threads at once.
+        */
+        struct Workspace {
+            // Y values of each channel's floor.
+            std::vector<int16_t> floorValues;
+
+            // Rendered floor curve of one channel, as indices into the inverse dB table.
+            std::vector<uint8_t> floorCurve;
+
+            // Whether each channel's floor is used, and whether its residue is decoded.
+            std::vector<uint8_t> isFloorUsed;
+            std::vector<uint8_t> isResidueUsed;
+
+            // Classifications of the partitions of each channel of a residue.
+            std::vector<uint8_t> classifications;
+
+            // Residue vector of type 2 residues, which interleave the channels.
+            std::vector<float> interleavedResidue;
+
+            // Scratch space of the inverse MDCT.
+            std::vector<float> imdctScratch;
+        };
+
+    private:
+        const VorbisIdentification identification_;
+        const VorbisSetup setup_;
+        const VorbisDspKernels& kernels_;
+        const unsigned int modeBits_;
+
+        // Inverse MDCT plans for short and long blocks.
+        std::array<std::shared_ptr<const VorbisImdct>, 2> imdcts_;
+
+        /**
+        * Reads the Y values of a floor. Returns false if the floor is unused.
+        */
+        bool decodeFloor(BitReader& reader, const VorbisFloor1& floor, int16_t* const values) const;
+
+        /**
+        * Turns the Y values of a floor into the floor curve and multiplies it with the residue.
+        */
+        void applyFloor(const VorbisFloor1& floor, const int16_t* const values, float* const spectrum, const std::size_t size, Workspace& workspace) const;
+
+        /**
+        * Decodes a residue and adds it to the vectors of the given channels. Channels
+        * for which isUsed is 0 are skipped.
+        */
+        void decodeResidue(
+            BitReader& reader,
+            const VorbisResidue& residue,
+            float* const* const vectors,
+            const uint8_t* const isUsed,
+            const std::size_t numChannels,
+            const std::size_t size,
+            Workspace& workspace) const;
+
+    public:
+        /**
+        * Constructs a VorbisDecoder for a stream with the given headers.
+        *
+        * @param identification The identification header.
+        * @param setup The setup header.
+        * @param kernels The signal processing kernels to use.
+        */
+        VorbisDecoder(
+            const VorbisIdentification& identification,
+            VorbisSetup setup,
+            const VorbisDspKernels& kernels = getVorbisDspKernels());
+
+        const VorbisIdentification& getIdentification() const {
+            return identification_;
+        }
+
+        const VorbisSetup& getSetup() const {
+            return setup_;
+        }
+
+        /**
+        * Returns the block size of a packet.
+        */
+        std::size_t getBlockSize(const PacketHeader& header) const {
+            return identification_.blockSizes[header.blockFlag ? 1 : 0];
+        }
+
+        /**
+        * Returns the inverse MDCT plan for the block size of a packet. Plans are shared
+        * with all other decoders that use the same block size.
+        */
+        const VorbisImdct& getImdct(const PacketHeader& header) const {
+            return *imdcts_[header.blockFlag ? 1 : 0];
+        }
+
+        /**
+        * Reads the fields at the beginning of an audio packet. Returns false if the packet
+        * is not an audio packet or refers to a mode that does not exist. Such packets are
+        * skipped by decoders.
+        */
+        bool readPacketHeader(BitReader& reader, PacketHeader& header) const;
+
+        /**
+        * Decodes the rest of an audio packet into the spectrum of each channel. The spectrum
+        * of channel c has getBlockSize(header) / 2 values and starts at spectra + c * stride.
+        * If the packet ends early, the parts that were not decoded are zero, as the
+        * specification requires.
+        *
+        * @param reader The packet, positioned after the header.
+        * @param header The header read by readPacketHeader().
+        * @param spectra Output for the spectra.
+        * @param stride Distance between the spectra of two channels.
+        * @param workspace Buffers to use while decoding.
+        */
+        void decodeSpectrum(
+            BitReader& reader,
+            const PacketHeader& header,
+            float* const spectra,
+            const std::size_t stride,
+            Workspace& workspace) const;
+
+        /**
+        * Decodes the rest of an audio packet into the samples of each channel, before
+        * windowing. The samples of channel c start at blocks + c * stride, and there are
+        * getBlockSize(header) of them. The spectra are decoded into the same place and
+        * transformed in place, so no other buffers are involved.
+        *
+        * @param reader The packet, positioned after the header.
+        * @param header The header read by readPacketHeader().
+        * @param blocks Output for the samples.
+        * @param stride Distance between the samples of two channels, at least getBlockSize(header).
+        * @param workspace Buffers to use while decoding.
+        */
+        void decodeBlock(
+            BitReader& reader,
+            const PacketHeader& header,
+            float* const blocks,
+            const std::size_t stride,
+            Workspace& workspace) const;
+    };
+}
+
+#endif
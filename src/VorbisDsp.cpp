@@ -0,0 +1,878 @@
+#include "VorbisDsp.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#   define VCPP_DSP_X86
+#   include <immintrin.h>
+#   if defined(_MSC_VER) && !defined(__clang__)
+#       include <intrin.h>
+#       define VCPP_AVX2_TARGET
+#   else
+#       include <cpuid.h>
+#       define VCPP_AVX2_TARGET __attribute__((target("avx2")))
+#   endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   define VCPP_DSP_ARM
+#   include <arm_neon.h>
+#endif
+
+using namespace vcpp;
+
+// floor1_inverse_dB_table from the Vorbis specification.
+alignas(64) static const float inverseDbTable[256]{
+    1.06498632e-07f, 1.13419510e-07f, 1.20790148e-07f, 1.28639783e-07f,
+    1.36999503e-07f, 1.45902504e-07f, 1.55384086e-07f, 1.65481808e-07f,
+    1.76235744e-07f, 1.87688556e-07f, 1.99885605e-07f, 2.12875307e-07f,
+    2.26709133e-07f, 2.41441967e-07f, 2.57132228e-07f, 2.73842119e-07f,
+    2.91637917e-07f, 3.10590224e-07f, 3.30774100e-07f, 3.52269666e-07f,
+    3.75162131e-07f, 3.99542301e-07f, 4.25506812e-07f, 4.53158634e-07f,
+    4.82607447e-07f, 5.13970008e-07f, 5.47370632e-07f, 5.82941880e-07f,
+    6.20824721e-07f, 6.61169395e-07f, 7.04135914e-07f, 7.49894639e-07f,
+    7.98627013e-07f, 8.50526305e-07f, 9.05798288e-07f, 9.64662149e-07f,
+    1.02735135e-06f, 1.09411440e-06f, 1.16521608e-06f, 1.24093845e-06f,
+    1.32158164e-06f, 1.40746545e-06f, 1.49893049e-06f, 1.59633942e-06f,
+    1.70007854e-06f, 1.81055918e-06f, 1.92821949e-06f, 2.05352603e-06f,
+    2.18697573e-06f, 2.32909770e-06f, 2.48045581e-06f, 2.64164964e-06f,
+    2.81331904e-06f, 2.99614430e-06f, 3.19085052e-06f, 3.39821008e-06f,
+    3.61904495e-06f, 3.85423073e-06f, 4.10470057e-06f, 4.37144718e-06f,
+    4.65552830e-06f, 4.95807080e-06f, 5.28027385e-06f, 5.62341620e-06f,
+    5.98885708e-06f, 6.37804669e-06f, 6.79252844e-06f, 7.23394533e-06f,
+    7.70404768e-06f, 8.20469995e-06f, 8.73788758e-06f, 9.30572514e-06f,
+    9.91046363e-06f, 1.05545014e-05f, 1.12403923e-05f, 1.19708557e-05f,
+    1.27487892e-05f, 1.35772780e-05f, 1.44596061e-05f, 1.53992714e-05f,
+    1.64000048e-05f, 1.74657689e-05f, 1.86007928e-05f, 1.98095768e-05f,
+    2.10969138e-05f, 2.24679115e-05f, 2.39280016e-05f, 2.54829774e-05f,
+    2.71390054e-05f, 2.89026502e-05f, 3.07809096e-05f, 3.27812268e-05f,
+    3.49115326e-05f, 3.71802817e-05f, 3.95964671e-05f, 4.21696677e-05f,
+    4.49100917e-05f, 4.78286020e-05f, 5.09367746e-05f, 5.42469315e-05f,
+    5.77722021e-05f, 6.15265672e-05f, 6.55249096e-05f, 6.97830837e-05f,
+    7.43179844e-05f, 7.91475832e-05f, 8.42910376e-05f, 8.97687496e-05f,
+    9.56024232e-05f, 1.01815211e-04f, 1.08431741e-04f, 1.15478237e-04f,
+    1.22982674e-04f, 1.30974775e-04f, 1.39486248e-04f, 1.48550855e-04f,
+    1.58204537e-04f, 1.68485552e-04f, 1.79434690e-04f, 1.91095358e-04f,
+    2.03513817e-04f, 2.16739296e-04f, 2.30824226e-04f, 2.45824485e-04f,
+    2.61799549e-04f, 2.78812746e-04f, 2.96931568e-04f, 3.16227874e-04f,
+    3.36778146e-04f, 3.58663878e-04f, 3.81971884e-04f, 4.06794570e-04f,
+    4.33230365e-04f, 4.61384101e-04f, 4.91367478e-04f, 5.23299270e-04f,
+    5.57306223e-04f, 5.93523087e-04f, 6.32093579e-04f, 6.73170609e-04f,
+    7.16916984e-04f, 7.63506279e-04f, 8.13123246e-04f, 8.65964568e-04f,
+    9.22239851e-04f, 9.82172205e-04f, 1.04599923e-03f, 1.11397426e-03f,
+    1.18636654e-03f, 1.26346329e-03f, 1.34557020e-03f, 1.43301289e-03f,
+    1.52613816e-03f, 1.62531529e-03f, 1.73093739e-03f, 1.84342347e-03f,
+    1.96321961e-03f, 2.09080055e-03f, 2.22667260e-03f, 2.37137428e-03f,
+    2.52547953e-03f, 2.68959929e-03f, 2.86438479e-03f, 3.05052870e-03f,
+    3.24876909e-03f, 3.45989247e-03f, 3.68473586e-03f, 3.92419053e-03f,
+    4.17920668e-03f, 4.45079478e-03f, 4.74003283e-03f, 5.04806684e-03f,
+    5.37611870e-03f, 5.72548900e-03f, 6.09756354e-03f, 6.49381755e-03f,
+    6.91582263e-03f, 7.36525143e-03f, 7.84388743e-03f, 8.35362729e-03f,
+    8.89649242e-03f, 9.47463699e-03f, 1.00903520e-02f, 1.07460804e-02f,
+    1.14444206e-02f, 1.21881440e-02f, 1.29801976e-02f, 1.38237253e-02f,
+    1.47220679e-02f, 1.56787913e-02f, 1.66976862e-02f, 1.77827962e-02f,
+    1.89384222e-02f, 2.01691482e-02f, 2.14798544e-02f, 2.28757355e-02f,
+    2.43623294e-02f, 2.59455312e-02f, 2.76316181e-02f, 2.94272769e-02f,
+    3.13396268e-02f, 3.33762504e-02f, 3.55452262e-02f, 3.78551558e-02f,
+    4.03151996e-02f, 4.29351069e-02f, 4.57252748e-02f, 4.86967564e-02f,
+    5.18613495e-02f, 5.52315898e-02f, 5.88208511e-02f, 6.26433641e-02f,
+    6.67142794e-02f, 7.10497499e-02f, 7.56669641e-02f, 8.05842280e-02f,
+    8.58210474e-02f, 9.13981795e-02f, 9.73377451e-02f, 1.03663303e-01f,
+    1.10399932e-01f, 1.17574342e-01f, 1.25214979e-01f, 1.33352146e-01f,
+    1.42018124e-01f, 1.51247263e-01f, 1.61076173e-01f, 1.71543807e-01f,
+    1.82691678e-01f, 1.94564015e-01f, 2.07207873e-01f, 2.20673427e-01f,
+    2.35014021e-01f, 2.50286549e-01f, 2.66551584e-01f, 2.83873618e-01f,
+    3.02321315e-01f, 3.21967870e-01f, 3.42891127e-01f, 3.65174145e-01f,
+    3.88905197e-01f, 4.14178461e-01f, 4.41094130e-01f, 4.69758898e-01f,
+    5.00286460e-01f, 5.32797933e-01f, 5.67422092e-01f, 6.04296386e-01f,
+    6.43566966e-01f, 6.85389578e-01f, 7.29930043e-01f, 7.77365029e-01f,
+    8.27882588e-01f, 8.81683052e-01f, 9.38979805e-01f, 1.00000000e+00f,
+};
+
+float vcpp::vorbisInverseDb(const uint8_t value) {
+    return inverseDbTable[value];
+}
+
+//----------------------------------------------
+//                 Scalar
+//----------------------------------------------
+
+static void applyFloorScalar(float* const residue, const uint8_t* const floor, const std::size_t size) {
+    for (std::size_t i{ 0 }; i < size; i++) {
+        residue[i] *= inverseDbTable[floor[i]];
+    }
+}
+
+// The square polar mapping is reverted without branching on the signs of both values. With
+// t = (magnitude > 0 ? angle : -angle), a positive angle keeps the magnitude and yields
+// magnitude - t as the second channel. Otherwise, the magnitude becomes the second channel
+// and magnitude + t the first. This gives the same results as the specification.
+static void decoupleScalar(float* const magnitude, float* const angle, const std::size_t size) {
+    for (std::size_t i{ 0 }; i < size; i++) {
+        const float m{ magnitude[i] };
+        const float a{ angle[i] };
+        const float t{ m > 0.0f ? a : -a };
+        if (a > 0.0f) {
+            angle[i] = m - t;
+        }
+        else {
+            magnitude[i] = m + t;
+            angle[i] = m;
+        }
+    }
+}
+
+static void deinterleaveScalar(const float* const in, float* const* const out, const std::size_t numChannels, const std::size_t size) {
+    for (std::size_t channel{ 0 }; channel < numChannels; channel++) {
+        float* const channelOut{ out[channel] };
+        for (std::size_t i{ 0 }; i < size; i++) {
+            channelOut[i] = in[i * numChannels + channel];
+        }
+    }
+}
+
+// Radix-4 butterflies for the groups of four at j, j + span, j + 2 * span and j + 3 * span
+// of each block. Two radix-2 steps are combined: the first with the
+// twiddle factor w1 between the pairs (0, 1) and (2, 3), the second with w2 between (0, 2)
+// and i * w2 between (1, 3).
+static void fftPassScalar(float* const real, float* const imaginary, const float* const twiddles, const std::size_t size, const std::size_t span) {
+    const float* const w1Real{ twiddles };
+    const float* const w1Imaginary{ twiddles + span };
+    const float* const w2Real{ twiddles + 2 * span };
+    const float* const w2Imaginary{ twiddles + 3 * span };
+    for (std::size_t block{ 0 }; block < size; block += 4 * span) {
+        float* const re{ real + block };
+        float* const im{ imaginary + block };
+        for (std::size_t j{ 0 }; j < span; j++) {
+            const float t1Real{ re[j + span] * w1Real[j] - im[j + span] * w1Imaginary[j] };
+            const float t1Imaginary{ re[j + span] * w1Imaginary[j] + im[j + span] * w1Real[j] };
+            const float t3Real{ re[j + 3 * span] * w1Real[j] - im[j + 3 * span] * w1Imaginary[j] };
+            const float t3Imaginary{ re[j + 3 * span] * w1Imaginary[j] + im[j + 3 * span] * w1Real[j] };
+
+            const float b0Real{ re[j] + t1Real };
+            const float b0Imaginary{ im[j] + t1Imaginary };
+            const float b1Real{ re[j] - t1Real };
+            const float b1Imaginary{ im[j] - t1Imaginary };
+            const float b2Real{ re[j + 2 * span] + t3Real };
+            const float b2Imaginary{ im[j + 2 * span] + t3Imaginary };
+            const float b3Real{ re[j + 2 * span] - t3Real };
+            const float b3Imaginary{ im[j + 2 * span] - t3Imaginary };
+
+            const float u2Real{ b2Real * w2Real[j] - b2Imaginary * w2Imaginary[j] };
+            const float u2Imaginary{ b2Real * w2Imaginary[j] + b2Imaginary * w2Real[j] };
+            // i * w2 * b3
+            const float u3Real{ -(b3Real * w2Imaginary[j] + b3Imaginary * w2Real[j]) };
+            const float u3Imaginary{ b3Real * w2Real[j] - b3Imaginary * w2Imaginary[j] };
+
+            re[j] = b0Real + u2Real;
+            im[j] = b0Imaginary + u2Imaginary;
+            re[j + 2 * span] = b0Real - u2Real;
+            im[j + 2 * span] = b0Imaginary - u2Imaginary;
+            re[j + span] = b1Real + u3Real;
+            im[j + span] = b1Imaginary + u3Imaginary;
+            re[j + 3 * span] = b1Real - u3Real;
+            im[j + 3 * span] = b1Imaginary - u3Imaginary;
+        }
+    }
+}
+
+// Scales a sample to 16 bit. The comparisons are ordered like the SIMD min and max
+// instructions, so that all kernels clamp NaN to the same value.
+static inline int16_t toInt16Scalar(const float sample) {
+    float scaled{ sample * 32768.0f };
+    scaled = scaled < 32767.0f ? scaled : 32767.0f;
+    scaled = scaled > -32768.0f ? scaled : -32768.0f;
+    return int16_t(std::lrint(scaled));
+}
+
+static inline void storeSampleScalar(float* const out, const float sample) {
+    *out = sample;
+}
+
+static inline void storeSampleScalar(int16_t* const out, const float sample) {
+    *out = toInt16Scalar(sample);
+}
+
+// Kernels for frames [first, size), so that the SIMD kernels can use them for the rest.
+template <typename Sample>
+static void overlapAddRangeScalar(
+    const float* const* const previous,
+    const float* const* const current,
+    const float* const rising,
+    const float* const falling,
+    const std::size_t numChannels,
+    const std::size_t first,
+    const std::size_t size,
+    Sample* const out) {
+    for (std::size_t channel{ 0 }; channel < numChannels; channel++) {
+        const float* const channelPrevious{ previous[channel] };
+        const float* const channelCurrent{ current[channel] };
+        for (std::size_t i{ first }; i < size; i++) {
+            const float sample{ channelPrevious[i] * falling[i] + channelCurrent[i] * rising[i] };
+            storeSampleScalar(out + i * numChannels + channel, sample);
+        }
+    }
+}
+
+template <typename Sample>
+static void interleaveRangeScalar(const float* const* const in, const std::size_t numChannels, const std::size_t first, const std::size_t size, Sample* const out) {
+    for (std::size_t channel{ 0 }; channel < numChannels; channel++) {
+        const float* const channelIn{ in[channel] };
+        for (std::size_t i{ first }; i < size; i++) {
+            storeSampleScalar(out + i * numChannels + channel, channelIn[i]);
+        }
+    }
+}
+
+template <typename Sample>
+static void overlapAddScalar(
+    const float* const* const previous,
+    const float* const* const current,
+    const float* const rising,
+    const float* const falling,
+    const std::size_t numChannels,
+    const std::size_t size,
+    Sample* const out) {
+    overlapAddRangeScalar(previous, current, rising, falling, numChannels, 0, size, out);
+}
+
+template <typename Sample>
+static void interleaveScalar(const float* const* const in, const std::size_t numChannels, const std::size_t size, Sample* const out) {
+    interleaveRangeScalar(in, numChannels, 0, size, out);
+}
+
+static const VorbisDspKernels scalarKernels{
+    "Scalar",
+    applyFloorScalar,
+    decoupleScalar,
+    deinterleaveScalar,
+    fftPassScalar,
+    overlapAddScalar<float>,
+    overlapAddScalar<int16_t>,
+    interleaveScalar<float>,
+    interleaveScalar<int16_t>
+};
+
+#if defined(VCPP_DSP_X86)
+
+//----------------------------------------------
+//                 SSE2
+//----------------------------------------------
+
+static void applyFloorSse2(float* const residue, const uint8_t* const floor, const std::size_t size) {
+    std::size_t i{ 0 };
+    for (; i + 4 <= size; i += 4) {
+        const __m128 inverseDb{ _mm_setr_ps(
+            inverseDbTable[floor[i]], inverseDbTable[floor[i + 1]], 
+            inverseDbTable[floor[i + 2]], inverseDbTable[floor[i + 3]]) };
+        _mm_storeu_ps(residue + i, _mm_mul_ps(_mm_loadu_ps(residue + i), inverseDb));
+    }
+    applyFloorScalar(residue + i, floor + i, size - i);
+}
+
+static void decoupleSse2(float* const magnitude, float* const angle, const std::size_t size) {
+    const __m128 zero{ _mm_setzero_ps() };
+    const __m128 signBit{ _mm_set1_ps(-0.0f) };
+    std::size_t i{ 0 };
+    for (; i + 4 <= size; i += 4) {
+        const __m128 m{ _mm_loadu_ps(magnitude + i) };
+        const __m128 a{ _mm_loadu_ps(angle + i) };
+        const __m128 t{ _mm_xor_ps(a, _mm_andnot_ps(_mm_cmpgt_ps(m, zero), signBit)) };
+        const __m128 isAnglePositive{ _mm_cmpgt_ps(a, zero) };
+        _mm_storeu_ps(magnitude + i, _mm_or_ps(
+            _mm_and_ps(isAnglePositive, m), 
+            _mm_andnot_ps(isAnglePositive, _mm_add_ps(m, t))));
+        _mm_storeu_ps(angle + i, _mm_or_ps(
+            _mm_and_ps(isAnglePositive, _mm_sub_ps(m, t)), 
+            _mm_andnot_ps(isAnglePositive, m)));
+    }
+    decoupleScalar(magnitude + i, angle + i, size - i);
+}
+
+static void deinterleaveSse2(const float* const in, float* const* const out, const std::size_t numChannels, const std::size_t size) {
+    if (numChannels != 2) {
+        deinterleaveScalar(in, out, numChannels, size);
+        return;
+    }
+    float* const left{ out[0] };
+    float* const right{ out[1] };
+    std::size_t i{ 0 };
+    for (; i + 4 <= size; i += 4) {
+        const __m128 a{ _mm_loadu_ps(in + 2 * i) };
+        const __m128 b{ _mm_loadu_ps(in + 2 * i + 4) };
+        _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    for (; i < size; i++) {
+        left[i] = in[2 * i];
+        right[i] = in[2 * i + 1];
+    }
+}
+
+static inline void complexMultiplySse2(
+    const __m128 aReal, const __m128 aImaginary, const __m128 bReal, const __m128 bImaginary, 
+    __m128& real, __m128& imaginary
+) {
+    real = _mm_sub_ps(_mm_mul_ps(aReal, bReal), _mm_mul_ps(aImaginary, bImaginary));
+    imaginary = _mm_add_ps(_mm_mul_ps(aReal, bImaginary), _mm_mul_ps(aImaginary, bReal));
+}
+
+static void fftPassSse2(float* const real, float* const imaginary, const float* const twiddles, const std::size_t size, const std::size_t span) {
+    if (span < 4) {
+        fftPassScalar(real, imaginary, twiddles, size, span);
+        return;
+    }
+    const float* const w1Real{ twiddles };
+    const float* const w1Imaginary{ twiddles + span };
+    const float* const w2Real{ twiddles + 2 * span };
+    const float* const w2Imaginary{ twiddles + 3 * span };
+    for (std::size_t block{ 0 }; block < size; block += 4 * span) {
+        float* const re{ real + block };
+        float* const im{ imaginary + block };
+        for (std::size_t j{ 0 }; j + 4 <= span; j += 4) {
+            const __m128 w1r{ _mm_loadu_ps(w1Real + j) };
+            const __m128 w1i{ _mm_loadu_ps(w1Imaginary + j) };
+            const __m128 w2r{ _mm_loadu_ps(w2Real + j) };
+            const __m128 w2i{ _mm_loadu_ps(w2Imaginary + j) };
+
+            __m128 t1r, t1i, t3r, t3i;
+            complexMultiplySse2(_mm_loadu_ps(re + j + span), _mm_loadu_ps(im + j + span), w1r, w1i, t1r, t1i);
+            complexMultiplySse2(_mm_loadu_ps(re + j + 3 * span), _mm_loadu_ps(im + j + 3 * span), w1r, w1i, t3r, t3i);
+
+            const __m128 a0r{ _mm_loadu_ps(re + j) };
+            const __m128 a0i{ _mm_loadu_ps(im + j) };
+            const __m128 a2r{ _mm_loadu_ps(re + j + 2 * span) };
+            const __m128 a2i{ _mm_loadu_ps(im + j + 2 * span) };
+            const __m128 b0r{ _mm_add_ps(a0r, t1r) };
+            const __m128 b0i{ _mm_add_ps(a0i, t1i) };
+            const __m128 b1r{ _mm_sub_ps(a0r, t1r) };
+            const __m128 b1i{ _mm_sub_ps(a0i, t1i) };
+
+            __m128 u2r, u2i, v3r, v3i;
+            complexMultiplySse2(_mm_add_ps(a2r, t3r), _mm_add_ps(a2i, t3i), w2r, w2i, u2r, u2i);
+            complexMultiplySse2(_mm_sub_ps(a2r, t3r), _mm_sub_ps(a2i, t3i), w2r, w2i, v3r, v3i);
+            // u3 = i * v3
+            const __m128 u3r{ _mm_xor_ps(v3i, _mm_set1_ps(-0.0f)) };
+            const __m128 u3i{ v3r };
+
+            _mm_storeu_ps(re + j, _mm_add_ps(b0r, u2r));
+            _mm_storeu_ps(im + j, _mm_add_ps(b0i, u2i));
+            _mm_storeu_ps(re + j + 2 * span, _mm_sub_ps(b0r, u2r));
+            _mm_storeu_ps(im + j + 2 * span, _mm_sub_ps(b0i, u2i));
+            _mm_storeu_ps(re + j + span, _mm_add_ps(b1r, u3r));
+            _mm_storeu_ps(im + j + span, _mm_add_ps(b1i, u3i));
+            _mm_storeu_ps(re + j + 3 * span, _mm_sub_ps(b1r, u3r));
+            _mm_storeu_ps(im + j + 3 * span, _mm_sub_ps(b1i, u3i));
+        }
+    }
+}
+
+static inline __m128i toInt16Sse2(const __m128 samples) {
+    const __m128 scaled{ _mm_mul_ps(samples, _mm_set1_ps(32768.0f)) };
+    return _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(scaled, _mm_set1_ps(32767.0f)), _mm_set1_ps(-32768.0f)));
+}
+
+static inline void storeMonoSse2(float* const out, const __m128 samples) {
+    _mm_storeu_ps(out, samples);
+}
+
+static inline void storeMonoSse2(int16_t* const out, const __m128 samples) {
+    const __m128i converted{ toInt16Sse2(samples) };
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(converted, converted));
+}
+
+static inline void storeStereoSse2(float* const out, const __m128 left, const __m128 right) {
+    _mm_storeu_ps(out, _mm_unpacklo_ps(left, right));
+    _mm_storeu_ps(out + 4, _mm_unpackhi_ps(left, right));
+}
+
+static inline void storeStereoSse2(int16_t* const out, const __m128 left, const __m128 right) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(
+        toInt16Sse2(_mm_unpacklo_ps(left, right)), 
+        toInt16Sse2(_mm_unpackhi_ps(left, right))));
+}
+
+static inline __m128 windowSse2(const float* const previous, const float* const current, const float* const rising, const float* const falling) {
+    return _mm_add_ps(
+        _mm_mul_ps(_mm_loadu_ps(previous), _mm_loadu_ps(falling)),
+        _mm_mul_ps(_mm_loadu_ps(current), _mm_loadu_ps(rising)));
+}
+
+// Mono and stereo are vectorized, other channel layouts use the scalar kernels.
+template <typename Sample>
+static void overlapAddSse2(
+    const float* const* const previous,
+    const float* const* const current,
+    const float* const rising,
+    const float* const falling,
+    const std::size_t numChannels,
+    const std::size_t size,
+    Sample* const out) {
+    std::size_t i{ 0 };
+    if (numChannels == 1) {
+        for (; i + 4 <= size; i += 4) {
+            storeMonoSse2(out + i, windowSse2(previous[0] + i, current[0] + i, rising + i, falling + i));
+        }
+    }
+    else if (numChannels == 2) {
+        for (; i + 4 <= size; i += 4) {
+            storeStereoSse2(out + 2 * i,
+                windowSse2(previous[0] + i, current[0] + i, rising + i, falling + i),
+                windowSse2(previous[1] + i, current[1] + i, rising + i, falling + i));
+        }
+    }
+    overlapAddRangeScalar(previous, current, rising, falling, numChannels, i, size, out);
+}
+
+template <typename Sample>
+static void interleaveSse2(const float* const* const in, const std::size_t numChannels, const std::size_t size, Sample* const out) {
+    std::size_t i{ 0 };
+    if (numChannels == 1) {
+        for (; i + 4 <= size; i += 4) {
+            storeMonoSse2(out + i, _mm_loadu_ps(in[0] + i));
+        }
+    }
+    else if (numChannels == 2) {
+        for (; i + 4 <= size; i += 4) {
+            storeStereoSse2(out + 2 * i, _mm_loadu_ps(in[0] + i), _mm_loadu_ps(in[1] + i));
+        }
+    }
+    interleaveRangeScalar(in, numChannels, i, size, out);
+}
+
+static const VorbisDspKernels sse2Kernels{
+    "SSE2",
+    applyFloorSse2,
+    decoupleSse2,
+    deinterleaveSse2,
+    fftPassSse2,
+    overlapAddSse2<float>,
+    overlapAddSse2<int16_t>,
+    interleaveSse2<float>,
+    interleaveSse2<int16_t>
+};
+
+//----------------------------------------------
+//                 AVX2
+//----------------------------------------------
+
+static bool detectAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    const unsigned int ecx{ static_cast<unsigned int>(info[2]) };
+    __cpuidex(info, 7, 0);
+    const unsigned int ebx{ static_cast<unsigned int>(info[1]) };
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    const unsigned int features{ ecx };
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    ecx = features;
+#endif
+    const unsigned int osxsave{ 1 << 27 };
+    const unsigned int avx{ 1 << 28 };
+    const unsigned int avx2{ 1 << 5 };
+    if ((ecx & osxsave) == 0 || (ecx & avx) == 0 || (ebx & avx2) == 0) {
+        return false;
+    }
+
+    // The operating system has to save the YMM registers on context switches.
+#if defined(_MSC_VER) && !defined(__clang__)
+    const uint64_t enabledState{ _xgetbv(0) };
+#else
+    uint32_t enabledStateLow, enabledStateHigh;
+    __asm__("xgetbv" : "=a"(enabledStateLow), "=d"(enabledStateHigh) : "c"(0));
+    const uint64_t enabledState{ enabledStateLow };
+#endif
+    return (enabledState & 0x6) == 0x6;
+}
+
+VCPP_AVX2_TARGET static void applyFloorAvx2(float* const residue, const uint8_t* const floor, const std::size_t size) {
+    std::size_t i{ 0 };
+    for (; i + 8 <= size; i += 8) {
+        const __m256i indices{ _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(floor + i))) };
+        const __m256 inverseDb{ _mm256_i32gather_ps(inverseDbTable, indices, 4) };
+        _mm256_storeu_ps(residue + i, _mm256_mul_ps(_mm256_loadu_ps(residue + i), inverseDb));
+    }
+    applyFloorScalar(residue + i, floor + i, size - i);
+}
+
+VCPP_AVX2_TARGET static void decoupleAvx2(float* const magnitude, float* const angle, const std::size_t size) {
+    const __m256 zero{ _mm256_setzero_ps() };
+    const __m256 signBit{ _mm256_set1_ps(-0.0f) };
+    std::size_t i{ 0 };
+    for (; i + 8 <= size; i += 8) {
+        const __m256 m{ _mm256_loadu_ps(magnitude + i) };
+        const __m256 a{ _mm256_loadu_ps(angle + i) };
+        const __m256 t{ _mm256_xor_ps(a, _mm256_andnot_ps(_mm256_cmp_ps(m, zero, _CMP_GT_OQ), signBit)) };
+        const __m256 isAnglePositive{ _mm256_cmp_ps(a, zero, _CMP_GT_OQ) };
+        _mm256_storeu_ps(magnitude + i, _mm256_blendv_ps(_mm256_add_ps(m, t), m, isAnglePositive));
+        _mm256_storeu_ps(angle + i, _mm256_blendv_ps(m, _mm256_sub_ps(m, t), isAnglePositive));
+    }
+    decoupleScalar(magnitude + i, angle + i, size - i);
+}
+
+VCPP_AVX2_TARGET static inline void complexMultiplyAvx2(
+    const __m256 aReal, const __m256 aImaginary, const __m256 bReal, const __m256 bImaginary, 
+    __m256& real, __m256& imaginary
+) {
+    real = _mm256_sub_ps(_mm256_mul_ps(aReal, bReal), _mm256_mul_ps(aImaginary, bImaginary));
+    imaginary = _mm256_add_ps(_mm256_mul_ps(aReal, bImaginary), _mm256_mul_ps(aImaginary, bReal));
+}
+
+VCPP_AVX2_TARGET static void fftPassAvx2(float* const real, float* const imaginary, const float* const twiddles, const std::size_t size, const std::size_t span) {
+    if (span < 8) {
+        fftPassSse2(real, imaginary, twiddles, size, span);
+        return;
+    }
+    const float* const w1Real{ twiddles };
+    const float* const w1Imaginary{ twiddles + span };
+    const float* const w2Real{ twiddles + 2 * span };
+    const float* const w2Imaginary{ twiddles + 3 * span };
+    for (std::size_t block{ 0 }; block < size; block += 4 * span) {
+        float* const re{ real + block };
+        float* const im{ imaginary + block };
+        for (std::size_t j{ 0 }; j + 8 <= span; j += 8) {
+            const __m256 w1r{ _mm256_loadu_ps(w1Real + j) };
+            const __m256 w1i{ _mm256_loadu_ps(w1Imaginary + j) };
+            const __m256 w2r{ _mm256_loadu_ps(w2Real + j) };
+            const __m256 w2i{ _mm256_loadu_ps(w2Imaginary + j) };
+
+            __m256 t1r, t1i, t3r, t3i;
+            complexMultiplyAvx2(_mm256_loadu_ps(re + j + span), _mm256_loadu_ps(im + j + span), w1r, w1i, t1r, t1i);
+            complexMultiplyAvx2(_mm256_loadu_ps(re + j + 3 * span), _mm256_loadu_ps(im + j + 3 * span), w1r, w1i, t3r, t3i);
+
+            const __m256 a0r{ _mm256_loadu_ps(re + j) };
+            const __m256 a0i{ _mm256_loadu_ps(im + j) };
+            const __m256 a2r{ _mm256_loadu_ps(re + j + 2 * span) };
+            const __m256 a2i{ _mm256_loadu_ps(im + j + 2 * span) };
+            const __m256 b0r{ _mm256_add_ps(a0r, t1r) };
+            const __m256 b0i{ _mm256_add_ps(a0i, t1i) };
+            const __m256 b1r{ _mm256_sub_ps(a0r, t1r) };
+            const __m256 b1i{ _mm256_sub_ps(a0i, t1i) };
+
+            __m256 u2r, u2i, v3r, v3i;
+            complexMultiplyAvx2(_mm256_add_ps(a2r, t3r), _mm256_add_ps(a2i, t3i), w2r, w2i, u2r, u2i);
+            complexMultiplyAvx2(_mm256_sub_ps(a2r, t3r), _mm256_sub_ps(a2i, t3i), w2r, w2i, v3r, v3i);
+            // u3 = i * v3
+            const __m256 u3r{ _mm256_xor_ps(v3i, _mm256_set1_ps(-0.0f)) };
+            const __m256 u3i{ v3r };
+
+            _mm256_storeu_ps(re + j, _mm256_add_ps(b0r, u2r));
+            _mm256_storeu_ps(im + j, _mm256_add_ps(b0i, u2i));
+            _mm256_storeu_ps(re + j + 2 * span, _mm256_sub_ps(b0r, u2r));
+            _mm256_storeu_ps(im + j + 2 * span, _mm256_sub_ps(b0i, u2i));
+            _mm256_storeu_ps(re + j + span, _mm256_add_ps(b1r, u3r));
+            _mm256_storeu_ps(im + j + span, _mm256_add_ps(b1i, u3i));
+            _mm256_storeu_ps(re + j + 3 * span, _mm256_sub_ps(b1r, u3r));
+            _mm256_storeu_ps(im + j + 3 * span, _mm256_sub_ps(b1i, u3i));
+        }
+    }
+}
+
+VCPP_AVX2_TARGET static inline __m256i toInt16Avx2(const __m256 samples) {
+    const __m256 scaled{ _mm256_mul_ps(samples, _mm256_set1_ps(32768.0f)) };
+    return _mm256_cvtps_epi32(_mm256_max_ps(_mm256_min_ps(scaled, _mm256_set1_ps(32767.0f)), _mm256_set1_ps(-32768.0f)));
+}
+
+VCPP_AVX2_TARGET static inline void storeMonoAvx2(float* const out, const __m256 samples) {
+    _mm256_storeu_ps(out, samples);
+}
+
+VCPP_AVX2_TARGET static inline void storeMonoAvx2(int16_t* const out, const __m256 samples) {
+    const __m256i converted{ toInt16Avx2(samples) };
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(
+        _mm256_castsi256_si128(converted), 
+        _mm256_extracti128_si256(converted, 1)));
+}
+
+// The unpack instructions work within 128 bit lanes, so the halves are put in order afterwards.
+VCPP_AVX2_TARGET static inline void storeStereoAvx2(float* const out, const __m256 left, const __m256 right) {
+    const __m256 low{ _mm256_unpacklo_ps(left, right) };
+    const __m256 high{ _mm256_unpackhi_ps(left, right) };
+    _mm256_storeu_ps(out, _mm256_permute2f128_ps(low, high, 0x20));
+    _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(low, high, 0x31));
+}
+
+VCPP_AVX2_TARGET static inline void storeStereoAvx2(int16_t* const out, const __m256 left, const __m256 right) {
+    const __m256 low{ _mm256_unpacklo_ps(left, right) };
+    const __m256 high{ _mm256_unpackhi_ps(left, right) };
+    const __m256i packed{ _mm256_packs_epi32(
+        toInt16Avx2(_mm256_permute2f128_ps(low, high, 0x20)),
+        toInt16Avx2(_mm256_permute2f128_ps(low, high, 0x31))) };
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+VCPP_AVX2_TARGET static inline __m256 windowAvx2(const float* const previous, const float* const current, const float* const rising, const float* const falling) {
+    return _mm256_add_ps(
+        _mm256_mul_ps(_mm256_loadu_ps(previous), _mm256_loadu_ps(falling)),
+        _mm256_mul_ps(_mm256_loadu_ps(current), _mm256_loadu_ps(rising)));
+}
+
+template <typename Sample>
+VCPP_AVX2_TARGET static void overlapAddAvx2(
+    const float* const* const previous,
+    const float* const* const current,
+    const float* const rising,
+    const float* const falling,
+    const std::size_t numChannels,
+    const std::size_t size,
+    Sample* const out) {
+    std::size_t i{ 0 };
+    if (numChannels == 1) {
+        for (; i + 8 <= size; i += 8) {
+            storeMonoAvx2(out + i, windowAvx2(previous[0] + i, current[0] + i, rising + i, falling + i));
+        }
+    }
+    else if (numChannels == 2) {
+        for (; i + 8 <= size; i += 8) {
+            storeStereoAvx2(out + 2 * i,
+                windowAvx2(previous[0] + i, current[0] + i, rising + i, falling + i),
+                windowAvx2(previous[1] + i, current[1] + i, rising + i, falling + i));
+        }
+    }
+    overlapAddRangeScalar(previous, current, rising, falling, numChannels, i, size, out);
+}
+
+template <typename Sample>
+VCPP_AVX2_TARGET static void interleaveAvx2(const float* const* const in, const std::size_t numChannels, const std::size_t size, Sample* const out) {
+    std::size_t i{ 0 };
+    if (numChannels == 1) {
+        for (; i + 8 <= size; i += 8) {
+            storeMonoAvx2(out + i, _mm256_loadu_ps(in[0] + i));
+        }
+    }
+    else if (numChannels == 2) {
+        for (; i + 8 <= size; i += 8) {
+            storeStereoAvx2(out + 2 * i, _mm256_loadu_ps(in[0] + i), _mm256_loadu_ps(in[1] + i));
+        }
+    }
+    interleaveRangeScalar(in, numChannels, i, size, out);
+}
+
+static const VorbisDspKernels avx2Kernels{
+    "AVX2",
+    applyFloorAvx2,
+    decoupleAvx2,
+    deinterleaveSse2,
+    fftPassAvx2,
+    overlapAddAvx2<float>,
+    overlapAddAvx2<int16_t>,
+    interleaveAvx2<float>,
+    interleaveAvx2<int16_t>
+};
+
+const VorbisDspKernels& vcpp::getVorbisDspKernels() {
+    static const VorbisDspKernels& kernels{ detectAvx2() ? avx2Kernels : sse2Kernels };
+    return kernels;
+}
+
+#elif defined(VCPP_DSP_ARM)
+
+//----------------------------------------------
+//                 NEON
+//----------------------------------------------
+
+static void applyFloorNeon(float* const residue, const uint8_t* const floor, const std::size_t size) {
+    std::size_t i{ 0 };
+    for (; i + 4 <= size; i += 4) {
+        const float inverseDbValues[4]{
+            inverseDbTable[floor[i]], inverseDbTable[floor[i + 1]], 
+            inverseDbTable[floor[i + 2]], inverseDbTable[floor[i + 3]] };
+        vst1q_f32(residue + i, vmulq_f32(vld1q_f32(residue + i), vld1q_f32(inverseDbValues)));
+    }
+    applyFloorScalar(residue + i, floor + i, size - i);
+}
+
+static void decoupleNeon(float* const magnitude, float* const angle, const std::size_t size) {
+    const float32x4_t zero{ vdupq_n_f32(0.0f) };
+    const uint32x4_t signBit{ vdupq_n_u32(0x80000000) };
+    std::size_t i{ 0 };
+    for (; i + 4 <= size; i += 4) {
+        const float32x4_t m{ vld1q_f32(magnitude + i) };
+        const float32x4_t a{ vld1q_f32(angle + i) };
+        const float32x4_t t{ vreinterpretq_f32_u32(veorq_u32(
+            vreinterpretq_u32_f32(a), vbicq_u32(signBit, vcgtq_f32(m, zero)))) };
+        const uint32x4_t isAnglePositive{ vcgtq_f32(a, zero) };
+        vst1q_f32(magnitude + i, vbslq_f32(isAnglePositive, m, vaddq_f32(m, t)));
+        vst1q_f32(angle + i, vbslq_f32(isAnglePositive, vsubq_f32(m, t), m));
+    }
+    decoupleScalar(magnitude + i, angle + i, size - i);
+}
+
+static void deinterleaveNeon(const float* const in, float* const* const out, const std::size_t numChannels, const std::size_t size) {
+    if (numChannels != 2) {
+        deinterleaveScalar(in, out, numChannels, size);
+        return;
+    }
+    float* const left{ out[0] };
+    float* const right{ out[1] };
+    std::size_t i{ 0 };
+    for (; i + 4 <= size; i += 4) {
+        const float32x4x2_t values{ vld2q_f32(in + 2 * i) };
+        vst1q_f32(left + i, values.val[0]);
+        vst1q_f32(right + i, values.val[1]);
+    }
+    for (; i < size; i++) {
+        left[i] = in[2 * i];
+        right[i] = in[2 * i + 1];
+    }
+}
+
+static inline void complexMultiplyNeon(
+    const float32x4_t aReal, const float32x4_t aImaginary, const float32x4_t bReal, const float32x4_t bImaginary, 
+    float32x4_t& real, float32x4_t& imaginary
+) {
+    real = vsubq_f32(vmulq_f32(aReal, bReal), vmulq_f32(aImaginary, bImaginary));
+    imaginary = vaddq_f32(vmulq_f32(aReal, bImaginary), vmulq_f32(aImaginary, bReal));
+}
+
+static void fftPassNeon(float* const real, float* const imaginary, const float* const twiddles, const std::size_t size, const std::size_t span) {
+    if (span < 4) {
+        fftPassScalar(real, imaginary, twiddles, size, span);
+        return;
+    }
+    const float* const w1Real{ twiddles };
+    const float* const w1Imaginary{ twiddles + span };
+    const float* const w2Real{ twiddles + 2 * span };
+    const float* const w2Imaginary{ twiddles + 3 * span };
+    for (std::size_t block{ 0 }; block < size; block += 4 * span) {
+        float* const re{ real + block };
+        float* const im{ imaginary + block };
+        for (std::size_t j{ 0 }; j + 4 <= span; j += 4) {
+            const float32x4_t w1r{ vld1q_f32(w1Real + j) };
+            const float32x4_t w1i{ vld1q_f32(w1Imaginary + j) };
+            const float32x4_t w2r{ vld1q_f32(w2Real + j) };
+            const float32x4_t w2i{ vld1q_f32(w2Imaginary + j) };
+
+            float32x4_t t1r, t1i, t3r, t3i;
+            complexMultiplyNeon(vld1q_f32(re + j + span), vld1q_f32(im + j + span), w1r, w1i, t1r, t1i);
+            complexMultiplyNeon(vld1q_f32(re + j + 3 * span), vld1q_f32(im + j + 3 * span), w1r, w1i, t3r, t3i);
+
+            const float32x4_t a0r{ vld1q_f32(re + j) };
+            const float32x4_t a0i{ vld1q_f32(im + j) };
+            const float32x4_t a2r{ vld1q_f32(re + j + 2 * span) };
+            const float32x4_t a2i{ vld1q_f32(im + j + 2 * span) };
+            const float32x4_t b0r{ vaddq_f32(a0r, t1r) };
+            const float32x4_t b0i{ vaddq_f32(a0i, t1i) };
+            const float32x4_t b1r{ vsubq_f32(a0r, t1r) };
+            const float32x4_t b1i{ vsubq_f32(a0i, t1i) };
+
+            float32x4_t u2r, u2i, v3r, v3i;
+            complexMultiplyNeon(vaddq_f32(a2r, t3r), vaddq_f32(a2i, t3i), w2r, w2i, u2r, u2i);
+            complexMultiplyNeon(vsubq_f32(a2r, t3r), vsubq_f32(a2i, t3i), w2r, w2i, v3r, v3i);
+            // u3 = i * v3
+            const float32x4_t u3r{ vnegq_f32(v3i) };
+            const float32x4_t u3i{ v3r };
+
+            vst1q_f32(re + j, vaddq_f32(b0r, u2r));
+            vst1q_f32(im + j, vaddq_f32(b0i, u2i));
+            vst1q_f32(re + j + 2 * span, vsubq_f32(b0r, u2r));
+            vst1q_f32(im + j + 2 * span, vsubq_f32(b0i, u2i));
+            vst1q_f32(re + j + span, vaddq_f32(b1r, u3r));
+            vst1q_f32(im + j + span, vaddq_f32(b1i, u3i));
+            vst1q_f32(re + j + 3 * span, vsubq_f32(b1r, u3r));
+            vst1q_f32(im + j + 3 * span, vsubq_f32(b1i, u3i));
+        }
+    }
+}
+
+// vminnmq and vmaxnmq return the number if one operand is NaN, like the x86 kernels.
+static inline int32x4_t toInt16Neon(const float32x4_t samples) {
+    const float32x4_t scaled{ vmulq_f32(samples, vdupq_n_f32(32768.0f)) };
+    return vcvtnq_s32_f32(vmaxnmq_f32(vminnmq_f32(scaled, vdupq_n_f32(32767.0f)), vdupq_n_f32(-32768.0f)));
+}
+
+static inline void storeMonoNeon(float* const out, const float32x4_t samples) {
+    vst1q_f32(out, samples);
+}
+
+static inline void storeMonoNeon(int16_t* const out, const float32x4_t samples) {
+    vst1_s16(out, vqmovn_s32(toInt16Neon(samples)));
+}
+
+static inline void storeStereoNeon(float* const out, const float32x4_t left, const float32x4_t right) {
+    vst2q_f32(out, float32x4x2_t{ { left, right } });
+}
+
+static inline void storeStereoNeon(int16_t* const out, const float32x4_t left, const float32x4_t right) {
+    vst2_s16(out, int16x4x2_t{ { vqmovn_s32(toInt16Neon(left)), vqmovn_s32(toInt16Neon(right)) } });
+}
+
+static inline float32x4_t windowNeon(const float* const previous, const float* const current, const float* const rising, const float* const falling) {
+    return vaddq_f32(
+        vmulq_f32(vld1q_f32(previous), vld1q_f32(falling)),
+        vmulq_f32(vld1q_f32(current), vld1q_f32(rising)));
+}
+
+template <typename Sample>
+static void overlapAddNeon(
+    const float* const* const previous,
+    const float* const* const current,
+    const float* const rising,
+    const float* const falling,
+    const std::size_t numChannels,
+    const std::size_t size,
+    Sample* const out) {
+    std::size_t i{ 0 };
+    if (numChannels == 1) {
+        for (; i + 4 <= size; i += 4) {
+            storeMonoNeon(out + i, windowNeon(previous[0] + i, current[0] + i, rising + i, falling + i));
+        }
+    }
+    else if (numChannels == 2) {
+        for (; i + 4 <= size; i += 4) {
+            storeStereoNeon(out + 2 * i,
+                windowNeon(previous[0] + i, current[0] + i, rising + i, falling + i),
+                windowNeon(previous[1] + i, current[1] + i, rising + i, falling + i));
+        }
+    }
+    overlapAddRangeScalar(previous, current, rising, falling, numChannels, i, size, out);
+}
+
+template <typename Sample>
+static void interleaveNeon(const float* const* const in, const std::size_t numChannels, const std::size_t size, Sample* const out) {
+    std::size_t i{ 0 };
+    if (numChannels == 1) {
+        for (; i + 4 <= size; i += 4) {
+            storeMonoNeon(out + i, vld1q_f32(in[0] + i));
+        }
+    }
+    else if (numChannels == 2) {
+        for (; i + 4 <= size; i += 4) {
+            storeStereoNeon(out + 2 * i, vld1q_f32(in[0] + i), vld1q_f32(in[1] + i));
+        }
+    }
+    interleaveRangeScalar(in, numChannels, i, size, out);
+}
+
+static const VorbisDspKernels neonKernels{
+    "NEON",
+    applyFloorNeon,
+    decoupleNeon,
+    deinterleaveNeon,
+    fftPassNeon,
+    overlapAddNeon<float>,
+    overlapAddNeon<int16_t>,
+    interleaveNeon<float>,
+    interleaveNeon<int16_t>
+};
+
+const VorbisDspKernels& vcpp::getVorbisDspKernels() {
+    return neonKernels;
+}
+
+#else
+
+const VorbisDspKernels& vcpp::getVorbisDspKernels() {
+    return scalarKernels;
+}
+
+#endif
+
+const VorbisDspKernels& vcpp::getScalarVorbisDspKernels() {
+    return scalarKernels;
+}
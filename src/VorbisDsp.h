@@ -0,0 +1,98 @@
+#ifndef VORBIS_DSP_H
+#define VORBIS_DSP_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace vcpp {
+
+    /**
+    * Signal processing kernels of the Vorbis decoder. Every kernel has a scalar implementation
+    * and SIMD implementations (SSE2 and AVX2 on x86-64, NEON on AArch64) that produce the
+    * same results. getVorbisDspKernels() selects the fastest set supported by the CPU.
+    */
+    struct VorbisDspKernels {
+        // Name of the instruction set used by the kernels.
+        const char* name;
+
+        /**
+        * Multiplies each value of the residue with the inverse dB value of the floor curve at
+        * the same position: residue[i] *= inverseDb(floor[i]).
+        */
+        void (*applyFloor)(float* const residue, const uint8_t* const floor, const std::size_t size);
+
+        /**
+        * Reverts the square polar mapping of a pair of coupled channels, turning the magnitude
+        * and angle vectors back into the two channels.
+        */
+        void (*decouple)(float* const magnitude, float* const angle, const std::size_t size);
+
+        /**
+        * Splits interleaved values into numChannels vectors of size values each.
+        */
+        void (*deinterleave)(const float* const in, float* const* const out, const std::size_t numChannels, const std::size_t size);
+
+        /**
+        * Performs one radix-4 pass of an inverse complex FFT of size values. The real and
+        * imaginary parts are stored in separate arrays. The pass combines groups of four
+        * transforms of span values each into transforms of 4 * span values. The twiddle
+        * factors are the arrays w1 real, w1 imaginary, w2 real and w2 imaginary, each with
+        * span values, where w1 = exp(2 pi i j / (2 span)) and w2 = exp(2 pi i j / (4 span)).
+        */
+        void (*fftPass)(float* const real, float* const imaginary, const float* const twiddles, const std::size_t size, const std::size_t span);
+
+        /**
+        * Windows the overlapping parts of two blocks of numChannels channels each and writes
+        * their sums as interleaved samples:
+        * out[i * numChannels + c] = previous[c][i] * falling[i] + current[c][i] * rising[i].
+        */
+        void (*overlapAddFloat)(
+            const float* const* const previous,
+            const float* const* const current,
+            const float* const rising,
+            const float* const falling,
+            const std::size_t numChannels,
+            const std::size_t size,
+            float* const out);
+
+        /**
+        * Same as overlapAddFloat, but the samples are scaled to 16 bit, clamped and rounded
+        * to the nearest integer.
+        */
+        void (*overlapAddInt16)(
+            const float* const* const previous,
+            const float* const* const current,
+            const float* const rising,
+            const float* const falling,
+            const std::size_t numChannels,
+            const std::size_t size,
+            int16_t* const out);
+
+        /**
+        * Writes size samples of numChannels channels interleaved: out[i * numChannels + c] = in[c][i].
+        */
+        void (*interleaveFloat)(const float* const* const in, const std::size_t numChannels, const std::size_t size, float* const out);
+
+        /**
+        * Same as interleaveFloat, but the samples are converted to 16 bit like in overlapAddInt16.
+        */
+        void (*interleaveInt16)(const float* const* const in, const std::size_t numChannels, const std::size_t size, int16_t* const out);
+    };
+
+    /**
+    * Returns the kernels for the fastest instruction set supported by the CPU.
+    */
+    const VorbisDspKernels& getVorbisDspKernels();
+
+    /**
+    * Returns the scalar kernels, which work on every CPU.
+    */
+    const VorbisDspKernels& getScalarVorbisDspKernels();
+
+    /**
+    * Returns the value of floor1_inverse_dB_table from the Vorbis specification.
+    */
+    float vorbisInverseDb(const uint8_t value);
+}
+
+#endif
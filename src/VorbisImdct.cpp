@@ -0,0 +1,134 @@
+#include "VorbisImdct.h"
+
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace vcpp {
+
+    static constexpr double pi = 3.14159265358979323846;
+
+    VorbisImdct::VorbisImdct(const std::size_t size, const VorbisDspKernels& kernels)
+        : size_{ size }, kernels_{ kernels } {
+        if (size < 64 || size > 8192 || (size & (size - 1)) != 0) {
+            throw std::invalid_argument("Invalid IMDCT size.");
+        }
+        const std::size_t fftSize{ size / 4 };
+
+        rotationCos_.resize(fftSize);
+        rotationSin_.resize(fftSize);
+        for (std::size_t k{ 0 }; k < fftSize; k++) {
+            const double angle{ 2.0 * pi * (double(k) + 0.125) / double(size) };
+            rotationCos_[k] = float(std::cos(angle));
+            rotationSin_[k] = float(std::sin(angle));
+        }
+
+        unsigned int fftBits{ 0 };
+        while ((std::size_t(1) << fftBits) < fftSize) {
+            fftBits++;
+        }
+        bitReverse_.resize(fftSize);
+        for (std::size_t k{ 0 }; k < fftSize; k++) {
+            std::size_t reversed{ 0 };
+            for (unsigned int bit{ 0 }; bit < fftBits; bit++) {
+                reversed |= ((k >> bit) & 1) << (fftBits - 1 - bit);
+            }
+            bitReverse_[k] = uint16_t(reversed);
+        }
+
+        hasRadix2Pass_ = fftBits % 2 != 0;
+        for (std::size_t span{ hasRadix2Pass_ ? 2u : 1u }; span < fftSize; span *= 4) {
+            const std::size_t offset{ fftTwiddles_.size() };
+            fftTwiddles_.resize(offset + 4 * span);
+            for (std::size_t j{ 0 }; j < span; j++) {
+                const double angle1{ 2.0 * pi * double(j) / double(2 * span) };
+                const double angle2{ 2.0 * pi * double(j) / double(4 * span) };
+                fftTwiddles_[offset + j] = float(std::cos(angle1));
+                fftTwiddles_[offset + span + j] = float(std::sin(angle1));
+                fftTwiddles_[offset + 2 * span + j] = float(std::cos(angle2));
+                fftTwiddles_[offset + 3 * span + j] = float(std::sin(angle2));
+            }
+        }
+
+        window_.resize(size / 2);
+        for (std::size_t i{ 0 }; i < size / 2; i++) {
+            const double slope{ std::sin((double(i) + 0.5) / double(size / 2) * pi / 2.0) };
+            window_[i] = float(std::sin(pi / 2.0 * slope * slope));
+        }
+        fallingWindow_.assign(window_.rbegin(), window_.rend());
+    }
+
+    std::shared_ptr<const VorbisImdct> VorbisImdct::get(const std::size_t size, const VorbisDspKernels& kernels) {
+        static std::mutex lock;
+        static std::map<std::pair<std::size_t, const VorbisDspKernels*>, std::weak_ptr<const VorbisImdct>> plans;
+
+        const std::lock_guard<std::mutex> guard{ lock };
+        std::weak_ptr<const VorbisImdct>& cached{ plans[{ size, &kernels }] };
+        std::shared_ptr<const VorbisImdct> plan{ cached.lock() };
+        if (!plan) {
+            plan = std::make_shared<const VorbisImdct>(size, kernels);
+            cached = plan;
+        }
+        return plan;
+    }
+
+    void VorbisImdct::transform(const float* const in, float* const out, float* const scratch) const {
+        const std::size_t n2{ size_ / 2 };
+        const std::size_t n4{ size_ / 4 };
+        const std::size_t n8{ size_ / 8 };
+        float* const real{ scratch };
+        float* const imaginary{ scratch + n4 };
+
+        // Pre-rotation. Pairs of coefficients from both ends form the complex inputs of the
+        // FFT, which are stored in bit-reversed order.
+        for (std::size_t k{ 0 }; k < n4; k++) {
+            const float a{ in[n2 - 1 - 2 * k] };
+            const float b{ in[2 * k] };
+            const std::size_t j{ bitReverse_[k] };
+            real[j] = a * rotationCos_[k] - b * rotationSin_[k];
+            imaginary[j] = a * rotationSin_[k] + b * rotationCos_[k];
+        }
+
+        const float* twiddles{ fftTwiddles_.data() };
+        std::size_t span{ 1 };
+        if (hasRadix2Pass_) {
+            for (std::size_t k{ 0 }; k < n4; k += 2) {
+                const float sumReal{ real[k] + real[k + 1] };
+                const float sumImaginary{ imaginary[k] + imaginary[k + 1] };
+                real[k + 1] = real[k] - real[k + 1];
+                imaginary[k + 1] = imaginary[k] - imaginary[k + 1];
+                real[k] = sumReal;
+                imaginary[k] = sumImaginary;
+            }
+            span = 2;
+        }
+        for (; span < n4; span *= 4) {
+            kernels_.fftPass(real, imaginary, twiddles, n4, span);
+            twiddles += 4 * span;
+        }
+
+        // Post-rotation. The results are the middle half of the output, with the outputs
+        // of each pair of FFT bins interleaved from both ends.
+        float* const middle{ out + n4 };
+        for (std::size_t k{ 0 }; k < n8; k++) {
+            const std::size_t p{ n8 - 1 - k };
+            const std::size_t q{ n8 + k };
+            const float pReal{ real[p] * rotationCos_[p] - imaginary[p] * rotationSin_[p] };
+            const float pImaginary{ -(real[p] * rotationSin_[p] + imaginary[p] * rotationCos_[p]) };
+            const float qReal{ real[q] * rotationCos_[q] - imaginary[q] * rotationSin_[q] };
+            const float qImaginary{ -(real[q] * rotationSin_[q] + imaginary[q] * rotationCos_[q]) };
+            middle[2 * p] = pReal;
+            middle[2 * p + 1] = qImaginary;
+            middle[2 * q] = qReal;
+            middle[2 * q + 1] = pImaginary;
+        }
+
+        // The outer quarters follow from the symmetries of the transform.
+        for (std::size_t k{ 0 }; k < n4; k++) {
+            out[k] = -out[n2 - 1 - k];
+            out[size_ - 1 - k] = out[n2 + k];
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef VORBIS_IMDCT_H
+#define VORBIS_IMDCT_H
+
+#include "VorbisDsp.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace vcpp {
+
+    /**
+    * Plan for the inverse MDCT of one Vorbis block size. The transform is computed with a
+    * complex FFT of a quarter of the block size, between a pre- and a post-rotation. The plan
+    * holds all tables for the transform and the window slope of the block size, so it only
+    * has to be built once for each block size. Use get() to share plans between streams.
+    */
+    class VorbisImdct {
+        const std::size_t size_;
+        const VorbisDspKernels& kernels_;
+
+        // cos and sin of 2 pi (k + 1/8) / size for the pre- and post-rotation.
+        std::vector<float> rotationCos_;
+        std::vector<float> rotationSin_;
+
+        // Position of the k-th complex input of the FFT in bit-reversed order.
+        std::vector<uint16_t> bitReverse_;
+
+        // True if the FFT size is an odd power of two. The FFT then starts with a radix-2 pass.
+        bool hasRadix2Pass_;
+
+        // Twiddle factors of all radix-4 passes, in the layout expected by VorbisDspKernels::fftPass().
+        std::vector<float> fftTwiddles_;
+
+        // Rising and falling half of the window for this block size. The falling half is
+        // stored separately, so that the windowing kernels can read both forwards.
+        std::vector<float> window_;
+        std::vector<float> fallingWindow_;
+
+    public:
+        /**
+        * Builds a plan for blocks of size values.
+        *
+        * @param size The block size, a power of two from 64 to 8192.
+        * @param kernels The signal processing kernels used by transform().
+        */
+        explicit VorbisImdct(const std::size_t size, const VorbisDspKernels& kernels = getVorbisDspKernels());
+
+        VorbisImdct(const VorbisImdct& other) = delete;
+        VorbisImdct& operator=(const VorbisImdct& other) = delete;
+
+        /**
+        * Returns the plan for the given block size and kernels. Plans are built on first use
+        * and shared by everyone who requests the same size, as long as any of them holds on
+        * to it. This function is thread-safe.
+        */
+        static std::shared_ptr<const VorbisImdct> get(const std::size_t size, const VorbisDspKernels& kernels = getVorbisDspKernels());
+
+        std::size_t getSize() const {
+            return size_;
+        }
+
+        /**
+        * Returns the rising half of the Vorbis window for this block size, which has
+        * getSize() / 2 values. The falling half is the same in reverse.
+        */
+        const float* getWindow() const {
+            return window_.data();
+        }
+
+        /**
+        * Returns the falling half of the Vorbis window for this block size, which is
+        * getWindow() in reverse.
+        */
+        const float* getFallingWindow() const {
+            return fallingWindow_.data();
+        }
+
+        /**
+        * Computes the inverse MDCT as defined by the Vorbis specification, without any scaling.
+        * The input is read completely before any output is written, so in and out may point
+        * to the same buffer.
+        *
+        * @param in getSize() / 2 spectral coefficients.
+        * @param out Output for getSize() samples.
+        * @param scratch Room for getSize() / 2 values used during the transform.
+        */
+        void transform(const float* const in, float* const out, float* const scratch) const;
+    };
+}
+
+#endif
@@ -0,0 +1,596 @@
+#include "VorbisSetup.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace vcpp {
+
+    static constexpr uint8_t identificationPacketType = 1;
+    static constexpr uint8_t commentPacketType = 3;
+    static constexpr uint8_t setupPacketType = 5;
+
+    // Size of the common header: packet type and "vorbis".
+    static constexpr std::size_t commonHeaderSize = 7;
+
+    static constexpr uint32_t codebookSyncPattern = 0x564342;
+
+    [[noreturn]] static void throwBadHeader(const std::string& message) {
+        throw VorbisError{ VorbisError::Cause::BadHeader, message };
+    }
+
+    static void checkCommonHeader(const uint8_t* const data, const std::size_t size, const uint8_t packetType) {
+        if (size < commonHeaderSize || data[0] != packetType || std::memcmp(data + 1, "vorbis", 6) != 0) {
+            throwBadHeader("Packet is not a Vorbis header of the expected type.");
+        }
+    }
+
+    static float unpackFloat32(const uint32_t value) {
+        const double mantissa{ double(value & 0x1fffff) };
+        const int exponent{ int((value & 0x7fe00000) >> 21) - 788 };
+        const double result{ std::ldexp(mantissa, exponent) };
+        return float((value & 0x80000000) != 0 ? -result : result);
+    }
+
+    // Returns base^exponent, or a value greater than limit if the result would be greater than limit.
+    static uint64_t boundedPower(const uint64_t base, const unsigned int exponent, const uint64_t limit) {
+        uint64_t result{ 1 };
+        for (unsigned int i{ 0 }; i < exponent; i++) {
+            result *= base;
+            if (result > limit) {
+                return limit + 1;
+            }
+        }
+        return result;
+    }
+
+    // Returns the largest value r for which r^dimensions <= numEntries, lookup1_values() in the
+    // Vorbis specification.
+    static uint32_t lookup1Values(const uint32_t numEntries, const uint16_t dimensions) {
+        uint32_t result{ uint32_t(std::floor(std::exp(std::log(double(numEntries)) / dimensions))) };
+        // The floating point estimate can be off by one in either direction.
+        while (result > 0 && boundedPower(result, dimensions, numEntries) > numEntries) {
+            result--;
+        }
+        while (boundedPower(uint64_t(result) + 1, dimensions, numEntries) <= numEntries) {
+            result++;
+        }
+        return result;
+    }
+
+    static uint32_t reverseBits(uint32_t value) {
+        value = ((value & 0xaaaaaaaa) >> 1) | ((value & 0x55555555) << 1);
+        value = ((value & 0xcccccccc) >> 2) | ((value & 0x33333333) << 2);
+        value = ((value & 0xf0f0f0f0) >> 4) | ((value & 0x0f0f0f0f) << 4);
+        value = ((value & 0xff00ff00) >> 8) | ((value & 0x00ff00ff) << 8);
+        return (value >> 16) | (value << 16);
+    }
+
+    /**
+    * Assigns the codewords of a codebook from its codeword lengths. Each entry gets the
+    * lowest free codeword of its length, in the order of the entries. Throws if the
+    * lengths describe more codewords than a binary tree can hold.
+    */
+    static void assignCodewords(VorbisCodebook& codebook) {
+        codebook.codewords.assign(codebook.numEntries, 0);
+
+        // available[i] is the lowest free codeword of length i, MSB-aligned, or 0 if there is none.
+        uint32_t available[33]{};
+        uint32_t entry{ 0 };
+        while (entry < codebook.numEntries && codebook.lengths[entry] == 0) {
+            entry++;
+        }
+        if (entry == codebook.numEntries) {
+            return;
+        }
+
+        // The first entry gets the codeword consisting only of zeros.
+        for (unsigned int length{ 1 }; length <= codebook.lengths[entry]; length++) {
+            available[length] = uint32_t(1) << (32 - length);
+        }
+
+        for (entry++; entry < codebook.numEntries; entry++) {
+            const unsigned int length{ codebook.lengths[entry] };
+            if (length == 0) {
+                continue;
+            }
+
+            // Take the deepest free node that is not deeper than the codeword.
+            unsigned int freeLength{ length };
+            while (freeLength > 0 && available[freeLength] == 0) {
+                freeLength--;
+            }
+            if (freeLength == 0) {
+                throwBadHeader("Codebook is overspecified.");
+            }
+            const uint32_t codeword{ available[freeLength] };
+            available[freeLength] = 0;
+            codebook.codewords[entry] = reverseBits(codeword);
+
+            // The right siblings along the path down to the codeword become free.
+            for (unsigned int sibling{ length }; sibling > freeLength; sibling--) {
+                available[sibling] = codeword + (uint32_t(1) << (32 - sibling));
+            }
+        }
+    }
+
+    /**
+    * Fills the decode table at offset, which is indexed by the bits from depth to depth + bits 
+    * of the codewords. Entries with longer codewords are moved to subtables, one for each 
+    * combination of the indexing bits.
+    */
+    static void fillDecodeTable(
+        VorbisCodebook& codebook,
+        const std::size_t offset,
+        const unsigned int bits,
+        const unsigned int depth,
+        const std::vector<uint32_t>& entries
+    ) {
+        const uint32_t mask{ (uint32_t(1) << bits) - 1 };
+        std::vector<uint32_t> longerEntries;
+        for (const uint32_t entry : entries) {
+            const unsigned int remainingLength{ codebook.lengths[entry] - depth };
+            const uint32_t codeword{ codebook.codewords[entry] >> depth };
+            if (remainingLength > bits) {
+                longerEntries.push_back(entry);
+                continue;
+            }
+            // The bits after the codeword can have any value.
+            for (uint32_t i{ codeword & ((uint32_t(1) << remainingLength) - 1) }; i <= mask; i += uint32_t(1) << remainingLength) {
+                codebook.decodeTable[offset + i] = (entry << 8) | remainingLength;
+            }
+        }
+
+        auto slot = [&](const uint32_t entry) {
+            return (codebook.codewords[entry] >> depth) & mask;
+        };
+        std::sort(longerEntries.begin(), longerEntries.end(), [&](const uint32_t a, const uint32_t b) {
+            return slot(a) < slot(b);
+        });
+
+        for (auto groupBegin{ longerEntries.begin() }; groupBegin != longerEntries.end();) {
+            auto groupEnd{ groupBegin };
+            unsigned int maxLength{ 0 };
+            while (groupEnd != longerEntries.end() && slot(*groupEnd) == slot(*groupBegin)) {
+                maxLength = std::max<unsigned int>(maxLength, codebook.lengths[*groupEnd]);
+                groupEnd++;
+            }
+
+            const unsigned int subtableBits{ std::min(maxLength - depth - bits, VorbisCodebook::maxTableBits) };
+            const std::size_t subtableOffset{ codebook.decodeTable.size() };
+            if (subtableOffset + (std::size_t(1) << subtableBits) > (std::size_t(1) << 24)) {
+                throw VorbisError{ VorbisError::Cause::Unsupported, "Codebook is too large." };
+            }
+            codebook.decodeTable.resize(subtableOffset + (std::size_t(1) << subtableBits), 0);
+            codebook.decodeTable[offset + slot(*groupBegin)] = uint32_t(subtableOffset << 8) | VorbisCodebook::subtableFlag | subtableBits;
+
+            std::vector<uint32_t> group{ groupBegin, groupEnd };
+            fillDecodeTable(codebook, subtableOffset, subtableBits, depth + bits, group);
+            groupBegin = groupEnd;
+        }
+    }
+
+    static void buildDecodeTable(VorbisCodebook& codebook) {
+        std::vector<uint32_t> usedEntries;
+        unsigned int maxLength{ 0 };
+        for (uint32_t entry{ 0 }; entry < codebook.numEntries; entry++) {
+            if (codebook.lengths[entry] != 0) {
+                usedEntries.push_back(entry);
+                maxLength = std::max<unsigned int>(maxLength, codebook.lengths[entry]);
+            }
+        }
+
+        if (usedEntries.size() == 1) {
+            // A single codeword can not form a complete tree. The entry is decoded regardless 
+            // of the bits, which still have to be skipped.
+            codebook.tableBits = 0;
+            codebook.decodeTable.assign(1, (usedEntries[0] << 8) | codebook.lengths[usedEntries[0]]);
+            return;
+        }
+
+        codebook.tableBits = std::min(maxLength, VorbisCodebook::maxTableBits);
+        codebook.decodeTable.assign(std::size_t(1) << codebook.tableBits, 0);
+        fillDecodeTable(codebook, 0, codebook.tableBits, 0, usedEntries);
+    }
+
+    /**
+    * Expands the multiplicands of a codebook into one vector per entry.
+    */
+    static void buildVectors(VorbisCodebook& codebook) {
+        if (uint64_t(codebook.numEntries) * codebook.dimensions > (uint64_t(1) << 24)) {
+            throw VorbisError{ VorbisError::Cause::Unsupported, "Codebook is too large." };
+        }
+        codebook.vectors.resize(std::size_t(codebook.numEntries) * codebook.dimensions);
+
+        float* vector{ codebook.vectors.data() };
+        for (uint32_t entry{ 0 }; entry < codebook.numEntries; entry++) {
+            float last{ 0.0f };
+            uint32_t indexDivisor{ 1 };
+            for (unsigned int i{ 0 }; i < codebook.dimensions; i++) {
+                uint32_t multiplicandOffset;
+                if (codebook.lookupType == 1) {
+                    multiplicandOffset = (entry / indexDivisor) % codebook.numLookupValues;
+                    indexDivisor *= codebook.numLookupValues;
+                }
+                else {
+                    multiplicandOffset = entry * codebook.dimensions + i;
+                }
+                const float value{ codebook.multiplicands[multiplicandOffset] * codebook.deltaValue + codebook.minimumValue + last };
+                if (codebook.isSequence) {
+                    last = value;
+                }
+                *vector++ = value;
+            }
+        }
+    }
+
+    static VorbisCodebook parseCodebook(BitReader& reader) {
+        if (reader.read(24) != codebookSyncPattern) {
+            throwBadHeader("Codebook sync pattern not found.");
+        }
+
+        VorbisCodebook codebook{};
+        codebook.dimensions = uint16_t(reader.read(16));
+        codebook.numEntries = reader.read(24);
+        if (codebook.dimensions == 0) {
+            // Even empty codebooks are rejected, because residues divide by the dimensions.
+            throwBadHeader("Codebook has no dimensions.");
+        }
+
+        const bool isOrdered{ reader.readFlag() };
+        if (!isOrdered && codebook.numEntries > reader.getNumRemainingBits()) {
+            // Unordered lengths take up at least one bit per entry.
+            throwBadHeader("Codebook is larger than the packet.");
+        }
+        codebook.lengths.assign(codebook.numEntries, 0);
+        if (!isOrdered) {
+            const bool isSparse{ reader.readFlag() };
+            for (uint32_t i{ 0 }; i < codebook.numEntries; i++) {
+                if (!isSparse || reader.readFlag()) {
+                    codebook.lengths[i] = uint8_t(reader.read(5) + 1);
+                }
+            }
+        }
+        else {
+            uint32_t entry{ 0 };
+            unsigned int length{ reader.read(5) + 1 };
+            while (entry < codebook.numEntries) {
+                if (length > 32) {
+                    throwBadHeader("Codeword lengths exceed 32 bits.");
+                }
+                const uint32_t count{ reader.read(vorbisILog(codebook.numEntries - entry)) };
+                if (count > codebook.numEntries - entry) {
+                    throwBadHeader("Too many codeword lengths.");
+                }
+                std::fill_n(codebook.lengths.begin() + entry, count, uint8_t(length));
+                entry += count;
+                length++;
+                if (reader.isEndOfPacket()) {
+                    throwBadHeader("Unexpected end of setup header.");
+                }
+            }
+        }
+        assignCodewords(codebook);
+        buildDecodeTable(codebook);
+
+        codebook.lookupType = uint8_t(reader.read(4));
+        if (codebook.lookupType == 0) {
+            return codebook;
+        }
+        if (codebook.lookupType > 2) {
+            throwBadHeader("Unknown codebook lookup type.");
+        }
+
+        codebook.minimumValue = unpackFloat32(reader.read(32));
+        codebook.deltaValue = unpackFloat32(reader.read(32));
+        const unsigned int valueBits{ reader.read(4) + 1 };
+        codebook.isSequence = reader.readFlag();
+
+        const uint64_t numLookupValues{ codebook.lookupType == 1
+            ? lookup1Values(codebook.numEntries, codebook.dimensions)
+            : uint64_t(codebook.numEntries) * codebook.dimensions };
+        if (numLookupValues * valueBits > reader.getNumRemainingBits()) {
+            throwBadHeader("Codebook is larger than the packet.");
+        }
+        codebook.numLookupValues = uint32_t(numLookupValues);
+        codebook.multiplicands.resize(codebook.numLookupValues);
+        for (uint16_t& multiplicand : codebook.multiplicands) {
+            multiplicand = uint16_t(reader.read(valueBits));
+        }
+        buildVectors(codebook);
+        return codebook;
+    }
+
+    // Reads a codebook number and checks that it exists.
+    static uint8_t readCodebookNumber(BitReader& reader, const std::size_t numCodebooks) {
+        const uint8_t number{ uint8_t(reader.read(8)) };
+        if (number >= numCodebooks) {
+            throwBadHeader("Reference to a codebook that does not exist.");
+        }
+        return number;
+    }
+
+    static VorbisFloor1 parseFloor1(BitReader& reader, const std::size_t numCodebooks) {
+        VorbisFloor1 floor{};
+        floor.classMasterbooks.fill(-1);
+        floor.subclassBooks.fill(-1);
+
+        const unsigned int numPartitions{ reader.read(5) };
+        floor.partitionClasses.resize(numPartitions);
+        int maxClass{ -1 };
+        for (uint8_t& partitionClass : floor.partitionClasses) {
+            partitionClass = uint8_t(reader.read(4));
+            maxClass = std::max(maxClass, int(partitionClass));
+        }
+
+        for (int c{ 0 }; c <= maxClass; c++) {
+            floor.classDimensions[c] = uint8_t(reader.read(3) + 1);
+            floor.classSubclassBits[c] = uint8_t(reader.read(2));
+            if (floor.classSubclassBits[c] != 0) {
+                floor.classMasterbooks[c] = readCodebookNumber(reader, numCodebooks);
+            }
+            for (unsigned int s{ 0 }; s < (1u << floor.classSubclassBits[c]); s++) {
+                // The book numbers are stored plus one, 0 means that the subclass has no book.
+                const unsigned int book{ reader.read(8) };
+                if (book > numCodebooks) {
+                    throwBadHeader("Reference to a codebook that does not exist.");
+                }
+                floor.subclassBooks[c * VorbisFloor1::maxSubclasses + s] = int16_t(book) - 1;
+            }
+        }
+
+        floor.multiplier = uint8_t(reader.read(2) + 1);
+        floor.rangeBits = uint8_t(reader.read(4));
+        floor.xList.push_back(0);
+        floor.xList.push_back(uint16_t(1u << floor.rangeBits));
+        for (const uint8_t partitionClass : floor.partitionClasses) {
+            for (unsigned int i{ 0 }; i < floor.classDimensions[partitionClass]; i++) {
+                if (floor.xList.size() == VorbisFloor1::maxValues) {
+                    throwBadHeader("Floor has too many values.");
+                }
+                floor.xList.push_back(uint16_t(reader.read(floor.rangeBits)));
+            }
+        }
+
+        const std::size_t numValues{ floor.xList.size() };
+        for (std::size_t i{ 0 }; i < numValues; i++) {
+            floor.sortedOrder[i] = uint8_t(i);
+        }
+        std::sort(floor.sortedOrder.begin(), floor.sortedOrder.begin() + numValues, [&](const uint8_t a, const uint8_t b) {
+            return floor.xList[a] < floor.xList[b];
+        });
+        for (std::size_t i{ 1 }; i < numValues; i++) {
+            if (floor.xList[floor.sortedOrder[i - 1]] == floor.xList[floor.sortedOrder[i]]) {
+                throwBadHeader("Floor has duplicate X values.");
+            }
+        }
+
+        for (std::size_t i{ 2 }; i < numValues; i++) {
+            // The first two values are 0 and the maximum X coordinate, so both neighbors exist.
+            uint8_t low{ 0 };
+            uint8_t high{ 1 };
+            for (std::size_t j{ 2 }; j < i; j++) {
+                if (floor.xList[j] < floor.xList[i] && floor.xList[j] > floor.xList[low]) {
+                    low = uint8_t(j);
+                }
+                if (floor.xList[j] > floor.xList[i] && floor.xList[j] < floor.xList[high]) {
+                    high = uint8_t(j);
+                }
+            }
+            floor.lowNeighbors[i] = low;
+            floor.highNeighbors[i] = high;
+        }
+        return floor;
+    }
+
+    static VorbisResidue parseResidue(BitReader& reader, const uint16_t type, const std::vector<VorbisCodebook>& codebooks) {
+        VorbisResidue residue{};
+        residue.type = type;
+        residue.begin = reader.read(24);
+        residue.end = reader.read(24);
+        residue.partitionSize = reader.read(24) + 1;
+        residue.numClassifications = uint8_t(reader.read(6) + 1);
+        residue.classbook = readCodebookNumber(reader, codebooks.size());
+
+        uint8_t cascades[64];
+        for (unsigned int c{ 0 }; c < residue.numClassifications; c++) {
+            const unsigned int lowBits{ reader.read(3) };
+            const unsigned int highBits{ reader.readFlag() ? reader.read(5) : 0 };
+            cascades[c] = uint8_t(highBits << 3 | lowBits);
+        }
+
+        residue.books.assign(std::size_t(residue.numClassifications) * VorbisResidue::numPasses, -1);
+        for (unsigned int c{ 0 }; c < residue.numClassifications; c++) {
+            for (unsigned int pass{ 0 }; pass < VorbisResidue::numPasses; pass++) {
+                if ((cascades[c] & (1u << pass)) == 0) {
+                    continue;
+                }
+                const uint8_t book{ readCodebookNumber(reader, codebooks.size()) };
+                if (codebooks[book].lookupType == 0) {
+                    throwBadHeader("Residue uses a codebook without vectors.");
+                }
+                residue.books[c * VorbisResidue::numPasses + pass] = book;
+            }
+        }
+        return residue;
+    }
+
+    static VorbisMapping parseMapping(
+        BitReader& reader,
+        const VorbisIdentification& identification,
+        const std::size_t numFloors,
+        const std::size_t numResidues
+    ) {
+        VorbisMapping mapping{};
+        const unsigned int numSubmaps{ reader.readFlag() ? reader.read(4) + 1 : 1 };
+
+        if (reader.readFlag()) {
+            const unsigned int numCouplingSteps{ reader.read(8) + 1 };
+            const unsigned int channelBits{ vorbisILog(identification.numChannels - 1u) };
+            for (unsigned int i{ 0 }; i < numCouplingSteps; i++) {
+                const unsigned int magnitude{ reader.read(channelBits) };
+                const unsigned int angle{ reader.read(channelBits) };
+                if (magnitude == angle || magnitude >= identification.numChannels || angle >= identification.numChannels) {
+                    throwBadHeader("Invalid channel coupling.");
+                }
+                mapping.couplingSteps.push_back({ uint8_t(magnitude), uint8_t(angle) });
+            }
+        }
+
+        if (reader.read(2) != 0) {
+            throwBadHeader("Reserved mapping field is not zero.");
+        }
+
+        mapping.channelMux.assign(identification.numChannels, 0);
+        if (numSubmaps > 1) {
+            for (uint8_t& submap : mapping.channelMux) {
+                submap = uint8_t(reader.read(4));
+                if (submap >= numSubmaps) {
+                    throwBadHeader("Reference to a submap that does not exist.");
+                }
+            }
+        }
+
+        for (unsigned int i{ 0 }; i < numSubmaps; i++) {
+            reader.read(8);
+            const unsigned int floor{ reader.read(8) };
+            const unsigned int residue{ reader.read(8) };
+            if (floor >= numFloors || residue >= numResidues) {
+                throwBadHeader("Reference to a floor or residue that does not exist.");
+            }
+            mapping.submapFloors.push_back(uint8_t(floor));
+            mapping.submapResidues.push_back(uint8_t(residue));
+        }
+        return mapping;
+    }
+
+    VorbisIdentification VorbisIdentification::parse(const uint8_t* const data, const std::size_t size) {
+        checkCommonHeader(data, size, identificationPacketType);
+        BitReader reader{ data + commonHeaderSize, size - commonHeaderSize };
+
+        if (reader.read(32) != 0) {
+            throw VorbisError{ VorbisError::Cause::Unsupported, "Unsupported Vorbis version." };
+        }
+
+        VorbisIdentification identification{};
+        identification.numChannels = uint8_t(reader.read(8));
+        identification.sampleRate = reader.read(32);
+        identification.bitrateMaximum = int32_t(reader.read(32));
+        identification.bitrateNominal = int32_t(reader.read(32));
+        identification.bitrateMinimum = int32_t(reader.read(32));
+        const unsigned int shortBlockExponent{ reader.read(4) };
+        const unsigned int longBlockExponent{ reader.read(4) };
+        const bool isFramed{ reader.readFlag() };
+
+        if (reader.isEndOfPacket() || !isFramed) {
+            throwBadHeader("Identification header is truncated.");
+        }
+        if (identification.numChannels == 0 || identification.sampleRate == 0) {
+            throwBadHeader("Identification header has no channels or no sample rate.");
+        }
+        if (shortBlockExponent < 6 || longBlockExponent > 13 || shortBlockExponent > longBlockExponent) {
+            throwBadHeader("Invalid block sizes.");
+        }
+        identification.blockSizes = { uint16_t(1u << shortBlockExponent), uint16_t(1u << longBlockExponent) };
+        return identification;
+    }
+
+    VorbisComment VorbisComment::parse(const uint8_t* const data, const std::size_t size) {
+        checkCommonHeader(data, size, commentPacketType);
+        std::size_t offset{ commonHeaderSize };
+
+        // Reads a length-prefixed string.
+        auto readString = [&]() {
+            if (size - offset < 4 || size - offset - 4 < readUInt32LE(data + offset)) {
+                throwBadHeader("Comment header is truncated.");
+            }
+            const std::size_t length{ readUInt32LE(data + offset) };
+            offset += 4;
+            std::string string{ reinterpret_cast<const char*>(data + offset), length };
+            offset += length;
+            return string;
+        };
+
+        VorbisComment comment{};
+        comment.vendor = readString();
+        if (size - offset < 4) {
+            throwBadHeader("Comment header is truncated.");
+        }
+        const uint32_t numUserComments{ readUInt32LE(data + offset) };
+        offset += 4;
+        for (uint32_t i{ 0 }; i < numUserComments; i++) {
+            comment.userComments.push_back(readString());
+        }
+        if (offset == size || (data[offset] & 1) == 0) {
+            throwBadHeader("Comment header is not framed.");
+        }
+        return comment;
+    }
+
+    VorbisSetup VorbisSetup::parse(const uint8_t* const data, const std::size_t size, const VorbisIdentification& identification) {
+        checkCommonHeader(data, size, setupPacketType);
+        BitReader reader{ data + commonHeaderSize, size - commonHeaderSize };
+        VorbisSetup setup{};
+
+        const unsigned int numCodebooks{ reader.read(8) + 1 };
+        for (unsigned int i{ 0 }; i < numCodebooks; i++) {
+            setup.codebooks.push_back(parseCodebook(reader));
+        }
+
+        // Time domain transforms are placeholders in Vorbis I.
+        const unsigned int numTimeTransforms{ reader.read(6) + 1 };
+        for (unsigned int i{ 0 }; i < numTimeTransforms; i++) {
+            if (reader.read(16) != 0) {
+                throwBadHeader("Unknown time domain transform.");
+            }
+        }
+
+        const unsigned int numFloors{ reader.read(6) + 1 };
+        for (unsigned int i{ 0 }; i < numFloors; i++) {
+            const unsigned int type{ reader.read(16) };
+            if (type == 0) {
+                throw VorbisError{ VorbisError::Cause::Unsupported, "Floor type 0 is not supported." };
+            }
+            if (type != 1) {
+                throwBadHeader("Unknown floor type.");
+            }
+            setup.floors.push_back(parseFloor1(reader, setup.codebooks.size()));
+        }
+
+        const unsigned int numResidues{ reader.read(6) + 1 };
+        for (unsigned int i{ 0 }; i < numResidues; i++) {
+            const unsigned int type{ reader.read(16) };
+            if (type > 2) {
+                throwBadHeader("Unknown residue type.");
+            }
+            setup.residues.push_back(parseResidue(reader, uint16_t(type), setup.codebooks));
+        }
+
+        const unsigned int numMappings{ reader.read(6) + 1 };
+        for (unsigned int i{ 0 }; i < numMappings; i++) {
+            if (reader.read(16) != 0) {
+                throwBadHeader("Unknown mapping type.");
+            }
+            setup.mappings.push_back(parseMapping(reader, identification, numFloors, numResidues));
+        }
+
+        const unsigned int numModes{ reader.read(6) + 1 };
+        for (unsigned int i{ 0 }; i < numModes; i++) {
+            VorbisMode mode{};
+            mode.blockFlag = reader.readFlag();
+            const unsigned int windowType{ reader.read(16) };
+            const unsigned int transformType{ reader.read(16) };
+            mode.mapping = uint8_t(reader.read(8));
+            if (windowType != 0 || transformType != 0 || mode.mapping >= numMappings) {
+                throwBadHeader("Invalid mode.");
+            }
+            setup.modes.push_back(mode);
+        }
+
+        if (!reader.readFlag() || reader.isEndOfPacket()) {
+            throwBadHeader("Setup header is not framed.");
+        }
+        return setup;
+    }
+}
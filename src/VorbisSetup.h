@@ -0,0 +1,246 @@
+#ifndef VORBIS_SETUP_H
+#define VORBIS_SETUP_H
+
+#include "BitReader.h"
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace vcpp {
+
+    class VorbisError : public std::runtime_error {
+    public:
+        enum class Cause {
+            BadHeader,
+            BadPacket,
+            Unsupported
+        };
+
+    private:
+        const Cause cause_;
+
+    public:
+        VorbisError(const Cause cause, const std::string& what) : std::runtime_error(what), cause_(cause) {}
+
+        Cause getCause() const {
+            return cause_;
+        }
+    };
+
+    /**
+    * Contents of the identification header, the first packet of a Vorbis stream.
+    */
+    struct VorbisIdentification {
+        uint8_t numChannels;
+        uint32_t sampleRate;
+        int32_t bitrateMaximum;
+        int32_t bitrateNominal;
+        int32_t bitrateMinimum;
+
+        // Sizes of short and long blocks.
+        std::array<uint16_t, 2> blockSizes;
+
+        /**
+        * Parses an identification header packet.
+        * Throws a VorbisError if the packet is not a valid identification header.
+        */
+        static VorbisIdentification parse(const uint8_t* const data, const std::size_t size);
+    };
+
+    /**
+    * Contents of the comment header, the second packet of a Vorbis stream.
+    */
+    struct VorbisComment {
+        std::string vendor;
+        std::vector<std::string> userComments;
+
+        /**
+        * Parses a comment header packet.
+        * Throws a VorbisError if the packet is not a valid comment header.
+        */
+        static VorbisComment parse(const uint8_t* const data, const std::size_t size);
+    };
+
+    /**
+    * A codebook of the setup header. Entries are identified by their index.
+    */
+    struct VorbisCodebook {
+        uint16_t dimensions;
+        uint32_t numEntries;
+
+        // Codeword length of each entry, or 0 if the entry is unused.
+        std::vector<uint8_t> lengths;
+
+        // Codeword of each used entry. The bits are reversed, so that the first bit of the
+        // codeword in the packet is the lowest bit.
+        std::vector<uint32_t> codewords;
+
+        // Vector lookup. lookupType is 0 if the codebook has no vectors, see the Vorbis
+        // specification for types 1 and 2.
+        uint8_t lookupType;
+        float minimumValue;
+        float deltaValue;
+        bool isSequence;
+        uint32_t numLookupValues;
+        std::vector<uint16_t> multiplicands;
+
+        // Vectors of all entries, expanded from the multiplicands when the header is parsed.
+        // Entry i starts at index i * dimensions. Empty if lookupType is 0.
+        std::vector<float> vectors;
+
+        // Number of bits that index the first level of decodeTable.
+        static constexpr unsigned int maxTableBits = 10;
+        unsigned int tableBits;
+
+        // Lookup tables for decoding entries. The first 2^tableBits elements are indexed by the
+        // next tableBits bits of the packet. Each element is one of:
+        //   0: The bits do not start any codeword.
+        //   (entry << 8) | length: The bits start the codeword of entry, which has the given
+        //                          length counting from the first bit that indexed the table.
+        //   (offset << 8) | subtableFlag | bits: The codeword is longer than the indexing bits.
+        //                          After skipping them, the next bits index the table at offset.
+        static constexpr uint32_t subtableFlag = 0x80;
+        std::vector<uint32_t> decodeTable;
+
+        /**
+        * Reads a codeword from the packet and returns its entry. Returns -1 if the 
+        * bits are not a codeword of this codebook or if the packet ends.
+        */
+        int32_t decodeEntry(BitReader& reader) const {
+            unsigned int bits{ tableBits };
+            uint32_t element{ decodeTable[reader.peek(bits)] };
+            while ((element & subtableFlag) != 0) {
+                reader.skip(bits);
+                bits = element & 0x3f;
+                element = decodeTable[(element >> 8) + reader.peek(bits)];
+            }
+            if (element == 0) {
+                return -1;
+            }
+            reader.skip(element & 0x3f);
+            return reader.isEndOfPacket() ? -1 : int32_t(element >> 8);
+        }
+
+        /**
+        * Reads a codeword from the packet and returns the vector of its entry, which 
+        * has dimensions values. Returns nullptr if decodeEntry() fails. Must only be
+        * used if lookupType is not 0.
+        */
+        const float* decodeVector(BitReader& reader) const {
+            const int32_t entry{ decodeEntry(reader) };
+            return entry < 0 ? nullptr : vectors.data() + std::size_t(entry) * dimensions;
+        }
+    };
+
+    /**
+    * Floor type 1. Its parameters are stored per class in fixed-size arrays.
+    */
+    struct VorbisFloor1 {
+        static constexpr std::size_t maxClasses = 16;
+        static constexpr std::size_t maxSubclasses = 8;
+        static constexpr std::size_t maxValues = 65;
+
+        // Class of each partition.
+        std::vector<uint8_t> partitionClasses;
+
+        std::array<uint8_t, maxClasses> classDimensions;
+        std::array<uint8_t, maxClasses> classSubclassBits;
+
+        // Codebook of each class's subclass selector, or -1 if the class has no subclasses.
+        std::array<int16_t, maxClasses> classMasterbooks;
+
+        // Codebook of each subclass, or -1 if the subclass has none. maxSubclasses per class.
+        std::array<int16_t, maxClasses * maxSubclasses> subclassBooks;
+
+        uint8_t multiplier;
+        uint8_t rangeBits;
+
+        // X coordinates in the order in which the packet lists their Y values.
+        std::vector<uint16_t> xList;
+
+        // Indices into xList, ordered by X coordinate.
+        std::array<uint8_t, maxValues> sortedOrder;
+
+        // For each value from the third on, the indices of the values before it in xList
+        // that have the next lower and next higher X coordinates.
+        std::array<uint8_t, maxValues> lowNeighbors;
+        std::array<uint8_t, maxValues> highNeighbors;
+    };
+
+    /**
+    * Residue of type 0, 1 or 2.
+    */
+    struct VorbisResidue {
+        static constexpr std::size_t numPasses = 8;
+
+        uint16_t type;
+        uint32_t begin;
+        uint32_t end;
+        uint32_t partitionSize;
+        uint8_t numClassifications;
+        uint8_t classbook;
+
+        // Codebook of each classification for each pass, or -1 if it has none.
+        // numPasses per classification.
+        std::vector<int16_t> books;
+    };
+
+    struct VorbisMapping {
+        struct CouplingStep {
+            uint8_t magnitude;
+            uint8_t angle;
+        };
+
+        std::vector<CouplingStep> couplingSteps;
+
+        // Submap of each channel.
+        std::vector<uint8_t> channelMux;
+
+        // Floor and residue of each submap.
+        std::vector<uint8_t> submapFloors;
+        std::vector<uint8_t> submapResidues;
+    };
+
+    struct VorbisMode {
+        bool blockFlag;
+        uint8_t mapping;
+    };
+
+    /**
+    * Contents of the setup header, the third packet of a Vorbis stream. Codebooks, floors,
+    * residues, mappings and modes refer to each other by their index in these arrays.
+    */
+    struct VorbisSetup {
+        std::vector<VorbisCodebook> codebooks;
+        std::vector<VorbisFloor1> floors;
+        std::vector<VorbisResidue> residues;
+        std::vector<VorbisMapping> mappings;
+        std::vector<VorbisMode> modes;
+
+        /**
+        * Parses a setup header packet.
+        * Throws a VorbisError if the packet is not a valid setup header.
+        *
+        * @param identification The identification header of the same stream.
+        */
+        static VorbisSetup parse(const uint8_t* const data, const std::size_t size, const VorbisIdentification& identification);
+    };
+
+    /**
+    * Returns the number of bits needed to represent value, ilog() in the Vorbis specification.
+    */
+    inline unsigned int vorbisILog(uint32_t value) {
+        unsigned int bits{ 0 };
+        while (value != 0) {
+            bits++;
+            value >>= 1;
+        }
+        return bits;
+    }
+}
+
+#endif
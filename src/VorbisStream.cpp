@@ -0,0 +1,273 @@
+#include "VorbisStream.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace vcpp {
+
+    struct VorbisStream::Pipeline {
+        struct Slot {
+            std::vector<uint8_t> packet;
+            std::vector<float> block;
+            std::size_t blockSize;
+            int64_t endPosition;
+            bool isDecoded;
+            std::exception_ptr error;
+        };
+
+        const VorbisDecoder& decoder;
+        const std::size_t depth;
+        const std::unique_ptr<Slot[]> slots;
+
+        std::mutex lock;
+        std::condition_variable packetQueued;
+        std::condition_variable packetDecoded;
+
+        // Number of packets that were queued, claimed by a worker and delivered so far.
+        uint64_t numQueued;
+        uint64_t numClaimed;
+        uint64_t numDelivered;
+
+        bool isStopping;
+        std::vector<std::thread> threads;
+
+        Pipeline(const VorbisDecoder& decoder, const unsigned int numWorkers, const std::size_t depth)
+            : decoder{ decoder },
+              depth{ std::max(depth, std::size_t(1)) },
+              slots{ new Slot[this->depth] },
+              numQueued{ 0 },
+              numClaimed{ 0 },
+              numDelivered{ 0 },
+              isStopping{ false } {
+            for (unsigned int i{ 0 }; i < numWorkers; i++) {
+                threads.emplace_back([this]() { decode(); });
+            }
+        }
+
+        ~Pipeline() {
+            {
+                std::lock_guard<std::mutex> guard{ lock };
+                isStopping = true;
+            }
+            packetQueued.notify_all();
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+        }
+
+        /**
+        * Body of the worker threads. Each worker has its own Workspace, and the decoder's
+        * methods are const, so the workers do not share any mutable state.
+        */
+        void decode() {
+            VorbisDecoder::Workspace workspace;
+            while (true) {
+                std::unique_lock<std::mutex> guard{ lock };
+                packetQueued.wait(guard, [this] { return isStopping || numClaimed < numQueued; });
+                if (isStopping) {
+                    break;
+                }
+                Slot& slot{ slots[numClaimed % depth] };
+                numClaimed++;
+                guard.unlock();
+
+                try {
+                    // The header was already checked when the packet was queued, it is only
+                    // read again to position the reader.
+                    BitReader reader{ slot.packet.data(), slot.packet.size() };
+                    VorbisDecoder::PacketHeader header;
+                    decoder.readPacketHeader(reader, header);
+                    slot.block.resize(decoder.getIdentification().numChannels * slot.blockSize);
+                    decoder.decodeBlock(reader, header, slot.block.data(), slot.blockSize, workspace);
+                }
+                catch (...) {
+                    slot.error = std::current_exception();
+                }
+
+                guard.lock();
+                slot.isDecoded = true;
+                guard.unlock();
+                packetDecoded.notify_all();
+            }
+        }
+
+        /**
+        * Returns the next slot to deliver, or nullptr if all queued packets were delivered.
+        * If the packet of the slot is not decoded yet, waits for it if shouldWait is true
+        * and returns nullptr otherwise.
+        */
+        Slot* getDecodedSlot(const bool shouldWait) {
+            std::unique_lock<std::mutex> guard{ lock };
+            if (numDelivered == numQueued) {
+                return nullptr;
+            }
+            Slot& slot{ slots[numDelivered % depth] };
+            if (shouldWait) {
+                packetDecoded.wait(guard, [&slot] { return slot.isDecoded; });
+            }
+            return slot.isDecoded ? &slot : nullptr;
+        }
+    };
+
+    VorbisStream::VorbisStream(const unsigned int numWorkers, const std::size_t queueDepth)
+        : numWorkers_{ numWorkers }, queueDepth_{ queueDepth } {}
+
+    VorbisStream::~VorbisStream() = default;
+
+    void VorbisStream::onPacketAvailable(const uint8_t* const data, const std::size_t size, const OggLogicalStreamIn::PacketMetaData meta) {
+        processPacket(data, size, meta.isLastPacket ? meta.granulePosition : -1);
+        if (meta.isLastPacket) {
+            flush();
+        }
+    }
+
+    void VorbisStream::processPacket(const uint8_t* const data, const std::size_t size) {
+        processPacket(data, size, -1);
+    }
+
+    void VorbisStream::processPacket(const uint8_t* const data, const std::size_t size, const int64_t endPosition) {
+        if (!identification_) {
+            identification_ = VorbisIdentification::parse(data, size);
+            return;
+        }
+        if (!comment_) {
+            comment_ = VorbisComment::parse(data, size);
+            return;
+        }
+        if (!decoder_) {
+            decoder_.emplace(*identification_, VorbisSetup::parse(data, size, *identification_));
+            synthesis_.emplace(*identification_);
+            if (numWorkers_ > 0) {
+                pipeline_ = std::make_unique<Pipeline>(*decoder_, numWorkers_, queueDepth_);
+            }
+            return;
+        }
+        if (size > 0 && (data[0] & 1) != 0) {
+            throw VorbisError{ VorbisError::Cause::BadPacket, "Unexpected header packet." };
+        }
+
+        BitReader reader{ data, size };
+        VorbisDecoder::PacketHeader header;
+        if (!decoder_->readPacketHeader(reader, header)) {
+            return;
+        }
+        const std::size_t blockSize{ decoder_->getBlockSize(header) };
+
+        if (!pipeline_) {
+            block_.resize(identification_->numChannels * blockSize);
+            decoder_->decodeBlock(reader, header, block_.data(), blockSize, workspace_);
+            deliverBlock(block_, blockSize, endPosition);
+            return;
+        }
+
+        // Deliver what the workers have finished, and wait for the oldest packet if
+        // the queue is full. If delivering fails, the failed packet has left the queue,
+        // so this packet is still queued before the error is rethrown.
+        Pipeline& pipeline{ *pipeline_ };
+        std::exception_ptr error;
+        try {
+            while (deliverQueuedBlock(pipeline.numQueued - pipeline.numDelivered == pipeline.depth)) {}
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        Pipeline::Slot& slot{ pipeline.slots[pipeline.numQueued % pipeline.depth] };
+        slot.packet.assign(data, data + size);
+        slot.blockSize = blockSize;
+        slot.endPosition = endPosition;
+        slot.isDecoded = false;
+        slot.error = nullptr;
+        {
+            std::lock_guard<std::mutex> guard{ pipeline.lock };
+            pipeline.numQueued++;
+        }
+        pipeline.packetQueued.notify_one();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void VorbisStream::flush() {
+        if (!pipeline_) {
+            return;
+        }
+        while (deliverQueuedBlock(true)) {}
+    }
+
+    bool VorbisStream::deliverQueuedBlock(const bool shouldWait) {
+        Pipeline& pipeline{ *pipeline_ };
+        Pipeline::Slot* const slot{ pipeline.getDecodedSlot(shouldWait) };
+        if (slot == nullptr) {
+            return false;
+        }
+
+        // The slot is released even if decoding or a PcmCallback failed, so that the
+        // stream continues with the next packet.
+        const auto releaseSlot{ [&pipeline]() {
+            std::lock_guard<std::mutex> guard{ pipeline.lock };
+            pipeline.numDelivered++;
+        } };
+        const std::exception_ptr error{ std::exchange(slot->error, nullptr) };
+        if (error) {
+            releaseSlot();
+            std::rethrow_exception(error);
+        }
+        try {
+            deliverBlock(slot->block, slot->blockSize, slot->endPosition);
+        }
+        catch (...) {
+            releaseSlot();
+            throw;
+        }
+        releaseSlot();
+        return true;
+    }
+
+    void VorbisStream::deliverBlock(std::vector<float>& block, const std::size_t blockSize, const int64_t endPosition) {
+        synthesis_->addBlock(block, blockSize);
+        if (endPosition >= 0) {
+            synthesis_->truncate(uint64_t(endPosition));
+        }
+
+        const std::size_t numFrames{ synthesis_->getNumPendingFrames() };
+        if (numFrames > 0) {
+            for (const std::shared_ptr<PcmCallback>& callback : pcmCallbacks_) {
+                callback->onPcmAvailable(*this, numFrames);
+            }
+        }
+    }
+
+    void VorbisStream::addPcmCallback(const std::shared_ptr<PcmCallback> callback) {
+        pcmCallbacks_.emplace_back(callback);
+    }
+
+    void VorbisStream::removePcmCallback(const std::shared_ptr<PcmCallback>& callback) {
+        auto callbackIt{ std::find(pcmCallbacks_.cbegin(), pcmCallbacks_.cend(), callback) };
+        if (callbackIt != pcmCallbacks_.cend()) {
+            pcmCallbacks_.erase(callbackIt);
+        }
+    }
+
+    void VorbisStream::truncate(const uint64_t numFrames) {
+        if (synthesis_) {
+            synthesis_->truncate(numFrames);
+        }
+    }
+
+    std::size_t VorbisStream::readInterleaved(float* const out, const std::size_t maxFrames) {
+        return synthesis_ ? synthesis_->readInterleaved(out, maxFrames) : 0;
+    }
+
+    std::size_t VorbisStream::readInterleaved(int16_t* const out, const std::size_t maxFrames) {
+        return synthesis_ ? synthesis_->readInterleaved(out, maxFrames) : 0;
+    }
+
+    std::size_t VorbisStream::readPlanar(float* const* const out, const std::size_t maxFrames) {
+        return synthesis_ ? synthesis_->readPlanar(out, maxFrames) : 0;
+    }
+}
@@ -0,0 +1,204 @@
+#ifndef VORBIS_STREAM_H
+#define VORBIS_STREAM_H
+
+#include "OggStream.h"
+#include "VorbisDecoder.h"
+#include "VorbisSetup.h"
+#include "VorbisSynthesis.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace vcpp {
+
+    /**
+    * Decodes a Vorbis stream from the packets of an OggLogicalStreamIn. Add the VorbisStream
+    * to the logical stream with OggLogicalStreamIn::addPacketCallback(). The first three
+    * packets are parsed into the identification, comment and setup headers. Each audio
+    * packet after that makes a number of frames pending, which are read with the read
+    * methods. Frames that are not read before the next audio packet are dropped.
+    *
+    * With worker threads, packets are decoded and transformed by the workers, while the
+    * thread that passes in the packets parses their headers and overlap-adds the blocks in
+    * order. Decoded blocks are then delivered a few packets later, so their frames have
+    * to be read by a PcmCallback. The output is the same as without worker threads.
+    */
+    class VorbisStream : public OggLogicalStreamIn::PacketCallback {
+    public:
+        class PcmCallback {
+        public:
+            /**
+            * Called on the thread that passes in the packets, when an audio packet made new
+            * frames available. The frames have to be read from the stream during the call.
+            *
+            * @param stream The stream with the pending frames.
+            * @param numFrames Number of pending frames.
+            */
+            virtual void onPcmAvailable(VorbisStream& stream, const std::size_t numFrames) = 0;
+        };
+
+    private:
+        /**
+        * Packet queue and worker threads of a stream with worker threads.
+        */
+        struct Pipeline;
+
+        const unsigned int numWorkers_;
+        const std::size_t queueDepth_;
+        std::vector<std::shared_ptr<PcmCallback>> pcmCallbacks_;
+        std::optional<VorbisIdentification> identification_;
+        std::optional<VorbisComment> comment_;
+
+        // Created from the setup header. Holds the setup and the inverse MDCT plans.
+        std::optional<VorbisDecoder> decoder_;
+        std::optional<VorbisSynthesis> synthesis_;
+        VorbisDecoder::Workspace workspace_;
+
+        // Buffer for the next block, exchanged with the synthesis after each packet.
+        std::vector<float> block_;
+
+        // Declared last, so that the workers are stopped before the decoder is destroyed.
+        std::unique_ptr<Pipeline> pipeline_;
+
+        /**
+        * Processes a packet. If endPosition is not negative, the stream ends after that
+        * many frames.
+        */
+        void processPacket(const uint8_t* const data, const std::size_t size, const int64_t endPosition);
+
+        /**
+        * Passes a decoded block to the synthesis and calls the PcmCallbacks.
+        */
+        void deliverBlock(std::vector<float>& block, const std::size_t blockSize, const int64_t endPosition);
+
+        /**
+        * Delivers the oldest queued packet if the workers have decoded it, waiting for it if
+        * shouldWait is true. Returns false if nothing was delivered. Rethrows errors of the
+        * workers after removing the packet from the queue.
+        */
+        bool deliverQueuedBlock(const bool shouldWait);
+
+    public:
+        /**
+        * Constructs a VorbisStream.
+        *
+        * @param numWorkers Number of threads that decode audio packets. If 0, packets are
+        *     decoded by the thread that passes them in, and their frames can be read as
+        *     soon as processPacket() returns.
+        * @param queueDepth Maximum number of packets that are queued for the workers.
+        */
+        explicit VorbisStream(const unsigned int numWorkers = 0, const std::size_t queueDepth = 32);
+
+        VorbisStream(const VorbisStream& other) = delete;
+        VorbisStream& operator=(const VorbisStream& other) = delete;
+
+        ~VorbisStream();
+
+        /**
+        * Processes the next packet. At the end of the logical stream, the remaining
+        * packets are delivered and the stream is truncated to the granule position.
+        */
+        void onPacketAvailable(const uint8_t* const data, const std::size_t size, const OggLogicalStreamIn::PacketMetaData meta) override;
+
+        /**
+        * Processes the next packet of the stream.
+        * Throws a VorbisError if a header is damaged or missing.
+        * 
+        * @param data Pointer to the packet.
+        * @param size Size of the packet.
+        */
+        void processPacket(const uint8_t* const data, const std::size_t size);
+
+        /**
+        * Waits until the workers decoded all queued packets and delivers them. Does nothing
+        * without worker threads.
+        */
+        void flush();
+
+        /**
+        * Adds a PcmCallback to this VorbisStream.
+        */
+        void addPcmCallback(const std::shared_ptr<PcmCallback> callback);
+
+        /**
+        * Removes a PcmCallback from this VorbisStream. If the callback is not found, this
+        * method does nothing.
+        */
+        void removePcmCallback(const std::shared_ptr<PcmCallback>& callback);
+
+        /**
+        * Returns the number of frames that can be read.
+        */
+        std::size_t getNumPendingFrames() const {
+            return synthesis_ ? synthesis_->getNumPendingFrames() : 0;
+        }
+
+        /**
+        * Ends the stream after numFrames frames by dropping pending frames beyond that.
+        * onPacketAvailable() does this with the granule position of the last page.
+        */
+        void truncate(const uint64_t numFrames);
+
+        /**
+        * Reads up to maxFrames pending frames as interleaved float samples. The samples
+        * are windowed, overlap-added and written directly to the given buffer. Pending
+        * frames can be read with several calls, for example to fill both parts of a ring
+        * buffer.
+        *
+        * @param out Output for the samples, with room for maxFrames frames.
+        * @param maxFrames Maximum number of frames to read.
+        * @return The number of frames read.
+        */
+        std::size_t readInterleaved(float* const out, const std::size_t maxFrames);
+
+        /**
+        * Reads up to maxFrames pending frames as interleaved 16-bit samples.
+        */
+        std::size_t readInterleaved(int16_t* const out, const std::size_t maxFrames);
+
+        /**
+        * Reads up to maxFrames pending frames as float samples, into one buffer per channel.
+        */
+        std::size_t readPlanar(float* const* const out, const std::size_t maxFrames);
+
+        /**
+        * Returns true once all three headers were parsed.
+        */
+        bool hasHeaders() const {
+            return decoder_.has_value();
+        }
+
+        /**
+        * Returns the identification header. Must only be called if hasHeaders() is true.
+        */
+        const VorbisIdentification& getIdentification() const {
+            return *identification_;
+        }
+
+        /**
+        * Returns the comment header. Must only be called if hasHeaders() is true.
+        */
+        const VorbisComment& getComment() const {
+            return *comment_;
+        }
+
+        /**
+        * Returns the setup header. Must only be called if hasHeaders() is true.
+        */
+        const VorbisSetup& getSetup() const {
+            return decoder_->getSetup();
+        }
+
+        /**
+        * Returns the decoder for the stream's audio packets. Must only be called if
+        * hasHeaders() is true.
+        */
+        const VorbisDecoder& getDecoder() const {
+            return *decoder_;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include "VorbisSynthesis.h"
+
+#include <algorithm>
+
+namespace vcpp {
+
+    VorbisSynthesis::VorbisSynthesis(const VorbisIdentification& identification, const VorbisDspKernels& kernels)
+        : numChannels_{ identification.numChannels },
+        kernels_{ kernels },
+        blockSizes_{ identification.blockSizes },
+        imdcts_{ VorbisImdct::get(identification.blockSizes[0], kernels), VorbisImdct::get(identification.blockSizes[1], kernels) },
+        previousSize_{ 0 },
+        currentSize_{ 0 },
+        position_{ 0 },
+        numFrames_{ 0 },
+        streamPosition_{ 0 },
+        previousChannels_(identification.numChannels),
+        currentChannels_(identification.numChannels) {}
+
+    void VorbisSynthesis::addBlock(std::vector<float>& block, const std::size_t blockSize) {
+        previous_.swap(current_);
+        current_.swap(block);
+        previousSize_ = currentSize_;
+        currentSize_ = blockSize;
+
+        // The first block only provides the left half of the first overlap.
+        position_ = 0;
+        numFrames_ = previousSize_ == 0 ? 0 : previousSize_ / 4 + currentSize_ / 4;
+        streamPosition_ += numFrames_;
+    }
+
+    void VorbisSynthesis::truncate(const uint64_t numFrames) {
+        if (streamPosition_ <= numFrames) {
+            return;
+        }
+        const std::size_t excess{ std::size_t(std::min<uint64_t>(streamPosition_ - numFrames, getNumPendingFrames())) };
+        numFrames_ -= excess;
+        streamPosition_ -= excess;
+    }
+
+    template <typename Sample>
+    void VorbisSynthesis::write(
+        Sample* const out,
+        const std::size_t firstChannel,
+        const std::size_t numChannels,
+        const std::size_t numFrames,
+        void (*const overlapAdd)(const float* const*, const float* const*, const float*, const float*, std::size_t, std::size_t, Sample*),
+        void (*const interleave)(const float* const*, std::size_t, std::size_t, Sample*)
+    ) {
+        // Frame i of the overlap is sample previousSize_ / 2 + i of the previous block and
+        // sample i + currentSize_ / 4 - previousSize_ / 4 of the current one. Outside of
+        // the shorter block's window slope, the window of the other block is 0 or 1.
+        const std::size_t overlapSize{ std::min(previousSize_, currentSize_) / 2 };
+        const std::size_t overlapBegin{ previousSize_ > currentSize_ ? (previousSize_ - currentSize_) / 4 : 0 };
+        const std::size_t overlapEnd{ overlapBegin + overlapSize };
+        const VorbisImdct& window{ *imdcts_[overlapSize * 2 == blockSizes_[0] ? 0 : 1] };
+
+        const auto setChannels{ [&](std::vector<const float*>& channels, const std::vector<float>& block, const std::size_t blockSize, const std::size_t offset) {
+            for (std::size_t channel{ 0 }; channel < numChannels; channel++) {
+                channels[channel] = block.data() + (firstChannel + channel) * blockSize + offset;
+            }
+        } };
+
+        Sample* output{ out };
+        std::size_t frame{ position_ };
+        const std::size_t end{ position_ + numFrames };
+        if (frame < overlapBegin) {
+            const std::size_t count{ std::min(end, overlapBegin) - frame };
+            setChannels(previousChannels_, previous_, previousSize_, previousSize_ / 2 + frame);
+            interleave(previousChannels_.data(), numChannels, count, output);
+            output += count * numChannels;
+            frame += count;
+        }
+        if (frame < end && frame < overlapEnd) {
+            const std::size_t count{ std::min(end, overlapEnd) - frame };
+            const std::size_t windowOffset{ frame - overlapBegin };
+            setChannels(previousChannels_, previous_, previousSize_, previousSize_ / 2 + frame);
+            setChannels(currentChannels_, current_, currentSize_, frame + currentSize_ / 4 - previousSize_ / 4);
+            overlapAdd(
+                previousChannels_.data(),
+                currentChannels_.data(),
+                window.getWindow() + windowOffset,
+                window.getFallingWindow() + windowOffset,
+                numChannels,
+                count,
+                output);
+            output += count * numChannels;
+            frame += count;
+        }
+        if (frame < end) {
+            const std::size_t count{ end - frame };
+            setChannels(currentChannels_, current_, currentSize_, frame + currentSize_ / 4 - previousSize_ / 4);
+            interleave(currentChannels_.data(), numChannels, count, output);
+        }
+    }
+
+    std::size_t VorbisSynthesis::readInterleaved(float* const out, const std::size_t maxFrames) {
+        const std::size_t numFrames{ std::min(maxFrames, getNumPendingFrames()) };
+        write(out, 0, numChannels_, numFrames, kernels_.overlapAddFloat, kernels_.interleaveFloat);
+        position_ += numFrames;
+        return numFrames;
+    }
+
+    std::size_t VorbisSynthesis::readInterleaved(int16_t* const out, const std::size_t maxFrames) {
+        const std::size_t numFrames{ std::min(maxFrames, getNumPendingFrames()) };
+        write(out, 0, numChannels_, numFrames, kernels_.overlapAddInt16, kernels_.interleaveInt16);
+        position_ += numFrames;
+        return numFrames;
+    }
+
+    std::size_t VorbisSynthesis::readPlanar(float* const* const out, const std::size_t maxFrames) {
+        const std::size_t numFrames{ std::min(maxFrames, getNumPendingFrames()) };
+        for (std::size_t channel{ 0 }; channel < numChannels_; channel++) {
+            write(out[channel], channel, 1, numFrames, kernels_.overlapAddFloat, kernels_.interleaveFloat);
+        }
+        position_ += numFrames;
+        return numFrames;
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef VORBIS_SYNTHESIS_H
+#define VORBIS_SYNTHESIS_H
+
+#include "VorbisDsp.h"
+#include "VorbisImdct.h"
+#include "VorbisSetup.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace vcpp {
+
+    /**
+    * Turns the decoded blocks of a Vorbis stream into PCM samples. Each block is windowed and
+    * overlap-added with the previous one, which makes the frames between the centers of
+    * both blocks available. The frames are computed while they are read, directly into
+    * the caller's buffers, so that they are never copied.
+    */
+    class VorbisSynthesis {
+        const std::size_t numChannels_;
+        const VorbisDspKernels& kernels_;
+        const std::array<uint16_t, 2> blockSizes_;
+
+        // Windows for short and long blocks.
+        std::array<std::shared_ptr<const VorbisImdct>, 2> imdcts_;
+
+        // Samples of the last two blocks. The samples of channel c start at c * size.
+        std::vector<float> previous_;
+        std::vector<float> current_;
+        std::size_t previousSize_;
+        std::size_t currentSize_;
+
+        // Frames [position_, numFrames_) of the overlap between the previous and the current
+        // block are not read yet.
+        std::size_t position_;
+        std::size_t numFrames_;
+
+        // Number of frames of the stream up to numFrames_.
+        uint64_t streamPosition_;
+
+        // Channel pointers passed to the kernels.
+        std::vector<const float*> previousChannels_;
+        std::vector<const float*> currentChannels_;
+
+        /**
+        * Writes the next numFrames pending frames of numChannels channels, starting with
+        * firstChannel, without consuming them. The frames are written in up to three
+        * parts: frames that only come from the previous block, frames where both blocks
+        * overlap, and frames that only come from the current block.
+        */
+        template <typename Sample>
+        void write(
+            Sample* const out,
+            const std::size_t firstChannel,
+            const std::size_t numChannels,
+            const std::size_t numFrames,
+            void (*const overlapAdd)(const float* const*, const float* const*, const float*, const float*, std::size_t, std::size_t, Sample*),
+            void (*const interleave)(const float* const*, std::size_t, std::size_t, Sample*));
+
+    public:
+        /**
+        * Constructs a VorbisSynthesis for a stream.
+        *
+        * @param identification The identification header of the stream.
+        * @param kernels The signal processing kernels to use.
+        */
+        VorbisSynthesis(const VorbisIdentification& identification, const VorbisDspKernels& kernels = getVorbisDspKernels());
+
+        /**
+        * Adds the next block of the stream. The block holds the unwindowed samples of all
+        * channels, blockSize for each channel one after another, as written by
+        * VorbisDecoder::decodeBlock(). The vector is swapped with a buffer that is no
+        * longer needed, so its contents are taken over without copying and the caller
+        * can reuse the returned buffer for the next block. Frames of the previous block that
+        * were not read are discarded.
+        *
+        * @param block Samples of the block, exchanged for a free buffer.
+        * @param blockSize The block size.
+        */
+        void addBlock(std::vector<float>& block, const std::size_t blockSize);
+
+        /**
+        * Returns the number of frames that can be read.
+        */
+        std::size_t getNumPendingFrames() const {
+            return numFrames_ - position_;
+        }
+
+        /**
+        * Returns the number of frames of the stream, including the pending frames.
+        */
+        uint64_t getStreamPosition() const {
+            return streamPosition_;
+        }
+
+        /**
+        * Drops pending frames, so that the stream ends after numFrames frames. This is
+        * used for the granule position of the last page, which can end the stream in the
+        * middle of a block.
+        */
+        void truncate(const uint64_t numFrames);
+
+        /**
+        * Reads up to maxFrames pending frames as interleaved 32-bit float samples. The
+        * pending frames can be read with any number of calls, for example to fill the
+        * two parts of a ring buffer.
+        *
+        * @param out Output for the samples, with room for maxFrames frames.
+        * @param maxFrames Maximum number of frames to read.
+        * @return The number of frames read.
+        */
+        std::size_t readInterleaved(float* const out, const std::size_t maxFrames);
+
+        /**
+        * Reads up to maxFrames pending frames as interleaved 16-bit samples. Samples
+        * outside of [-1, 1] are clamped.
+        */
+        std::size_t readInterleaved(int16_t* const out, const std::size_t maxFrames);
+
+        /**
+        * Reads up to maxFrames pending frames as 32-bit float samples, with a separate
+        * buffer for each channel.
+        *
+        * @param out Output buffer for each channel.
+        * @param maxFrames Maximum number of frames to read.
+        * @return The number of frames read.
+        */
+        std::size_t readPlanar(float* const* const out, const std::size_t maxFrames);
+    };
+}
+
+#endif
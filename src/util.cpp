@@ -2,27 +2,362 @@
 
 #include <cstdint>
 #include <memory>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#   define VCPP_CLMUL_X86
+#   include <immintrin.h>
+#   if defined(_MSC_VER) && !defined(__clang__)
+#       include <intrin.h>
+#       define VCPP_CLMUL_TARGET
+#   else
+#       include <cpuid.h>
+#       define VCPP_CLMUL_TARGET __attribute__((target("pclmul,ssse3,sse4.1")))
+#   endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   define VCPP_CLMUL_ARM
+#   include <arm_neon.h>
+#   if defined(_MSC_VER) && !defined(__clang__)
+#       define VCPP_CLMUL_TARGET
+#   elif defined(__clang__)
+#       define VCPP_CLMUL_TARGET __attribute__((target("aes")))
+#   else
+#       define VCPP_CLMUL_TARGET __attribute__((target("+crypto")))
+#   endif
+#   if defined(__linux__)
+#       include <sys/auxv.h>
+#       include <asm/hwcap.h>
+#   endif
+#endif
 
 using namespace vcpp;
+using namespace vcpp::detail;
+
+//----------------------------------------------
+//                 MappedFile
+//----------------------------------------------
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& path)
+    : data_{ nullptr }, size_{ 0 }, isValid_{ false }, mapping_{ nullptr } {
+    const HANDLE file{ CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
 
-static uint32_t crc32TableEntry(uint8_t mask, const uint32_t polynomial) {
-    uint32_t out = 0;
-    for (std::size_t i = 0; i < 8; i++) {
-        if ((mask & 0x80) != 0) {
-            out ^= polynomial << (7 - i);
-            mask ^= polynomial >> 25;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return;
+    }
+
+    if (fileSize.QuadPart == 0) {
+        isValid_ = true;
+    }
+    else {
+        mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ != nullptr) {
+            data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+            if (data_ != nullptr) {
+                size_ = std::size_t(fileSize.QuadPart);
+                isValid_ = true;
+            }
+            else {
+                CloseHandle(mapping_);
+                mapping_ = nullptr;
+            }
         }
-        mask <<= 1;
     }
-    return out;
+    CloseHandle(file);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+        CloseHandle(mapping_);
+    }
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_{ other.data_ }, size_{ other.size_ }, isValid_{ other.isValid_ }, mapping_{ other.mapping_ } {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.isValid_ = false;
+    other.mapping_ = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) : data_{ nullptr }, size_{ 0 }, isValid_{ false } {
+    const int fd{ open(path.c_str(), O_RDONLY) };
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return;
+    }
+
+    if (info.st_size == 0) {
+        isValid_ = true;
+    }
+    else {
+        void* const mapping{ mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0) };
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, std::size_t(info.st_size), MADV_SEQUENTIAL);
+            data_ = static_cast<const uint8_t*>(mapping);
+            size_ = std::size_t(info.st_size);
+            isValid_ = true;
+        }
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_{ other.data_ }, size_{ other.size_ }, isValid_{ other.isValid_ } {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.isValid_ = false;
+}
+
+#endif
+
+//----------------------------------------------
+//                   CRC32
+//----------------------------------------------
+
+// The carry-less multiplication kernels treat the input as one long polynomial and
+// repeatedly fold 128 bit blocks forward by multiplying them with x^n mod P. Blocks are
+// loaded big-endian, so that the first byte holds the highest coefficients.
+#if defined(VCPP_CLMUL_X86)
+
+static bool detectCarrylessMultiply() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    const unsigned int ecx{ static_cast<unsigned int>(info[2]) };
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+#endif
+    const unsigned int pclmulqdq{ 1 << 1 };
+    const unsigned int ssse3{ 1 << 9 };
+    const unsigned int sse41{ 1 << 19 };
+    return (ecx & pclmulqdq) != 0 && (ecx & ssse3) != 0 && (ecx & sse41) != 0;
+}
+
+VCPP_CLMUL_TARGET static inline __m128i clmulLoad(const uint8_t* const data) {
+    const __m128i reverse{ _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15) };
+    return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), reverse);
+}
+
+VCPP_CLMUL_TARGET static inline __m128i clmulFold(const __m128i block, const __m128i constants) {
+    return _mm_xor_si128(
+        _mm_clmulepi64_si128(block, constants, 0x11),
+        _mm_clmulepi64_si128(block, constants, 0x00));
+}
+
+VCPP_CLMUL_TARGET uint32_t detail::crc32CarrylessMultiply(
+    const CRC32Tables& tables,
+    const CRC32FoldingConstants& constants,
+    const uint8_t* data,
+    std::size_t size,
+    uint32_t remainder
+) {
+    if (size < crc32CarrylessMultiplyThreshold) {
+        return crc32Slicing16(tables, data, size, remainder);
+    }
+
+    // Adding the remainder to the first 32 bits of the data is equivalent to 
+    // multiplying it by x^(8 * size).
+    __m128i x0{ _mm_xor_si128(clmulLoad(data), _mm_set_epi32(int(remainder), 0, 0, 0)) };
+    __m128i x1{ clmulLoad(data + 16) };
+    __m128i x2{ clmulLoad(data + 32) };
+    __m128i x3{ clmulLoad(data + 48) };
+    data += 64;
+    size -= 64;
+
+    const __m128i fold512{ _mm_set_epi64x(constants.fold512[0], constants.fold512[1]) };
+    for (; size >= 64; size -= 64, data += 64) {
+        x0 = _mm_xor_si128(clmulFold(x0, fold512), clmulLoad(data));
+        x1 = _mm_xor_si128(clmulFold(x1, fold512), clmulLoad(data + 16));
+        x2 = _mm_xor_si128(clmulFold(x2, fold512), clmulLoad(data + 32));
+        x3 = _mm_xor_si128(clmulFold(x3, fold512), clmulLoad(data + 48));
+    }
+
+    const __m128i fold128{ _mm_set_epi64x(constants.fold128[0], constants.fold128[1]) };
+    x1 = _mm_xor_si128(clmulFold(x0, fold128), x1);
+    x2 = _mm_xor_si128(clmulFold(x1, fold128), x2);
+    __m128i x{ _mm_xor_si128(clmulFold(x2, fold128), x3) };
+    for (; size >= 16; size -= 16, data += 16) {
+        x = _mm_xor_si128(clmulFold(x, fold128), clmulLoad(data));
+    }
+
+    // Reduce x * x^32 to 96 bits, then to 64 bits.
+    const __m128i reduce{ _mm_set_epi64x(constants.reduce[0], constants.reduce[1]) };
+    const __m128i y{ _mm_xor_si128(
+        _mm_clmulepi64_si128(x, reduce, 0x11),
+        _mm_slli_si128(_mm_move_epi64(x), 4)) };
+    const __m128i z{ _mm_xor_si128(
+        _mm_clmulepi64_si128(_mm_srli_si128(y, 8), reduce, 0x00),
+        _mm_move_epi64(y)) };
+
+    // Barrett reduction of the remaining 64 bits.
+    const __m128i barrett{ _mm_set_epi64x(constants.barrett[0], constants.barrett[1]) };
+    const __m128i quotient{ _mm_srli_epi64(_mm_clmulepi64_si128(_mm_srli_epi64(z, 32), barrett, 0x10), 32) };
+    const __m128i product{ _mm_clmulepi64_si128(quotient, barrett, 0x00) };
+    remainder = uint32_t(_mm_cvtsi128_si32(_mm_xor_si128(z, product)));
+
+    return crc32Slicing16(tables, data, size, remainder);
+}
+
+#elif defined(VCPP_CLMUL_ARM)
+
+static bool detectCarrylessMultiply() {
+#if defined(__APPLE__)
+    return true;
+#elif defined(_WIN32)
+    return IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE) != 0;
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+#else
+    return false;
+#endif
+}
+
+VCPP_CLMUL_TARGET static inline uint64x2_t clmulLoad(const uint8_t* const data) {
+    const uint64x2_t halves{ vreinterpretq_u64_u8(vrev64q_u8(vld1q_u8(data))) };
+    return vextq_u64(halves, halves, 1);
+}
+
+VCPP_CLMUL_TARGET static inline uint64x2_t clmulMultiply(const uint64_t a, const uint64_t b) {
+    return vreinterpretq_u64_p128(vmull_p64(poly64_t(a), poly64_t(b)));
+}
+
+VCPP_CLMUL_TARGET static inline uint64x2_t clmulFold(const uint64x2_t block, const uint64x2_t constants) {
+    return veorq_u64(
+        clmulMultiply(vgetq_lane_u64(block, 1), vgetq_lane_u64(constants, 1)),
+        clmulMultiply(vgetq_lane_u64(block, 0), vgetq_lane_u64(constants, 0)));
+}
+
+VCPP_CLMUL_TARGET uint32_t detail::crc32CarrylessMultiply(
+    const CRC32Tables& tables,
+    const CRC32FoldingConstants& constants,
+    const uint8_t* data,
+    std::size_t size,
+    uint32_t remainder
+) {
+    if (size < crc32CarrylessMultiplyThreshold) {
+        return crc32Slicing16(tables, data, size, remainder);
+    }
+
+    // Adding the remainder to the first 32 bits of the data is equivalent to 
+    // multiplying it by x^(8 * size).
+    const uint64x2_t initial{ vcombine_u64(vcreate_u64(0), vcreate_u64(uint64_t(remainder) << 32)) };
+    uint64x2_t x0{ veorq_u64(clmulLoad(data), initial) };
+    uint64x2_t x1{ clmulLoad(data + 16) };
+    uint64x2_t x2{ clmulLoad(data + 32) };
+    uint64x2_t x3{ clmulLoad(data + 48) };
+    data += 64;
+    size -= 64;
+
+    const uint64x2_t fold512{ vcombine_u64(vcreate_u64(constants.fold512[1]), vcreate_u64(constants.fold512[0])) };
+    for (; size >= 64; size -= 64, data += 64) {
+        x0 = veorq_u64(clmulFold(x0, fold512), clmulLoad(data));
+        x1 = veorq_u64(clmulFold(x1, fold512), clmulLoad(data + 16));
+        x2 = veorq_u64(clmulFold(x2, fold512), clmulLoad(data + 32));
+        x3 = veorq_u64(clmulFold(x3, fold512), clmulLoad(data + 48));
+    }
+
+    const uint64x2_t fold128{ vcombine_u64(vcreate_u64(constants.fold128[1]), vcreate_u64(constants.fold128[0])) };
+    x1 = veorq_u64(clmulFold(x0, fold128), x1);
+    x2 = veorq_u64(clmulFold(x1, fold128), x2);
+    uint64x2_t x{ veorq_u64(clmulFold(x2, fold128), x3) };
+    for (; size >= 16; size -= 16, data += 16) {
+        x = veorq_u64(clmulFold(x, fold128), clmulLoad(data));
+    }
+
+    // Reduce x * x^32 to 96 bits, then to 64 bits.
+    const uint64_t high{ vgetq_lane_u64(x, 1) };
+    const uint64_t low{ vgetq_lane_u64(x, 0) };
+    const uint64x2_t y{ veorq_u64(
+        clmulMultiply(high, constants.reduce[0]),
+        vcombine_u64(vcreate_u64(low << 32), vcreate_u64(low >> 32))) };
+    const uint64_t z{ vgetq_lane_u64(clmulMultiply(vgetq_lane_u64(y, 1), constants.reduce[1]), 0) ^ vgetq_lane_u64(y, 0) };
+
+    // Barrett reduction of the remaining 64 bits.
+    const uint64_t quotient{ vgetq_lane_u64(clmulMultiply(z >> 32, constants.barrett[0]), 0) >> 32 };
+    const uint64_t product{ vgetq_lane_u64(clmulMultiply(quotient, constants.barrett[1]), 0) };
+    remainder = uint32_t(z ^ product);
+
+    return crc32Slicing16(tables, data, size, remainder);
+}
+
+#else
+
+static bool detectCarrylessMultiply() {
+    return false;
+}
+
+uint32_t detail::crc32CarrylessMultiply(
+    const CRC32Tables& tables,
+    const CRC32FoldingConstants&,
+    const uint8_t* data,
+    std::size_t size,
+    uint32_t remainder
+) {
+    return crc32Slicing16(tables, data, size, remainder);
+}
+
+#endif
+
+bool detail::crc32HasCarrylessMultiply() {
+    static const bool hasCarrylessMultiply{ detectCarrylessMultiply() };
+    return hasCarrylessMultiply;
+}
+
+CRC32::CRC32(const uint32_t polynomial, const Method method)
+    : polynomial_(polynomial),
+      tables_(std::make_shared<const CRC32Tables>(polynomial)),
+      foldingConstants_(polynomial),
+      method_(method != Method::Auto ? method
+          : isSupported(Method::CarrylessMultiply) ? Method::CarrylessMultiply
+          : Method::Slicing16) {
+    if (!isSupported(method_)) {
+        throw std::invalid_argument("CRC32 method is not supported by this CPU.");
+    }
 }
 
-std::shared_ptr<uint32_t[256]> CRC32::generateLookupTable(const uint32_t polynomial) {
-    const std::shared_ptr<uint32_t[256]> table{ new uint32_t[256] };
-    for (std::size_t i{ 0 }; i < 256; i++) {
-        table[i] = crc32TableEntry(uint8_t(i), polynomial);
+bool CRC32::isSupported(const Method method) {
+    if (method == Method::CarrylessMultiply) {
+        return crc32HasCarrylessMultiply();
     }
-    return table;
+    return true;
 }
 
 uint32_t CRC32::operator() (
@@ -30,13 +365,18 @@ uint32_t CRC32::operator() (
     const std::size_t size,
     const uint32_t initialRemainder
 ) const {
-    uint32_t remainder{ initialRemainder };
-    for (std::size_t i{ 0 }; i < size; i++) {
-        remainder = operator()(data[i], remainder);
+    switch (method_) {
+    case Method::CarrylessMultiply:
+        return crc32CarrylessMultiply(*tables_, foldingConstants_, data, size, initialRemainder);
+    case Method::Slicing16:
+        return crc32Slicing16(*tables_, data, size, initialRemainder);
+    case Method::Slicing8:
+        return crc32Slicing8(*tables_, data, size, initialRemainder);
+    default:
+        return crc32Bytewise(*tables_, data, size, initialRemainder);
     }
-    return remainder;
 }
 
 uint32_t CRC32::operator() (const uint8_t value, const uint32_t remainder) const {
-    return (remainder << 8) ^ lookupTable_[value ^ (remainder >> 24)];
+    return (remainder << 8) ^ tables_->entries[0][value ^ (remainder >> 24)];
 }
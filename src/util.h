@@ -5,6 +5,7 @@
 #include <memory>
 #include <unordered_map>
 #include <array>
+#include <string>
 
 namespace vcpp {
     inline uint32_t readUInt32LE(const uint8_t* const data) {
@@ -14,6 +15,13 @@ namespace vcpp {
             | (uint32_t(data[3]) << 24);
     }
 
+    inline uint32_t readUInt32BE(const uint8_t* const data) {
+        return (uint32_t(data[0]) << 24)
+            | (uint32_t(data[1]) << 16)
+            | (uint32_t(data[2]) << 8)
+            | uint32_t(data[3]);
+    }
+
     inline uint64_t readUInt64LE(const uint8_t* const data) {
         return uint64_t(data[0])
             | (uint64_t(data[1]) << 8)
@@ -43,15 +51,315 @@ namespace vcpp {
         data[7] = (value >> 56) & 0xff;
     }
 
+    /**
+    * Read-only memory mapping of a whole file. The mapping is released when the 
+    * object is destroyed.
+    */
+    class MappedFile {
+        const uint8_t* data_;
+        std::size_t size_;
+        bool isValid_;
+#if defined(_WIN32)
+        void* mapping_;
+#endif
+
+    public:
+        /**
+        * Maps the file at the given path. If the file can not be opened or mapped,
+        * isValid() returns false.
+        * 
+        * @param path Path of the file.
+        */
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) = delete;
+
+        const uint8_t* data() const {
+            return data_;
+        }
+
+        std::size_t size() const {
+            return size_;
+        }
+
+        bool isValid() const {
+            return isValid_;
+        }
+    };
+
+    namespace detail {
+        // Number of lookup tables required by the slicing algorithms. Table k maps a byte
+        // to its contribution to the remainder when it is followed by k more bytes.
+        constexpr std::size_t crc32NumLookupTables = 16;
+
+        constexpr uint32_t crc32TableEntry(uint8_t mask, const uint32_t polynomial) {
+            uint32_t out{ 0 };
+            for (std::size_t i{ 0 }; i < 8; i++) {
+                if ((mask & 0x80) != 0) {
+                    out ^= polynomial << (7 - i);
+                    mask ^= polynomial >> 25;
+                }
+                mask <<= 1;
+            }
+            return out;
+        }
+
+        // Computes x^n mod P.
+        constexpr uint32_t crc32PowerOfX(const std::size_t n, const uint32_t polynomial) {
+            uint32_t out{ 1 };
+            for (std::size_t i{ 0 }; i < n; i++) {
+                out = (out << 1) ^ ((out & 0x80000000) != 0 ? polynomial : 0);
+            }
+            return out;
+        }
+
+        // Computes a * b mod P.
+        constexpr uint32_t crc32MultiplyModP(const uint32_t a, const uint32_t b, const uint32_t polynomial) {
+            uint32_t product{ 0 };
+            for (int bit{ 31 }; bit >= 0; bit--) {
+                product = (product << 1) ^ ((product & 0x80000000) != 0 ? polynomial : 0);
+                if (((b >> bit) & 1) != 0) {
+                    product ^= a;
+                }
+            }
+            return product;
+        }
+
+        // Computes remainder * x^(8 * size) mod P, which is the remainder after
+        // appending size zero bytes to the data.
+        constexpr uint32_t crc32AppendZeros(uint32_t remainder, uint64_t size, const uint32_t polynomial) {
+            uint32_t power{ crc32PowerOfX(8, polynomial) };
+            for (; size > 0; size >>= 1) {
+                if ((size & 1) != 0) {
+                    remainder = crc32MultiplyModP(remainder, power, polynomial);
+                }
+                power = crc32MultiplyModP(power, power, polynomial);
+            }
+            return remainder;
+        }
+
+        // Computes floor(x^64 / P), the constant for Barrett reduction.
+        constexpr uint64_t crc32BarrettConstant(const uint32_t polynomial) {
+            const uint64_t fullPolynomial{ (uint64_t(1) << 32) | polynomial };
+            uint64_t quotient{ 0 };
+            uint64_t remainder{ 0 };
+            for (int bit{ 64 }; bit >= 0; bit--) {
+                remainder = (remainder << 1) | (bit == 64 ? 1 : 0);
+                if ((remainder & (uint64_t(1) << 32)) != 0) {
+                    remainder ^= fullPolynomial;
+                    quotient |= uint64_t(1) << bit;
+                }
+            }
+            return quotient;
+        }
+
+        /**
+        * Lookup tables for the bytewise and slicing algorithms.
+        */
+        struct CRC32Tables {
+            uint32_t entries[crc32NumLookupTables][256];
+
+            constexpr explicit CRC32Tables(const uint32_t polynomial) : entries{} {
+                for (std::size_t i{ 0 }; i < 256; i++) {
+                    entries[0][i] = crc32TableEntry(uint8_t(i), polynomial);
+                }
+                // Appending a zero byte multiplies the remainder by x^8, which is one bytewise step.
+                for (std::size_t k{ 1 }; k < crc32NumLookupTables; k++) {
+                    for (std::size_t i{ 0 }; i < 256; i++) {
+                        const uint32_t previous{ entries[k - 1][i] };
+                        entries[k][i] = (previous << 8) ^ entries[0][previous >> 24];
+                    }
+                }
+            }
+        };
+
+        /**
+        * Constants of the form x^n mod P used by the carry-less multiplication kernel.
+        * Each pair holds the multipliers for the high and low halves of a 128 bit block.
+        */
+        struct CRC32FoldingConstants {
+            uint64_t fold512[2];
+            uint64_t fold128[2];
+            uint64_t reduce[2];
+            uint64_t barrett[2];
+
+            constexpr explicit CRC32FoldingConstants(const uint32_t polynomial)
+                : fold512{ crc32PowerOfX(512 + 64, polynomial), crc32PowerOfX(512, polynomial) },
+                  fold128{ crc32PowerOfX(128 + 64, polynomial), crc32PowerOfX(128, polynomial) },
+                  reduce{ crc32PowerOfX(96, polynomial), crc32PowerOfX(64, polynomial) },
+                  barrett{ crc32BarrettConstant(polynomial), (uint64_t(1) << 32) | polynomial } {}
+        };
+
+        inline uint32_t crc32Bytewise(
+            const CRC32Tables& tables,
+            const uint8_t* data,
+            std::size_t size,
+            uint32_t remainder
+        ) {
+            for (; size > 0; size--) {
+                remainder = (remainder << 8) ^ tables.entries[0][*data++ ^ (remainder >> 24)];
+            }
+            return remainder;
+        }
+
+        // Folds the four bytes of word into the remainder, assuming they are followed
+        // by `offset` more bytes.
+        inline uint32_t crc32Slice(const CRC32Tables& tables, const uint32_t word, const std::size_t offset) {
+            return tables.entries[offset + 3][word >> 24]
+                ^ tables.entries[offset + 2][(word >> 16) & 0xff]
+                ^ tables.entries[offset + 1][(word >> 8) & 0xff]
+                ^ tables.entries[offset][word & 0xff];
+        }
+
+        inline uint32_t crc32Slicing8(
+            const CRC32Tables& tables,
+            const uint8_t* data,
+            std::size_t size,
+            uint32_t remainder
+        ) {
+            for (; size >= 8; size -= 8, data += 8) {
+                remainder = crc32Slice(tables, remainder ^ readUInt32BE(data), 4)
+                    ^ crc32Slice(tables, readUInt32BE(data + 4), 0);
+            }
+            return crc32Bytewise(tables, data, size, remainder);
+        }
+
+        inline uint32_t crc32Slicing16(
+            const CRC32Tables& tables,
+            const uint8_t* data,
+            std::size_t size,
+            uint32_t remainder
+        ) {
+            for (; size >= 16; size -= 16, data += 16) {
+                remainder = crc32Slice(tables, remainder ^ readUInt32BE(data), 12)
+                    ^ crc32Slice(tables, readUInt32BE(data + 4), 8)
+                    ^ crc32Slice(tables, readUInt32BE(data + 8), 4)
+                    ^ crc32Slice(tables, readUInt32BE(data + 12), 0);
+            }
+            return crc32Slicing8(tables, data, size, remainder);
+        }
+
+        // Minimum input size for which the carry-less multiplication kernel is used.
+        constexpr std::size_t crc32CarrylessMultiplyThreshold = 64;
+
+        bool crc32HasCarrylessMultiply();
+
+        uint32_t crc32CarrylessMultiply(
+            const CRC32Tables& tables,
+            const CRC32FoldingConstants& constants,
+            const uint8_t* data,
+            std::size_t size,
+            uint32_t remainder);
+    }
+
+    /**
+    * Calculates MSB-first (non-reflected) CRC32 checksums for a polynomial chosen at runtime.
+    */
     class CRC32 {
-        const std::shared_ptr<uint32_t[256]> lookupTable_;
+    public:
+        /**
+        * Algorithm used to update the checksum. All methods produce identical results.
+        */
+        enum class Method {
+            // Selects the fastest method supported by the CPU.
+            Auto,
+
+            // Reference implementation, processes one byte per table lookup.
+            Bytewise,
+
+            // Processes 8 bytes per iteration using 8 lookup tables.
+            Slicing8,
+
+            // Processes 16 bytes per iteration using 16 lookup tables.
+            Slicing16,
+
+            // Folds 64 bytes per iteration using carry-less multiplication
+            // (PCLMULQDQ on x86-64, PMULL on AArch64).
+            CarrylessMultiply
+        };
+
+    private:
+        const uint32_t polynomial_;
+        const std::shared_ptr<const detail::CRC32Tables> tables_;
+        const detail::CRC32FoldingConstants foldingConstants_;
+        const Method method_;
 
-        static std::shared_ptr<uint32_t[256]> generateLookupTable(const uint32_t polynomial);
     public:
-        CRC32(const uint32_t polynomial) : lookupTable_(generateLookupTable(polynomial)) {}
+        /**
+        * Constructs a CRC32 for the given polynomial. The polynomial is given without 
+        * its implicit x^32 term, e.g. 0x04C11DB7 for the polynomial used by Ogg.
+        * 
+        * @param polynomial The generator polynomial.
+        * @param method The algorithm to use. Throws std::invalid_argument if the method 
+        *               is not supported by the CPU.
+        */
+        CRC32(const uint32_t polynomial, const Method method = Method::Auto);
+
+        /**
+        * Returns true if the given method can be used on this CPU.
+        */
+        static bool isSupported(const Method method);
+
+        /**
+        * Returns the method used by this object. Never returns Method::Auto.
+        */
+        Method getMethod() const {
+            return method_;
+        }
 
         uint32_t operator() (const uint8_t* const data, const std::size_t size, const uint32_t initialRemainder = 0) const;
         uint32_t operator() (const uint8_t value, const uint32_t remainder = 0) const;
+
+        /**
+        * Calculates the checksum of the concatenation of two buffers A and B from the
+        * checksums of the individual buffers. This allows the buffers to be checksummed
+        * independently, e.g. on different threads or before all data is known.
+        * 
+        * @param checksumA Checksum of A. May be calculated with any initial remainder.
+        * @param checksumB Checksum of B, calculated with an initial remainder of 0.
+        * @param sizeB Size of B in bytes.
+        */
+        uint32_t combine(const uint32_t checksumA, const uint32_t checksumB, const uint64_t sizeB) const {
+            return detail::crc32AppendZeros(checksumA, sizeB, polynomial_) ^ checksumB;
+        }
+    };
+
+    /**
+    * Calculates MSB-first (non-reflected) CRC32 checksums for a polynomial known at compile time.
+    * The lookup tables are generated at compile time, so objects of this type 
+    * can be declared constexpr and do not require any initialization at runtime.
+    */
+    template<uint32_t Polynomial>
+    class StaticCRC32 {
+        static constexpr detail::CRC32Tables tables_{ Polynomial };
+        static constexpr detail::CRC32FoldingConstants foldingConstants_{ Polynomial };
+
+    public:
+        constexpr StaticCRC32() = default;
+
+        inline uint32_t operator() (const uint8_t* const data, const std::size_t size, const uint32_t initialRemainder = 0) const {
+            if (size >= detail::crc32CarrylessMultiplyThreshold && detail::crc32HasCarrylessMultiply()) {
+                return detail::crc32CarrylessMultiply(tables_, foldingConstants_, data, size, initialRemainder);
+            }
+            return detail::crc32Slicing16(tables_, data, size, initialRemainder);
+        }
+
+        inline uint32_t operator() (const uint8_t value, const uint32_t remainder = 0) const {
+            return (remainder << 8) ^ tables_.entries[0][value ^ (remainder >> 24)];
+        }
+
+        /**
+        * Calculates the checksum of the concatenation of two buffers A and B from the
+        * checksums of the individual buffers. See CRC32::combine().
+        */
+        constexpr uint32_t combine(const uint32_t checksumA, const uint32_t checksumB, const uint64_t sizeB) const {
+            return detail::crc32AppendZeros(checksumA, sizeB, Polynomial) ^ checksumB;
+        }
     };
 }
 
@@ -0,0 +1,70 @@
+#ifndef OGG_TEST_STREAMS_H
+#define OGG_TEST_STREAMS_H
+
+#include "OggStream.h"
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+* Returns a packet of the given size whose contents depend on index.
+*/
+inline std::vector<uint8_t> makePacket(const std::size_t index, const std::size_t size) {
+    std::vector<uint8_t> packet(size);
+    for (std::size_t i{ 0 }; i < size; i++) {
+        packet[i] = uint8_t((index * 31 + i) & 0xff);
+    }
+    return packet;
+}
+
+/**
+* Writes two logical streams with one packet per page. The packets of the first stream have
+* even granule positions, those of the second stream odd ones.
+*/
+inline void writeSeekTestStream(std::basic_ostream<uint8_t>& out, const std::size_t numPackets, const uint32_t seed) {
+    vcpp::OggPhysicalStreamOut outPhysical{ out };
+    vcpp::OggLogicalStreamOut logicalStreams[]{ outPhysical.newLogicalStream(), outPhysical.newLogicalStream() };
+    for (std::size_t i{ 0 }; i < numPackets; i++) {
+        const std::vector<uint8_t> packet{ makePacket(i, (i * 7919 + seed) % 6000) };
+        logicalStreams[i % 2].write(packet.data(), unsigned(packet.size()), int64_t(i), true, i + 2 >= numPackets);
+    }
+}
+
+/**
+* Writes the stream of writeSeekTestStream() to a file. Throws if the file cannot be written.
+*/
+inline void writeSeekTestFile(const std::string& path, const std::size_t numPackets, const uint32_t seed) {
+    std::basic_stringstream<uint8_t> stream{};
+    writeSeekTestStream(stream, numPackets, seed);
+    const std::basic_string<uint8_t> content{ stream.str() };
+
+    FILE* const file{ std::fopen(path.c_str(), "wb") };
+    if (file == nullptr) {
+        throw std::runtime_error("Failed to create " + path);
+    }
+    const std::size_t numWritten{ std::fwrite(content.data(), 1, content.size(), file) };
+    std::fclose(file);
+    if (numWritten != content.size()) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+/**
+* Returns the granule position of the first packet of the stream after the current position,
+* or -1 if there is none.
+*/
+inline int64_t readGranule(vcpp::OggPhysicalStreamIn& in, const uint32_t serial) {
+    while (const std::optional<vcpp::OggPacket> packet{ in.nextPacket() }) {
+        if (packet->streamSerialNumber == serial && packet->meta.granulePosition != -1) {
+            return packet->meta.granulePosition;
+        }
+    }
+    return -1;
+}
+
+#endif
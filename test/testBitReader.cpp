@@ -0,0 +1,51 @@
+#include "BitReader.h"
+#include <cstdint>
+#include <vector>
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+
+using namespace vcpp;
+
+RC_GTEST_PROP(TestBitReader, values_are_read_lsb_first,
+    (const std::vector<uint32_t> values, const std::vector<uint8_t> widthsRaw)) {
+    RC_PRE(widthsRaw.size() > 0);
+
+    // Pack the values starting at the lowest bit of each byte.
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> expected;
+    std::size_t numBits{ 0 };
+    for (std::size_t i{ 0 }; i < values.size(); i++) {
+        const unsigned int width{ widthsRaw[i % widthsRaw.size()] % 32u + 1 };
+        const uint32_t value{ width == 32 ? values[i] : values[i] & ((uint32_t(1) << width) - 1) };
+        for (unsigned int bit{ 0 }; bit < width; bit++, numBits++) {
+            if (numBits % 8 == 0) {
+                data.push_back(0);
+            }
+            data.back() |= uint8_t(((value >> bit) & 1) << (numBits % 8));
+        }
+        expected.push_back(value);
+    }
+
+    BitReader reader{ data.data(), data.size() };
+    for (std::size_t i{ 0 }; i < values.size(); i++) {
+        const unsigned int width{ widthsRaw[i % widthsRaw.size()] % 32u + 1 };
+        RC_ASSERT(reader.read(width) == expected[i]);
+    }
+    RC_ASSERT(!reader.isEndOfPacket());
+    RC_ASSERT(reader.getNumRemainingBits() == data.size() * 8 - numBits);
+}
+
+TEST(TestBitReader, reading_past_the_end_sets_end_of_packet) {
+    const uint8_t data[]{ 0xff, 0x01 };
+    BitReader reader{ data, sizeof(data) };
+
+    EXPECT_EQ(reader.read(4), 0xfu);
+    EXPECT_EQ(reader.read(3), 0x7u);
+    EXPECT_FALSE(reader.isEndOfPacket());
+
+    // Only 9 bits are left, the missing bits are zero.
+    EXPECT_EQ(reader.read(16), 0x3u);
+    EXPECT_TRUE(reader.isEndOfPacket());
+    EXPECT_EQ(reader.read(8), 0u);
+    EXPECT_TRUE(reader.isEndOfPacket());
+}
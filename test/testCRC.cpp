@@ -95,3 +95,115 @@ RC_GTEST_PROP(testCRC, checksums_can_be_merged_by_setting_initial_remainder_to_p
 
     RC_ASSERT(check1 == check2);
 }
+
+static uint32_t referenceCRC(const uint8_t* const data, const std::size_t size, const uint32_t initialRemainder) {
+    const vcpp::CRC32 crc(0x04C11DB7, vcpp::CRC32::Method::Bytewise);
+    return crc(data, size, initialRemainder);
+}
+
+RC_GTEST_PROP(testCRC, slicing_by_8_matches_bytewise,
+    (const std::vector<uint8_t> dataVec, const std::size_t offset, const uint32_t initialRemainder)) {
+
+    const std::size_t start = dataVec.empty() ? 0 : offset % dataVec.size();
+    const uint8_t* const data = dataVec.data() + start;
+    const std::size_t size = dataVec.size() - start;
+
+    const vcpp::CRC32 crc(0x04C11DB7, vcpp::CRC32::Method::Slicing8);
+    RC_ASSERT(crc(data, size, initialRemainder) == referenceCRC(data, size, initialRemainder));
+}
+
+RC_GTEST_PROP(testCRC, slicing_by_16_matches_bytewise,
+    (const std::vector<uint8_t> dataVec, const std::size_t offset, const uint32_t initialRemainder)) {
+
+    const std::size_t start = dataVec.empty() ? 0 : offset % dataVec.size();
+    const uint8_t* const data = dataVec.data() + start;
+    const std::size_t size = dataVec.size() - start;
+
+    const vcpp::CRC32 crc(0x04C11DB7, vcpp::CRC32::Method::Slicing16);
+    RC_ASSERT(crc(data, size, initialRemainder) == referenceCRC(data, size, initialRemainder));
+}
+
+RC_GTEST_PROP(testCRC, slicing_matches_bytewise_for_any_polynomial,
+    (const std::vector<uint8_t> dataVec, const uint32_t polynomial)) {
+
+    const vcpp::CRC32 bytewise(polynomial, vcpp::CRC32::Method::Bytewise);
+    const vcpp::CRC32 slicing8(polynomial, vcpp::CRC32::Method::Slicing8);
+    const vcpp::CRC32 slicing16(polynomial, vcpp::CRC32::Method::Slicing16);
+    const uint32_t expected = bytewise(dataVec.data(), dataVec.size());
+    RC_ASSERT(slicing8(dataVec.data(), dataVec.size()) == expected);
+    RC_ASSERT(slicing16(dataVec.data(), dataVec.size()) == expected);
+}
+
+RC_GTEST_PROP(testCRC, carryless_multiply_matches_bytewise,
+    (const std::vector<uint8_t> dataVec, const std::size_t offset, const uint32_t initialRemainder)) {
+    // Passes trivially without CLMUL, instead of discarding every case.
+    if (!vcpp::CRC32::isSupported(vcpp::CRC32::Method::CarrylessMultiply)) {
+        return;
+    }
+
+    const std::size_t start = dataVec.empty() ? 0 : offset % dataVec.size();
+    const uint8_t* const data = dataVec.data() + start;
+    const std::size_t size = dataVec.size() - start;
+
+    const vcpp::CRC32 crc(0x04C11DB7, vcpp::CRC32::Method::CarrylessMultiply);
+    RC_ASSERT(crc(data, size, initialRemainder) == referenceCRC(data, size, initialRemainder));
+}
+
+RC_GTEST_PROP(testCRC, carryless_multiply_matches_bytewise_for_any_polynomial,
+    (const std::vector<uint8_t> dataVec, const uint32_t polynomial, const uint32_t initialRemainder)) {
+    // Passes trivially without CLMUL, instead of discarding every case.
+    if (!vcpp::CRC32::isSupported(vcpp::CRC32::Method::CarrylessMultiply)) {
+        return;
+    }
+
+    const vcpp::CRC32 bytewise(polynomial, vcpp::CRC32::Method::Bytewise);
+    const vcpp::CRC32 clmul(polynomial, vcpp::CRC32::Method::CarrylessMultiply);
+    RC_ASSERT(clmul(dataVec.data(), dataVec.size(), initialRemainder)
+        == bytewise(dataVec.data(), dataVec.size(), initialRemainder));
+}
+
+TEST(testCRC, auto_method_is_resolved) {
+    const vcpp::CRC32 crc(0x04C11DB7);
+    EXPECT_NE(crc.getMethod(), vcpp::CRC32::Method::Auto);
+    EXPECT_TRUE(vcpp::CRC32::isSupported(crc.getMethod()));
+}
+
+static_assert(vcpp::detail::CRC32Tables(0x04C11DB7).entries[0][1] == 0x04C11DB7,
+    "CRC32 lookup tables must be computable at compile time.");
+
+RC_GTEST_PROP(testCRC, static_crc_matches_runtime_crc,
+    (const std::vector<uint8_t> dataVec, const uint32_t initialRemainder)) {
+
+    constexpr vcpp::StaticCRC32<0x04C11DB7> staticCRC{};
+    RC_ASSERT(staticCRC(dataVec.data(), dataVec.size(), initialRemainder)
+        == referenceCRC(dataVec.data(), dataVec.size(), initialRemainder));
+
+    uint32_t remainder = initialRemainder;
+    for (const uint8_t value : dataVec) {
+        remainder = staticCRC(value, remainder);
+    }
+    RC_ASSERT(remainder == referenceCRC(dataVec.data(), dataVec.size(), initialRemainder));
+}
+
+RC_GTEST_PROP(testCRC, combined_checksums_match_checksum_of_concatenation,
+    (const std::vector<uint8_t> dataVec, std::size_t split, const uint32_t initialRemainder)) {
+
+    const std::size_t size = dataVec.size();
+    split = size == 0 ? 0 : split % (size + 1);
+    const uint8_t* const data = dataVec.data();
+
+    const vcpp::CRC32 crc(0x04C11DB7);
+    const uint32_t checkA = crc(data, split, initialRemainder);
+    const uint32_t checkB = crc(data + split, size - split);
+    RC_ASSERT(crc.combine(checkA, checkB, size - split) == crc(data, size, initialRemainder));
+
+    constexpr vcpp::StaticCRC32<0x04C11DB7> staticCRC{};
+    RC_ASSERT(staticCRC.combine(checkA, checkB, size - split) == crc(data, size, initialRemainder));
+}
+
+TEST(testCRC, combine_handles_large_sizes) {
+    const vcpp::CRC32 crc(0x04C11DB7);
+    const std::vector<uint8_t> zeros(100000, 0);
+    const uint32_t check = crc(zeros.data(), zeros.size(), 0x12345678);
+    EXPECT_EQ(crc.combine(0x12345678, 0, zeros.size()), check);
+}
@@ -0,0 +1,105 @@
+#include "IoUring.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace vcpp;
+
+#if defined(__linux__)
+
+static std::vector<uint8_t> writeTestFile(const std::string& path, const std::size_t size) {
+    std::vector<uint8_t> content(size);
+    for (std::size_t i{ 0 }; i < size; i++) {
+        content[i] = uint8_t((i * 31) ^ (i >> 8));
+    }
+    FILE* const file{ std::fopen(path.c_str(), "wb") };
+    std::fwrite(content.data(), 1, content.size(), file);
+    std::fclose(file);
+    return content;
+}
+
+RC_GTEST_PROP(TestIoUring, reads_return_the_file_contents,
+    (const std::vector<uint32_t> offsets)) {
+    IoUring ring{ 4 };
+    RC_PRE(ring.isValid());
+
+    const std::string path{ (std::filesystem::temp_directory_path() / "vcpp_test_io_uring.bin").string() };
+    const std::vector<uint8_t> content{ writeTestFile(path, 100000) };
+    const int fd{ open(path.c_str(), O_RDONLY) };
+    RC_ASSERT(fd >= 0);
+
+    // Submit more reads than the ring has entries before collecting any of them.
+    std::vector<std::vector<uint8_t>> buffers;
+    std::vector<uint64_t> ids;
+    for (const uint32_t offsetRaw : offsets) {
+        const uint64_t offset{ offsetRaw % 110000 };
+        buffers.emplace_back(1000);
+        ids.push_back(ring.submitRead(fd, buffers.back().data(), 1000, offset));
+    }
+    for (std::size_t i{ ids.size() }; i-- > 0;) {
+        const uint64_t offset{ offsets[i] % 110000 };
+        const int32_t result{ ring.waitForRead(ids[i]) };
+        const std::size_t expectedSize{ offset < content.size() ? std::min<std::size_t>(1000, content.size() - offset) : 0 };
+        RC_ASSERT(result == int32_t(expectedSize));
+        RC_ASSERT(std::equal(buffers[i].begin(), buffers[i].begin() + expectedSize, content.begin() + std::min<std::size_t>(offset, content.size())));
+    }
+
+    close(fd);
+    std::filesystem::remove(path);
+}
+
+TEST(TestIoUring, ring_can_be_shared_by_threads) {
+    const std::shared_ptr<IoUring> ring{ std::make_shared<IoUring>(2) };
+    if (!ring->isValid()) {
+        GTEST_SKIP() << "io_uring is not available.";
+    }
+
+    const std::string path{ (std::filesystem::temp_directory_path() / "vcpp_test_io_uring_threads.bin").string() };
+    const std::vector<uint8_t> content{ writeTestFile(path, 65536) };
+    const int fd{ open(path.c_str(), O_RDONLY) };
+    ASSERT_GE(fd, 0);
+
+    std::vector<std::thread> threads;
+    std::vector<char> isCorrect(8, true);
+    for (std::size_t t{ 0 }; t < isCorrect.size(); t++) {
+        threads.emplace_back([&, t]() {
+            for (std::size_t i{ 0 }; i < 64; i++) {
+                uint8_t buffer[1024];
+                const uint64_t offset{ ((t * 64 + i) * 1024) % content.size() };
+                const int32_t result{ ring->waitForRead(ring->submitRead(fd, buffer, sizeof(buffer), offset)) };
+                if (result != int32_t(sizeof(buffer)) || !std::equal(buffer, buffer + sizeof(buffer), content.begin() + offset)) {
+                    isCorrect[t] = false;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    close(fd);
+    std::filesystem::remove(path);
+
+    for (const char correct : isCorrect) {
+        EXPECT_TRUE(correct);
+    }
+}
+
+#else
+
+TEST(TestIoUring, ring_is_invalid_without_io_uring) {
+    EXPECT_FALSE(IoUring{}.isValid());
+}
+
+#endif
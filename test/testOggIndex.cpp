@@ -0,0 +1,76 @@
+#include "OggIndex.h"
+#include "OggStream.h"
+#include "oggTestStreams.h"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+
+using namespace vcpp;
+
+/**
+* Writes the seek test stream to a file and returns the serial number of its first stream.
+*/
+static uint32_t writeIndexTestFile(const std::string& path, const std::size_t numPackets, const uint32_t seed) {
+    writeSeekTestFile(path, numPackets, seed);
+    OggPhysicalStreamIn in{ path };
+    return in.nextPage()->streamSerialNumber;
+}
+
+RC_GTEST_PROP(TestOggIndex, index_seeks_find_the_same_page_as_bisection,
+    (const uint32_t seed, const uint32_t intervalRaw, const std::vector<uint32_t> targets)) {
+    const std::filesystem::path directory{ std::filesystem::temp_directory_path() };
+    const std::string oggPath{ (directory / "vcpp_test_index.ogg").string() };
+    const std::string indexPath{ (directory / "vcpp_test_index.ogg.idx").string() };
+    const std::size_t numPackets{ 200 };
+    const uint32_t serial{ writeIndexTestFile(oggPath, numPackets, seed) };
+
+    OggIndex::build(oggPath, indexPath, intervalRaw % 0x40000);
+    const OggIndex index{ indexPath, oggPath };
+    RC_ASSERT(index.isValid());
+
+    OggPhysicalStreamIn in{ oggPath };
+    for (const uint32_t targetRaw : targets) {
+        const int64_t target{ int64_t(targetRaw % (numPackets + 10)) };
+        const int64_t expected{ target % 2 == 0 ? target : target + 1 };
+
+        const std::optional<OggIndex::Entry> entry{ index.findEntryBefore(serial, target) };
+        RC_ASSERT(!entry || entry->granulePosition < target);
+
+        const bool isFound{ index.seekToGranule(in, serial, target) };
+        RC_ASSERT(isFound == (expected < int64_t(numPackets)));
+        RC_ASSERT(readGranule(in, serial) == (isFound ? expected : -1));
+    }
+
+    std::filesystem::remove(oggPath);
+    std::filesystem::remove(indexPath);
+}
+
+TEST(TestOggIndex, index_is_invalid_if_the_file_changed) {
+    const std::filesystem::path directory{ std::filesystem::temp_directory_path() };
+    const std::string oggPath{ (directory / "vcpp_test_index_changed.ogg").string() };
+    const std::string indexPath{ (directory / "vcpp_test_index_changed.ogg.idx").string() };
+    writeIndexTestFile(oggPath, 20, 1);
+
+    OggIndex::build(oggPath, indexPath);
+    EXPECT_TRUE(OggIndex(indexPath, oggPath).isValid());
+
+    FILE* const file{ std::fopen(oggPath.c_str(), "ab") };
+    ASSERT_NE(file, nullptr);
+    std::fputc(0, file);
+    std::fclose(file);
+    EXPECT_FALSE(OggIndex(indexPath, oggPath).isValid());
+
+    EXPECT_FALSE(OggIndex(indexPath + ".missing", oggPath).isValid());
+
+    std::filesystem::remove(oggPath);
+    std::filesystem::remove(indexPath);
+}
+
+TEST(TestOggIndex, building_an_index_for_a_missing_file_throws) {
+    EXPECT_THROW(OggIndex::build("vcpp_missing_file.ogg", "vcpp_missing_file.ogg.idx"), OggStreamError);
+}
@@ -1,9 +1,18 @@
 #include "OggStream.h"
+#include "oggTestStreams.h"
 #include <cstdint>
 #include <sstream>
 #include <algorithm>
 #include <numeric>
 #include <memory>
+#include <cstdio>
+#include <filesystem>
+#include <memory_resource>
+#include <thread>
+#include <unordered_map>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 #include <gtest/gtest.h>
 #include <rapidcheck/gtest.h>
 
@@ -36,6 +45,16 @@ public:
     }
 };
 
+class CollectingDataCallback : public OggLogicalStreamIn::DataCallback {
+public:
+    std::vector<uint8_t> bytes;
+
+    void onDataAvailable(const uint8_t* const data, const std::size_t size, const OggLogicalStreamIn::MetaData meta) {
+        (void)meta;
+        bytes.insert(bytes.end(), data, data + size);
+    }
+};
+
 template<typename C>
 class TestNewStreamCallback : public OggPhysicalStreamIn::NewStreamCallback {
 public:
@@ -105,3 +124,1151 @@ RC_GTEST_PROP(TestOggStream, data_is_read_and_written_correctly,
         }
     }
 }
+
+RC_GTEST_PROP(TestOggStream, mapped_input_reads_the_same_data_as_file_input,
+    (const std::vector<uint32_t> packetSizes)) {
+    RC_PRE(packetSizes.size() > 0);
+    RC_PRE(packetSizes.size() <= 10);
+
+    const std::filesystem::path path{ std::filesystem::temp_directory_path() / "vcpp_test_mapped_input.ogg" };
+
+    // Write data to a file
+    FILE* outFile{ std::fopen(path.string().c_str(), "wb") };
+    RC_ASSERT(outFile != nullptr);
+    std::size_t totalSize{ 0 };
+    {
+        OggPhysicalStreamOut outPhysical{ outFile };
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < packetSizes.size(); i++) {
+            const std::size_t size{ packetSizes[i] % 100000 };
+            std::vector<uint8_t> data(size);
+            for (std::size_t j{ 0 }; j < size; j++) {
+                data[j] = uint8_t((i + j) & 0xff);
+            }
+            outLogical.write(data.data(), unsigned(size), 0, true, i + 1 == packetSizes.size());
+            totalSize += size;
+        }
+    }
+    std::fclose(outFile);
+
+    // Read it back through FILE* and through the mapping
+    FILE* inFile{ std::fopen(path.string().c_str(), "rb") };
+    RC_ASSERT(inFile != nullptr);
+    const auto fileCallback{ std::make_shared<TestNewStreamCallback<CollectingDataCallback>>() };
+    {
+        OggPhysicalStreamIn inPhysical{ inFile };
+        inPhysical.addNewStreamCallback(fileCallback);
+        inPhysical.process();
+    }
+    std::fclose(inFile);
+
+    const auto mappedCallback{ std::make_shared<TestNewStreamCallback<CollectingDataCallback>>() };
+    {
+        OggPhysicalStreamIn inPhysical{ path.string() };
+        inPhysical.addNewStreamCallback(mappedCallback);
+        inPhysical.process();
+    }
+    std::filesystem::remove(path);
+
+    RC_ASSERT(mappedCallback->dataCallbacks.size() == 1);
+    RC_ASSERT(mappedCallback->dataCallbacks[0]->bytes.size() == totalSize);
+    RC_ASSERT(mappedCallback->dataCallbacks[0]->bytes == fileCallback->dataCallbacks[0]->bytes);
+}
+
+TEST(TestOggStream, mapping_a_missing_file_throws) {
+    try {
+        OggPhysicalStreamIn inPhysical{ std::string{ "/nonexistent/vcpp_test.ogg" } };
+        FAIL();
+    }
+    catch (const OggStreamError& e) {
+        EXPECT_EQ(e.getCause(), OggStreamError::Cause::IOError);
+    }
+}
+
+RC_GTEST_PROP(TestOggStream, junk_between_pages_is_skipped_and_counted,
+    (const std::vector<uint32_t> packetSizes, const std::vector<uint8_t> junkSelectors, const std::size_t junkRepeat)) {
+    RC_PRE(packetSizes.size() > 0);
+    RC_PRE(packetSizes.size() <= 10);
+
+    // Junk made of the capture pattern's letters, but without a complete capture pattern.
+    const uint8_t letters[4]{ 'O', 'g', 'S', 'x' };
+    std::vector<uint8_t> junk;
+    for (std::size_t r{ 0 }; r < junkRepeat % 300 + 1; r++) {
+        for (const uint8_t selector : junkSelectors) {
+            junk.push_back(letters[selector % 4]);
+        }
+    }
+    for (std::size_t i{ 3 }; i < junk.size(); i++) {
+        if (junk[i - 3] == 'O' && junk[i - 2] == 'g' && junk[i - 1] == 'g' && junk[i] == 'S') {
+            junk[i] = 'x';
+        }
+    }
+
+    std::basic_stringstream<uint8_t> stream{};
+    stream.write(junk.data(), junk.size());
+    std::size_t totalSize{ 0 };
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < packetSizes.size(); i++) {
+            const std::size_t size{ packetSizes[i] % 100000 };
+            const std::vector<uint8_t> data(size, uint8_t(i));
+            outLogical.write(data.data(), unsigned(size), 0, true, i + 1 == packetSizes.size());
+            totalSize += size;
+        }
+    }
+    stream.write(junk.data(), junk.size());
+
+    OggPhysicalStreamIn inPhysical{ stream };
+    const auto callback{ std::make_shared<TestNewStreamCallback<TestDataCallback>>() };
+    inPhysical.addNewStreamCallback(callback);
+    inPhysical.process();
+
+    RC_ASSERT(callback->dataCallbacks.size() == 1);
+    RC_ASSERT(callback->dataCallbacks[0]->bytesRead == totalSize);
+    RC_ASSERT(callback->dataCallbacks[0]->numPackets == packetSizes.size());
+    RC_ASSERT(inPhysical.getNumSkippedBytes() == 2 * junk.size());
+}
+
+class CountingMemoryResource : public std::pmr::memory_resource {
+public:
+    std::size_t numAllocations{ 0 };
+    std::size_t numOutstanding{ 0 };
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        numAllocations++;
+        numOutstanding++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        numOutstanding--;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+RC_GTEST_PROP(TestOggStream, page_buffers_are_recycled,
+    (const std::vector<uint32_t> packetSizes)) {
+    RC_PRE(packetSizes.size() > 0);
+    RC_PRE(packetSizes.size() <= 20);
+
+    std::basic_stringstream<uint8_t> stream{};
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < packetSizes.size(); i++) {
+            const std::size_t size{ packetSizes[i] % 100000 };
+            const std::vector<uint8_t> data(size, uint8_t(i));
+            outLogical.write(data.data(), unsigned(size), 0, true, i + 1 == packetSizes.size());
+        }
+    }
+
+    CountingMemoryResource resource{};
+    {
+        OggPhysicalStreamIn inPhysical{ stream, &resource };
+        const auto callback{ std::make_shared<TestNewStreamCallback<TestDataCallback>>() };
+        inPhysical.addNewStreamCallback(callback);
+        inPhysical.process();
+
+        // Pages are released after they are dispatched, so a single buffer is enough.
+        RC_ASSERT(resource.numAllocations == 1);
+    }
+    RC_ASSERT(resource.numOutstanding == 0);
+}
+
+class TestPacketCallback : public OggLogicalStreamIn::PacketCallback, public OggLogicalStreamIn::DataCallback {
+public:
+    std::vector<std::vector<uint8_t>> packets;
+    std::vector<OggLogicalStreamIn::PacketMetaData> metas;
+    std::size_t numZeroCopyPackets{ 0 };
+    const uint8_t* pageBegin{ nullptr };
+    const uint8_t* pageEnd{ nullptr };
+
+    void onDataAvailable(const uint8_t* const data, const std::size_t size, const OggLogicalStreamIn::MetaData meta) {
+        (void)meta;
+        pageBegin = data;
+        pageEnd = data + size;
+    }
+
+    void onPacketAvailable(const uint8_t* const data, const std::size_t size, const OggLogicalStreamIn::PacketMetaData meta) {
+        packets.emplace_back(data, data + size);
+        metas.push_back(meta);
+        if (size > 0 && data >= pageBegin && data + size <= pageEnd) {
+            numZeroCopyPackets++;
+        }
+    }
+};
+
+class TestPacketNewStreamCallback : public OggPhysicalStreamIn::NewStreamCallback {
+public:
+    std::vector<std::shared_ptr<TestPacketCallback>> callbacks;
+
+    void onNewStream(OggLogicalStreamIn& stream) {
+        callbacks.emplace_back(std::make_shared<TestPacketCallback>());
+        stream.addDataCallback(callbacks.back());
+        stream.addPacketCallback(callbacks.back());
+    }
+};
+
+RC_GTEST_PROP(TestOggStream, packets_are_reassembled,
+    (const std::vector<uint32_t> packetSizes, const std::size_t numLogicalStreamsRaw)) {
+    RC_PRE(packetSizes.size() > 0);
+    RC_PRE(packetSizes.size() <= 20);
+
+    // Mix in sizes at the lacing and page boundaries.
+    const uint32_t specialSizes[]{ 0, 1, 254, 255, 256, 510, 65024, 65025, 65026, 130050 };
+    std::vector<std::size_t> sizes;
+    for (const uint32_t size : packetSizes) {
+        sizes.push_back(size % 3 == 0 ? specialSizes[(size / 3) % 10] : size % 100000);
+    }
+
+    std::basic_stringstream<uint8_t> stream{};
+    const std::size_t numLogicalStreams{ numLogicalStreamsRaw % 4 + 1 };
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        std::vector<OggLogicalStreamOut> logicalStreams;
+        for (std::size_t i{ 0 }; i < numLogicalStreams; i++) {
+            logicalStreams.emplace_back(outPhysical.newLogicalStream());
+        }
+        for (std::size_t i{ 0 }; i < sizes.size(); i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, sizes[i]) };
+            logicalStreams[i % numLogicalStreams].write(
+                packet.data(), unsigned(packet.size()), int64_t(i), true, i + numLogicalStreams >= sizes.size());
+        }
+    }
+
+    OggPhysicalStreamIn inPhysical{ stream };
+    const auto callback{ std::make_shared<TestPacketNewStreamCallback>() };
+    inPhysical.addNewStreamCallback(callback);
+    inPhysical.process();
+
+    RC_ASSERT(callback->callbacks.size() == std::min(numLogicalStreams, sizes.size()));
+    for (std::size_t s{ 0 }; s < callback->callbacks.size(); s++) {
+        const TestPacketCallback& packetCallback{ *callback->callbacks[s] };
+        std::size_t packetIndex{ 0 };
+        for (std::size_t i{ s }; i < sizes.size(); i += numLogicalStreams) {
+            RC_ASSERT(packetIndex < packetCallback.packets.size());
+            RC_ASSERT(packetCallback.packets[packetIndex] == makePacket(i, sizes[i]));
+            const OggLogicalStreamIn::PacketMetaData& meta{ packetCallback.metas[packetIndex] };
+            RC_ASSERT(meta.granulePosition == int64_t(i));
+            RC_ASSERT(meta.numSkippedPages == 0u);
+            RC_ASSERT(meta.isFirstPacket == (packetIndex == 0));
+            RC_ASSERT(meta.isLastPacket == (i + numLogicalStreams >= sizes.size()));
+            packetIndex++;
+        }
+        RC_ASSERT(packetIndex == packetCallback.packets.size());
+    }
+}
+
+TEST(TestOggStream, packets_within_a_page_are_not_copied) {
+    std::basic_stringstream<uint8_t> stream{};
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < 10; i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, 1000) };
+            outLogical.write(packet.data(), unsigned(packet.size()), 0, true, i == 9);
+        }
+    }
+
+    OggPhysicalStreamIn inPhysical{ stream };
+    const auto callback{ std::make_shared<TestPacketNewStreamCallback>() };
+    inPhysical.addNewStreamCallback(callback);
+    inPhysical.process();
+
+    ASSERT_EQ(callback->callbacks.size(), 1u);
+    EXPECT_EQ(callback->callbacks[0]->packets.size(), 10u);
+    EXPECT_EQ(callback->callbacks[0]->numZeroCopyPackets, 10u);
+}
+
+RC_GTEST_PROP(TestOggStream, pulled_packets_match_written_packets,
+    (const std::vector<uint32_t> packetSizes, const std::size_t numLogicalStreamsRaw)) {
+    RC_PRE(packetSizes.size() > 0);
+    RC_PRE(packetSizes.size() <= 20);
+
+    std::vector<std::size_t> sizes;
+    for (const uint32_t size : packetSizes) {
+        sizes.push_back(size % 100000);
+    }
+
+    std::basic_stringstream<uint8_t> stream{};
+    const std::size_t numLogicalStreams{ numLogicalStreamsRaw % 4 + 1 };
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        std::vector<OggLogicalStreamOut> logicalStreams;
+        for (std::size_t i{ 0 }; i < numLogicalStreams; i++) {
+            logicalStreams.emplace_back(outPhysical.newLogicalStream());
+        }
+        for (std::size_t i{ 0 }; i < sizes.size(); i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, sizes[i]) };
+            logicalStreams[i % numLogicalStreams].write(
+                packet.data(), unsigned(packet.size()), int64_t(i), true, i + numLogicalStreams >= sizes.size());
+        }
+    }
+
+    OggPhysicalStreamIn inPhysical{ stream };
+    std::vector<uint32_t> serials;
+    std::vector<std::size_t> nextIndex;
+    std::size_t numPackets{ 0 };
+    while (const std::optional<OggPacket> packet{ inPhysical.nextPacket() }) {
+        const auto serialIt{ std::find(serials.begin(), serials.end(), packet->streamSerialNumber) };
+        const std::size_t s{ std::size_t(serialIt - serials.begin()) };
+        if (serialIt == serials.end()) {
+            serials.push_back(packet->streamSerialNumber);
+            nextIndex.push_back(s);
+        }
+
+        const std::size_t i{ nextIndex[s] };
+        RC_ASSERT(i < sizes.size());
+        RC_ASSERT(std::vector<uint8_t>(packet->data, packet->data + packet->size) == makePacket(i, sizes[i]));
+        RC_ASSERT(packet->meta.granulePosition == int64_t(i));
+        RC_ASSERT(packet->meta.isFirstPacket == (i == s));
+        RC_ASSERT(packet->meta.isLastPacket == (i + numLogicalStreams >= sizes.size()));
+        nextIndex[s] += numLogicalStreams;
+        numPackets++;
+    }
+
+    RC_ASSERT(numPackets == sizes.size());
+    RC_ASSERT_FALSE(inPhysical.nextPacket().has_value());
+}
+
+TEST(TestOggStream, pulled_pages_can_be_read_partially) {
+    std::basic_stringstream<uint8_t> stream{};
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < 10; i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, 100) };
+            outLogical.write(packet.data(), unsigned(packet.size()), int64_t(i), true, i == 9);
+        }
+    }
+
+    OggPhysicalStreamIn inPhysical{ stream };
+    const std::optional<OggPage> first{ inPhysical.nextPage() };
+    ASSERT_TRUE(first.has_value());
+    EXPECT_TRUE(first->isFirstPage);
+    EXPECT_EQ(first->granulePosition, 0);
+    EXPECT_EQ(std::vector<uint8_t>(first->getData(), first->getData() + first->dataSize), makePacket(0, 100));
+
+    const std::optional<OggPage> second{ inPhysical.nextPage() };
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(second->pageSequenceNumber, first->pageSequenceNumber + 1);
+    EXPECT_EQ(second->granulePosition, 1);
+}
+
+RC_GTEST_PROP(TestOggStream, packed_packets_are_reassembled,
+    (const std::vector<uint32_t> packetSizes, const uint32_t targetPageSizeRaw, const uint32_t maxGranuleSpanRaw)) {
+    RC_PRE(packetSizes.size() > 0);
+    RC_PRE(packetSizes.size() <= 40);
+
+    // Mix in sizes at the lacing and page boundaries.
+    const uint32_t specialSizes[]{ 0, 1, 254, 255, 256, 510, 65024, 65025, 65026, 130050 };
+    std::vector<std::size_t> sizes;
+    for (const uint32_t size : packetSizes) {
+        sizes.push_back(size % 3 == 0 ? specialSizes[(size / 3) % 10] : size % 2000);
+    }
+    const unsigned int targetPageSize{ targetPageSizeRaw % 10000 + 1 };
+    const int64_t maxGranuleSpan{ int64_t(maxGranuleSpanRaw % 10) - 1 };
+
+    std::basic_stringstream<uint8_t> stream{};
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        outLogical.enablePacking(targetPageSize, maxGranuleSpan);
+        for (std::size_t i{ 0 }; i < sizes.size(); i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, sizes[i]) };
+            outLogical.write(packet.data(), unsigned(packet.size()), int64_t(i), true, i + 1 == sizes.size());
+        }
+    }
+
+    // Every page carries the granule position of the last packet ending on it.
+    OggPhysicalStreamIn pageReader{ stream };
+    int64_t previousGranulePosition{ -1 };
+    while (const std::optional<OggPage> page{ pageReader.nextPage() }) {
+        if (page->granulePosition != -1) {
+            RC_ASSERT(page->granulePosition > previousGranulePosition);
+            if (maxGranuleSpan >= 0 && !page->isLastPage) {
+                RC_ASSERT(page->granulePosition - previousGranulePosition <= maxGranuleSpan + 1);
+            }
+            previousGranulePosition = page->granulePosition;
+        }
+    }
+    RC_ASSERT(previousGranulePosition == int64_t(sizes.size() - 1));
+
+    stream.clear();
+    stream.seekg(0);
+    OggPhysicalStreamIn inPhysical{ stream };
+    const auto callback{ std::make_shared<TestPacketNewStreamCallback>() };
+    inPhysical.addNewStreamCallback(callback);
+    inPhysical.process();
+
+    RC_ASSERT(callback->callbacks.size() == 1u);
+    const TestPacketCallback& packetCallback{ *callback->callbacks[0] };
+    RC_ASSERT(packetCallback.packets.size() == sizes.size());
+    for (std::size_t i{ 0 }; i < sizes.size(); i++) {
+        RC_ASSERT(packetCallback.packets[i] == makePacket(i, sizes[i]));
+        const OggLogicalStreamIn::PacketMetaData& meta{ packetCallback.metas[i] };
+        RC_ASSERT(meta.granulePosition == -1 || meta.granulePosition == int64_t(i));
+        RC_ASSERT(meta.numSkippedPages == 0u);
+        RC_ASSERT(meta.isLastPacket == (i + 1 == sizes.size()));
+    }
+}
+
+TEST(TestOggStream, packing_writes_fewer_pages) {
+    std::basic_stringstream<uint8_t> stream{};
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        outLogical.enablePacking(1000);
+
+        // The first packet gets a page of its own, like the identification header of a Vorbis stream.
+        const std::vector<uint8_t> header{ makePacket(0, 30) };
+        outLogical.write(header.data(), unsigned(header.size()), 0);
+        outLogical.flush();
+
+        for (std::size_t i{ 1 }; i <= 20; i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, 100) };
+            outLogical.write(packet.data(), unsigned(packet.size()), int64_t(i));
+        }
+        // The remaining packets are written by the destructor.
+    }
+
+    OggPhysicalStreamIn inPhysical{ stream };
+    std::vector<int64_t> granulePositions;
+    std::vector<std::size_t> pageSizes;
+    while (const std::optional<OggPage> page{ inPhysical.nextPage() }) {
+        granulePositions.push_back(page->granulePosition);
+        pageSizes.push_back(page->dataSize);
+    }
+    EXPECT_EQ(granulePositions, (std::vector<int64_t>{ 0, 10, 20 }));
+    EXPECT_EQ(pageSizes, (std::vector<std::size_t>{ 30, 1000, 1000 }));
+}
+
+TEST(TestOggStream, closing_a_stream_with_an_open_packet_keeps_its_data) {
+    const std::vector<uint8_t> packet{ makePacket(0, 600) };
+    std::basic_stringstream<uint8_t> packedStream{};
+    std::basic_stringstream<uint8_t> unpackedStream{};
+    {
+        OggPhysicalStreamOut packedPhysical{ packedStream };
+        OggPhysicalStreamOut unpackedPhysical{ unpackedStream };
+        OggLogicalStreamOut packedLogical{ packedPhysical.newLogicalStream() };
+        OggLogicalStreamOut unpackedLogical{ unpackedPhysical.newLogicalStream() };
+        packedLogical.enablePacking();
+        packedLogical.write(packet.data(), unsigned(packet.size()), 0, false, true);
+        unpackedLogical.write(packet.data(), unsigned(packet.size()), 0, false, true);
+    }
+    EXPECT_EQ(packedStream.str(), unpackedStream.str());
+
+    OggPhysicalStreamIn inPhysical{ packedStream };
+    const auto callback{ std::make_shared<TestPacketNewStreamCallback>() };
+    inPhysical.addNewStreamCallback(callback);
+    inPhysical.process();
+    ASSERT_EQ(callback->callbacks.size(), 1u);
+    ASSERT_EQ(callback->callbacks[0]->packets.size(), 1u);
+    EXPECT_EQ(callback->callbacks[0]->packets[0], packet);
+}
+
+RC_GTEST_PROP(TestOggStream, descriptor_output_writes_the_same_data_as_stream_output,
+    (const std::vector<uint32_t> packetSizes)) {
+    RC_PRE(packetSizes.size() > 0);
+    RC_PRE(packetSizes.size() <= 10);
+
+    const std::filesystem::path path{ std::filesystem::temp_directory_path() / "vcpp_test_descriptor_output.ogg" };
+
+    std::basic_stringstream<uint8_t> stream{};
+    FILE* outFile{ std::fopen(path.string().c_str(), "wb") };
+    RC_ASSERT(outFile != nullptr);
+    {
+        OggPhysicalStreamOut streamPhysical{ stream };
+        OggPhysicalStreamOut descriptorPhysical{ fileno(outFile) };
+        OggLogicalStreamOut streamLogical{ streamPhysical.newLogicalStream() };
+        OggLogicalStreamOut descriptorLogical{ descriptorPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < packetSizes.size(); i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, packetSizes[i] % 200000) };
+            const bool isLast{ i + 1 == packetSizes.size() };
+            streamLogical.write(packet.data(), unsigned(packet.size()), int64_t(i), true, isLast);
+            descriptorLogical.write(packet.data(), unsigned(packet.size()), int64_t(i), true, isLast);
+        }
+        descriptorPhysical.flush();
+    }
+    std::fclose(outFile);
+
+    const MappedFile written{ path.string() };
+    const std::basic_string<uint8_t> expected{ stream.str() };
+    RC_ASSERT(written.size() == expected.size());
+    RC_ASSERT(std::equal(expected.begin(), expected.end(), written.data()));
+    std::filesystem::remove(path);
+}
+
+TEST(TestOggStream, write_errors_are_reported) {
+    const std::filesystem::path path{ std::filesystem::temp_directory_path() / "vcpp_test_write_errors.ogg" };
+    std::fclose(std::fopen(path.string().c_str(), "wb"));
+    const std::vector<uint8_t> packet{ makePacket(0, 100) };
+
+    const auto expectIOError = [&](OggPhysicalStreamOut& outPhysical) {
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        try {
+            outLogical.write(packet.data(), unsigned(packet.size()), 0);
+            FAIL() << "Expected an OggStreamError.";
+        }
+        catch (const OggStreamError& e) {
+            EXPECT_EQ(e.getCause(), OggStreamError::Cause::IOError);
+        }
+    };
+
+    // The file is only opened for reading, so writes to it fail.
+    FILE* const file{ std::fopen(path.string().c_str(), "rb") };
+    ASSERT_NE(file, nullptr);
+    {
+        OggPhysicalStreamOut outPhysical{ file };
+        expectIOError(outPhysical);
+    }
+    {
+        OggPhysicalStreamOut outPhysical{ fileno(file) };
+        expectIOError(outPhysical);
+    }
+    std::fclose(file);
+
+    std::basic_stringstream<uint8_t> stream{};
+    stream.setstate(std::ios_base::badbit);
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        expectIOError(outPhysical);
+        EXPECT_THROW(outPhysical.flush(), OggStreamError);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(TestOggStream, failed_writes_are_not_repeated) {
+    const std::vector<uint8_t> packet{ makePacket(0, 100) };
+    std::basic_stringstream<uint8_t> stream{};
+    OggPhysicalStreamOut outPhysical{ stream };
+    OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+
+    stream.setstate(std::ios_base::badbit);
+    EXPECT_THROW(outLogical.write(packet.data(), unsigned(packet.size()), 0), OggStreamError);
+    stream.clear();
+    outLogical.write(packet.data(), unsigned(packet.size()), 1);
+
+    // Only the second page is written: a 27 byte header, one lacing value and the packet.
+    const std::basic_string<uint8_t> written{ stream.str() };
+    EXPECT_EQ(written.size(), 27 + 1 + packet.size());
+}
+
+TEST(TestOggStream, muxed_pages_are_ordered_by_time) {
+    const uint32_t sampleRates[]{ 48000, 44100, 8000 };
+    const std::size_t numPackets{ 200 };
+
+    std::basic_stringstream<uint8_t> stream{};
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        outPhysical.startMuxing(4);
+
+        // Each stream uses its sample rate as serial number.
+        std::vector<OggLogicalStreamOut> logicalStreams;
+        for (const uint32_t sampleRate : sampleRates) {
+            logicalStreams.emplace_back(outPhysical.newLogicalStream(sampleRate).value());
+            logicalStreams.back().setTimeMapping([sampleRate](const int64_t granulePosition) {
+                return double(granulePosition) / sampleRate;
+            });
+        }
+
+        std::vector<std::thread> producers;
+        for (std::size_t s{ 0 }; s < logicalStreams.size(); s++) {
+            OggLogicalStreamOut& outLogical{ logicalStreams[s] };
+            const uint32_t sampleRate{ sampleRates[s] };
+            producers.emplace_back([&outLogical, sampleRate, numPackets]() {
+                // Packets of 20 ms, written as fast as possible.
+                for (std::size_t i{ 0 }; i < numPackets; i++) {
+                    const std::vector<uint8_t> packet{ makePacket(i, 300) };
+                    outLogical.write(packet.data(), unsigned(packet.size()), int64_t((i + 1) * sampleRate / 50), true, i + 1 == numPackets);
+                }
+            });
+        }
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+        outPhysical.finishMuxing();
+    }
+
+    OggPhysicalStreamIn inPhysical{ stream };
+    std::unordered_map<uint32_t, std::size_t> numPages;
+    double previousTime{ 0 };
+    while (const std::optional<OggPage> page{ inPhysical.nextPage() }) {
+        const double time{ double(page->granulePosition) / page->streamSerialNumber };
+        EXPECT_GE(time, previousTime);
+        previousTime = time;
+        numPages[page->streamSerialNumber]++;
+    }
+    ASSERT_EQ(numPages.size(), 3u);
+    for (const auto& entry : numPages) {
+        EXPECT_EQ(entry.second, numPackets);
+    }
+}
+
+TEST(TestOggStream, muxer_write_errors_are_reported) {
+    const std::filesystem::path path{ std::filesystem::temp_directory_path() / "vcpp_test_muxer_errors.ogg" };
+    std::fclose(std::fopen(path.string().c_str(), "wb"));
+    FILE* const file{ std::fopen(path.string().c_str(), "rb") };
+    ASSERT_NE(file, nullptr);
+    {
+        OggPhysicalStreamOut outPhysical{ fileno(file) };
+        outPhysical.startMuxing(1);
+        {
+            OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+            const std::vector<uint8_t> packet{ makePacket(0, 100) };
+            try {
+                // Eventually, the queue is closed by the failing muxer.
+                for (std::size_t i{ 0 }; i < 100; i++) {
+                    outLogical.write(packet.data(), unsigned(packet.size()), int64_t(i));
+                }
+                FAIL() << "Expected an OggStreamError.";
+            }
+            catch (const OggStreamError& e) {
+                EXPECT_EQ(e.getCause(), OggStreamError::Cause::IOError);
+            }
+        }
+        try {
+            outPhysical.finishMuxing();
+            FAIL() << "Expected an OggStreamError.";
+        }
+        catch (const OggStreamError& e) {
+            EXPECT_EQ(e.getCause(), OggStreamError::Cause::IOError);
+        }
+    }
+    std::fclose(file);
+    std::filesystem::remove(path);
+}
+
+RC_GTEST_PROP(TestOggStream, fragmented_packets_are_written_like_contiguous_packets,
+    (const std::vector<uint32_t> fragmentSizes, const bool usePacking)) {
+    RC_PRE(fragmentSizes.size() <= 20);
+
+    // Fragments of up to 40000 bytes, so that packets cross page boundaries.
+    std::vector<std::vector<uint8_t>> fragmentData;
+    std::vector<OggFragment> fragments;
+    std::vector<uint8_t> packet;
+    for (std::size_t i{ 0 }; i < fragmentSizes.size(); i++) {
+        fragmentData.push_back(makePacket(i, fragmentSizes[i] % 3 == 0 ? 0 : fragmentSizes[i] % 40000));
+        packet.insert(packet.end(), fragmentData.back().begin(), fragmentData.back().end());
+    }
+    for (const std::vector<uint8_t>& data : fragmentData) {
+        fragments.push_back(OggFragment{ data.data(), data.size() });
+    }
+
+    std::basic_stringstream<uint8_t> fragmentedStream{};
+    std::basic_stringstream<uint8_t> contiguousStream{};
+    {
+        OggPhysicalStreamOut fragmentedPhysical{ fragmentedStream };
+        OggPhysicalStreamOut contiguousPhysical{ contiguousStream };
+        OggLogicalStreamOut fragmentedLogical{ fragmentedPhysical.newLogicalStream() };
+        OggLogicalStreamOut contiguousLogical{ contiguousPhysical.newLogicalStream() };
+        if (usePacking) {
+            fragmentedLogical.enablePacking();
+            contiguousLogical.enablePacking();
+        }
+        for (std::size_t i{ 0 }; i < 3; i++) {
+            fragmentedLogical.write(fragments.data(), fragments.size(), int64_t(i), true, i == 2);
+            contiguousLogical.write(packet.data(), unsigned(packet.size()), int64_t(i), true, i == 2);
+        }
+    }
+
+    RC_ASSERT(fragmentedStream.str() == contiguousStream.str());
+}
+
+/**
+* Writes packets of the given sizes alternately to two logical streams, after some junk.
+*/
+static std::basic_string<uint8_t> writeFeedTestStream(const std::vector<std::size_t>& sizes) {
+    std::basic_stringstream<uint8_t> stream{};
+    const std::vector<uint8_t> junk{ makePacket(1000, 100) };
+    stream.write(junk.data(), junk.size());
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut first{ outPhysical.newLogicalStream() };
+        OggLogicalStreamOut second{ outPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < sizes.size(); i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, sizes[i]) };
+            (i % 2 == 0 ? first : second).write(packet.data(), unsigned(packet.size()), int64_t(i), true, i + 2 >= sizes.size());
+        }
+    }
+    return stream.str();
+}
+
+RC_GTEST_PROP(TestOggStream, fed_chunks_are_processed_like_a_whole_stream,
+    (const std::vector<uint32_t> packetSizes, const std::vector<uint32_t> chunkSizes)) {
+    RC_PRE(packetSizes.size() > 0);
+    RC_PRE(packetSizes.size() <= 10);
+    RC_PRE(chunkSizes.size() > 0);
+
+    std::vector<std::size_t> sizes;
+    for (const uint32_t size : packetSizes) {
+        sizes.push_back(size % 100000);
+    }
+    const std::basic_string<uint8_t> data{ writeFeedTestStream(sizes) };
+
+    std::basic_stringstream<uint8_t> stream{ data };
+    OggPhysicalStreamIn processed{ stream };
+    const auto processedCallback{ std::make_shared<TestPacketNewStreamCallback>() };
+    processed.addNewStreamCallback(processedCallback);
+    processed.process();
+
+    OggPhysicalStreamIn fed{};
+    const auto fedCallback{ std::make_shared<TestPacketNewStreamCallback>() };
+    fed.addNewStreamCallback(fedCallback);
+    std::size_t offset{ 0 };
+    for (std::size_t i{ 0 }; offset < data.size(); i++) {
+        const std::size_t chunkSize{ std::min<std::size_t>(chunkSizes[i % chunkSizes.size()] % 20000 + 1, data.size() - offset) };
+        fed.feed(data.data() + offset, chunkSize);
+        offset += chunkSize;
+    }
+
+    RC_ASSERT(fed.getNumSkippedBytes() == processed.getNumSkippedBytes());
+    RC_ASSERT(fedCallback->callbacks.size() == processedCallback->callbacks.size());
+    for (std::size_t s{ 0 }; s < fedCallback->callbacks.size(); s++) {
+        RC_ASSERT(fedCallback->callbacks[s]->packets == processedCallback->callbacks[s]->packets);
+    }
+}
+
+TEST(TestOggStream, feeding_continues_after_damaged_pages) {
+    const std::vector<std::size_t> sizes(10, 1000);
+    std::basic_string<uint8_t> data{ writeFeedTestStream(sizes) };
+
+    // Damage the payload of the third page. Each page has a 31 byte header and 1000 bytes of payload.
+    data[100 + 2 * 1031 + 500]++;
+
+    OggPhysicalStreamIn fed{};
+    const auto callback{ std::make_shared<TestPacketNewStreamCallback>() };
+    fed.addNewStreamCallback(callback);
+    try {
+        fed.feed(data.data(), data.size());
+        FAIL() << "Expected an OggStreamError.";
+    }
+    catch (const OggStreamError& e) {
+        EXPECT_EQ(e.getCause(), OggStreamError::Cause::BadChecksum);
+    }
+
+    ASSERT_EQ(callback->callbacks.size(), 2u);
+    EXPECT_EQ(callback->callbacks[0]->packets.size() + callback->callbacks[1]->packets.size(), 9u);
+}
+
+#ifndef _WIN32
+TEST(TestOggStream, data_from_a_pipe_can_be_fed) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    std::vector<std::size_t> sizes;
+    for (std::size_t i{ 0 }; i < 50; i++) {
+        sizes.push_back(i * 997 % 5000);
+    }
+    std::thread writer{ [&]() {
+        {
+            OggPhysicalStreamOut outPhysical{ fds[1] };
+            OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+            for (std::size_t i{ 0 }; i < sizes.size(); i++) {
+                const std::vector<uint8_t> packet{ makePacket(i, sizes[i]) };
+                outLogical.write(packet.data(), unsigned(packet.size()), int64_t(i), true, i + 1 == sizes.size());
+            }
+        }
+        close(fds[1]);
+    } };
+
+    OggPhysicalStreamIn fed{};
+    const auto callback{ std::make_shared<TestPacketNewStreamCallback>() };
+    fed.addNewStreamCallback(callback);
+    uint8_t buffer[1000];
+    ssize_t numRead{ read(fds[0], buffer, sizeof(buffer)) };
+    while (numRead > 0) {
+        fed.feed(buffer, std::size_t(numRead));
+        numRead = read(fds[0], buffer, sizeof(buffer));
+    }
+    writer.join();
+    close(fds[0]);
+
+    ASSERT_EQ(callback->callbacks.size(), 1u);
+    const TestPacketCallback& packetCallback{ *callback->callbacks[0] };
+    ASSERT_EQ(packetCallback.packets.size(), sizes.size());
+    for (std::size_t i{ 0 }; i < sizes.size(); i++) {
+        EXPECT_EQ(packetCallback.packets[i], makePacket(i, sizes[i]));
+    }
+    EXPECT_TRUE(packetCallback.metas.back().isLastPacket);
+}
+#endif
+
+/**
+* Seeks to granulePosition and returns the granule position of the first packet of the stream 
+* that is returned afterwards, or -1 if there is none.
+*/
+static int64_t seekAndReadGranule(OggPhysicalStreamIn& in, const uint32_t serial, const int64_t granulePosition) {
+    if (!in.seekToGranule(serial, granulePosition)) {
+        return -1;
+    }
+    return readGranule(in, serial);
+}
+
+RC_GTEST_PROP(TestOggStream, seeking_finds_the_page_containing_a_granule_position,
+    (const uint32_t seed, const std::vector<uint32_t> targets)) {
+    const std::size_t numPackets{ 300 };
+    std::basic_stringstream<uint8_t> stream{};
+    writeSeekTestStream(stream, numPackets, seed);
+
+    OggPhysicalStreamIn inPhysical{ stream };
+    const std::optional<OggPacket> first{ inPhysical.nextPacket() };
+    RC_ASSERT(first.has_value());
+    const uint32_t serial{ first->streamSerialNumber };
+
+    for (const uint32_t targetRaw : targets) {
+        const int64_t target{ int64_t(targetRaw % (numPackets + 10)) };
+        const int64_t expected{ target % 2 == 0 ? target : target + 1 };
+        RC_ASSERT(seekAndReadGranule(inPhysical, serial, target) == (expected < int64_t(numPackets) ? expected : -1));
+    }
+    RC_ASSERT(inPhysical.getNumSkippedBytes() == 0u);
+}
+
+TEST(TestOggStream, seeking_ignores_page_headers_within_packets) {
+    // Every packet is full of headers of empty pages with granule position 0 and a 
+    // wrong checksum. Trusting them would move the search past the target.
+    const uint32_t serial{ 1234 };
+    std::vector<uint8_t> fakeHeader{ 'O', 'g', 'g', 'S', 0, 0 };
+    fakeHeader.resize(27, 0);
+    for (std::size_t i{ 0 }; i < 4; i++) {
+        fakeHeader[14 + i] = uint8_t(serial >> (8 * i));
+    }
+
+    std::basic_stringstream<uint8_t> stream{};
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut outLogical{ *outPhysical.newLogicalStream(serial) };
+        for (std::size_t i{ 0 }; i < 300; i++) {
+            std::vector<uint8_t> packet{ makePacket(i, 3000) };
+            for (std::size_t offset{ 100 }; offset + fakeHeader.size() < packet.size(); offset += 300) {
+                std::copy(fakeHeader.begin(), fakeHeader.end(), packet.begin() + offset);
+            }
+            outLogical.write(packet.data(), unsigned(packet.size()), int64_t(i), true, i == 299);
+        }
+    }
+
+    OggPhysicalStreamIn inPhysical{ stream };
+    EXPECT_EQ(seekAndReadGranule(inPhysical, serial, 100), 100);
+    EXPECT_EQ(seekAndReadGranule(inPhysical, serial, 5), 5);
+    EXPECT_EQ(seekAndReadGranule(inPhysical, serial, 297), 297);
+}
+
+TEST(TestOggStream, seeking_works_on_files_and_mapped_files) {
+    const std::string path{ (std::filesystem::temp_directory_path() / "vcpp_test_seek.ogg").string() };
+    writeSeekTestFile(path, 300, 1);
+
+    OggPhysicalStreamIn mappedPhysical{ path };
+    const uint32_t serial{ mappedPhysical.nextPacket()->streamSerialNumber };
+    EXPECT_EQ(seekAndReadGranule(mappedPhysical, serial, 201), 202);
+    EXPECT_EQ(seekAndReadGranule(mappedPhysical, serial, 10), 10);
+    EXPECT_EQ(seekAndReadGranule(mappedPhysical, serial, 1000), -1);
+
+    FILE* const file{ std::fopen(path.c_str(), "rb") };
+    ASSERT_NE(file, nullptr);
+    {
+        OggPhysicalStreamIn filePhysical{ file };
+        EXPECT_EQ(seekAndReadGranule(filePhysical, serial, 201), 202);
+        EXPECT_EQ(seekAndReadGranule(filePhysical, serial, 10), 10);
+        EXPECT_EQ(seekAndReadGranule(filePhysical, serial, 1000), -1);
+    }
+    std::fclose(file);
+    std::filesystem::remove(path);
+}
+
+TEST(TestOggStream, streams_first_seen_after_a_seek_skip_no_pages) {
+    std::basic_stringstream<uint8_t> stream{};
+    writeSeekTestStream(stream, 300, 1);
+    const std::basic_string<uint8_t> content{ stream.str() };
+
+    std::basic_stringstream<uint8_t> firstStream{ content };
+    OggPhysicalStreamIn firstPhysical{ firstStream };
+    const uint32_t serial{ firstPhysical.nextPacket()->streamSerialNumber };
+
+    // No logical stream is known before the seek, so the page sequence of both is unknown.
+    std::basic_stringstream<uint8_t> seekStream{ content };
+    OggPhysicalStreamIn seekPhysical{ seekStream };
+    ASSERT_TRUE(seekPhysical.seekToGranule(serial, 201));
+    for (std::size_t i{ 0 }; i < 4; i++) {
+        const std::optional<OggPacket> packet{ seekPhysical.nextPacket() };
+        ASSERT_TRUE(packet.has_value());
+        EXPECT_EQ(packet->meta.numSkippedPages, 0u);
+    }
+}
+
+RC_GTEST_PROP(TestOggStream, pipelined_processing_matches_sequential_processing,
+    (const std::vector<uint32_t> packetSizes, const unsigned int numWorkersRaw, const std::size_t queueDepthRaw)) {
+    RC_PRE(packetSizes.size() > 0);
+    RC_PRE(packetSizes.size() <= 30);
+
+    std::basic_stringstream<uint8_t> stream{};
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut logicalStreams[]{ outPhysical.newLogicalStream(), outPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < packetSizes.size(); i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, packetSizes[i] % 100000) };
+            logicalStreams[i % 2].write(
+                packet.data(), unsigned(packet.size()), int64_t(i), true, i + 2 >= packetSizes.size());
+        }
+    }
+    const std::basic_string<uint8_t> content{ stream.str() };
+
+    std::basic_stringstream<uint8_t> sequentialStream{ content };
+    OggPhysicalStreamIn sequentialPhysical{ sequentialStream };
+    const auto sequential{ std::make_shared<TestPacketNewStreamCallback>() };
+    sequentialPhysical.addNewStreamCallback(sequential);
+    sequentialPhysical.process();
+
+    std::basic_stringstream<uint8_t> pipelinedStream{ content };
+    OggPhysicalStreamIn pipelinedPhysical{ pipelinedStream };
+    const auto pipelined{ std::make_shared<TestPacketNewStreamCallback>() };
+    pipelinedPhysical.addNewStreamCallback(pipelined);
+    pipelinedPhysical.processPipelined(numWorkersRaw % 4, queueDepthRaw % 8 + 1);
+
+    RC_ASSERT(pipelined->callbacks.size() == sequential->callbacks.size());
+    for (std::size_t s{ 0 }; s < sequential->callbacks.size(); s++) {
+        RC_ASSERT(pipelined->callbacks[s]->packets == sequential->callbacks[s]->packets);
+    }
+}
+
+/**
+* Records the page offset and the number of skipped bytes that the physical stream reports 
+* to each DataCallback call.
+*/
+class PositionNewStreamCallback : public OggPhysicalStreamIn::NewStreamCallback {
+    class PositionDataCallback : public OggLogicalStreamIn::DataCallback {
+        PositionNewStreamCallback& parent_;
+
+    public:
+        explicit PositionDataCallback(PositionNewStreamCallback& parent) : parent_{ parent } {}
+
+        void onDataAvailable(const uint8_t* const data, const std::size_t size, const OggLogicalStreamIn::MetaData meta) {
+            (void)data;
+            (void)size;
+            (void)meta;
+            parent_.positions.emplace_back(parent_.physical_.getPageOffset(), parent_.physical_.getNumSkippedBytes());
+        }
+    };
+
+    const OggPhysicalStreamIn& physical_;
+
+public:
+    std::vector<std::pair<uint64_t, uint64_t>> positions;
+
+    explicit PositionNewStreamCallback(const OggPhysicalStreamIn& physical) : physical_{ physical } {}
+
+    void onNewStream(OggLogicalStreamIn& stream) {
+        stream.addDataCallback(std::make_shared<PositionDataCallback>(*this));
+    }
+};
+
+TEST(TestOggStream, pipelined_callbacks_see_the_position_of_their_page) {
+    const std::vector<uint8_t> junk{ makePacket(1000, 100) };
+    std::basic_stringstream<uint8_t> stream{};
+    stream.write(junk.data(), junk.size());
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < 40; i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, 500) };
+            outLogical.write(packet.data(), unsigned(packet.size()), int64_t(i), true, i == 39);
+        }
+    }
+    stream.write(junk.data(), junk.size());
+    const std::basic_string<uint8_t> content{ stream.str() };
+
+    std::basic_stringstream<uint8_t> sequentialStream{ content };
+    OggPhysicalStreamIn sequentialPhysical{ sequentialStream };
+    const auto sequential{ std::make_shared<PositionNewStreamCallback>(sequentialPhysical) };
+    sequentialPhysical.addNewStreamCallback(sequential);
+    sequentialPhysical.process();
+
+    std::basic_stringstream<uint8_t> pipelinedStream{ content };
+    OggPhysicalStreamIn pipelinedPhysical{ pipelinedStream };
+    const auto pipelined{ std::make_shared<PositionNewStreamCallback>(pipelinedPhysical) };
+    pipelinedPhysical.addNewStreamCallback(pipelined);
+    pipelinedPhysical.processPipelined(2, 8);
+
+    EXPECT_EQ(sequential->positions.size(), 40u);
+    EXPECT_EQ(pipelined->positions, sequential->positions);
+    EXPECT_EQ(pipelinedPhysical.getNumSkippedBytes(), 2 * junk.size());
+    EXPECT_EQ(pipelinedPhysical.getNumSkippedBytes(), sequentialPhysical.getNumSkippedBytes());
+}
+
+TEST(TestOggStream, pipelined_processing_reports_bad_checksums_in_order) {
+    std::basic_stringstream<uint8_t> stream{};
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < 20; i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, 1000) };
+            outLogical.write(packet.data(), unsigned(packet.size()), int64_t(i), true, i == 19);
+        }
+    }
+    std::basic_string<uint8_t> content{ stream.str() };
+    content[content.size() / 2 + 100] ^= 0x01;
+
+    std::basic_stringstream<uint8_t> corruptStream{ content };
+    OggPhysicalStreamIn inPhysical{ corruptStream };
+    const auto callback{ std::make_shared<TestPacketNewStreamCallback>() };
+    inPhysical.addNewStreamCallback(callback);
+    try {
+        inPhysical.processPipelined(3, 4);
+        FAIL() << "Expected an OggStreamError.";
+    }
+    catch (const OggStreamError& e) {
+        EXPECT_EQ(e.getCause(), OggStreamError::Cause::BadChecksum);
+    }
+
+    // Every page before the damaged one is delivered.
+    ASSERT_EQ(callback->callbacks.size(), 1u);
+    EXPECT_EQ(callback->callbacks[0]->packets.size(), 10u);
+}
+
+RC_GTEST_PROP(TestOggStream, concurrent_processing_matches_sequential_processing,
+    (const std::vector<uint32_t> packetSizes, const std::size_t numLogicalStreamsRaw, const std::size_t queueCapacityRaw)) {
+    RC_PRE(packetSizes.size() > 0);
+    RC_PRE(packetSizes.size() <= 30);
+
+    std::basic_stringstream<uint8_t> stream{};
+    const std::size_t numLogicalStreams{ numLogicalStreamsRaw % 4 + 1 };
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        std::vector<OggLogicalStreamOut> logicalStreams;
+        for (std::size_t i{ 0 }; i < numLogicalStreams; i++) {
+            logicalStreams.emplace_back(outPhysical.newLogicalStream());
+        }
+        for (std::size_t i{ 0 }; i < packetSizes.size(); i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, packetSizes[i] % 100000) };
+            logicalStreams[i % numLogicalStreams].write(
+                packet.data(), unsigned(packet.size()), int64_t(i), true, i + numLogicalStreams >= packetSizes.size());
+        }
+    }
+    const std::basic_string<uint8_t> content{ stream.str() };
+
+    std::basic_stringstream<uint8_t> sequentialStream{ content };
+    OggPhysicalStreamIn sequentialPhysical{ sequentialStream };
+    const auto sequential{ std::make_shared<TestPacketNewStreamCallback>() };
+    sequentialPhysical.addNewStreamCallback(sequential);
+    sequentialPhysical.process();
+
+    std::basic_stringstream<uint8_t> concurrentStream{ content };
+    OggPhysicalStreamIn concurrentPhysical{ concurrentStream };
+    const auto concurrent{ std::make_shared<TestPacketNewStreamCallback>() };
+    concurrentPhysical.addNewStreamCallback(concurrent);
+    concurrentPhysical.processConcurrently(queueCapacityRaw % 4 + 1);
+
+    RC_ASSERT(concurrent->callbacks.size() == sequential->callbacks.size());
+    for (std::size_t s{ 0 }; s < sequential->callbacks.size(); s++) {
+        RC_ASSERT(concurrent->callbacks[s]->packets == sequential->callbacks[s]->packets);
+        RC_ASSERT(concurrent->callbacks[s]->metas.size() == sequential->callbacks[s]->metas.size());
+    }
+}
+
+TEST(TestOggStream, concurrent_processing_reports_late_pages) {
+    std::basic_stringstream<uint8_t> stream{};
+    {
+        OggPhysicalStreamOut outPhysical{ stream };
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < 10; i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, 1000) };
+            outLogical.write(packet.data(), unsigned(packet.size()), int64_t(i), true, i == 9);
+        }
+    }
+
+    // Repeat the fifth page, so that its sequence number appears twice.
+    const std::basic_string<uint8_t> content{ stream.str() };
+    const std::size_t pageSize{ content.size() / 10 };
+    std::basic_stringstream<uint8_t> lateStream{ 
+        content.substr(0, 5 * pageSize) + content.substr(4 * pageSize) };
+
+    OggPhysicalStreamIn inPhysical{ lateStream };
+    const auto callback{ std::make_shared<TestPacketNewStreamCallback>() };
+    inPhysical.addNewStreamCallback(callback);
+    try {
+        inPhysical.processConcurrently(2);
+        FAIL() << "Expected an OggStreamError.";
+    }
+    catch (const OggStreamError& e) {
+        EXPECT_EQ(e.getCause(), OggStreamError::Cause::LatePage);
+    }
+    ASSERT_EQ(callback->callbacks.size(), 1u);
+    EXPECT_EQ(callback->callbacks[0]->packets.size(), 5u);
+}
+
+RC_GTEST_PROP(TestOggStream, uring_input_reads_the_same_data_as_mapped_input,
+    (const std::vector<uint32_t> packetSizes, const bool useRing)) {
+    RC_PRE(packetSizes.size() > 0);
+    RC_PRE(packetSizes.size() <= 10);
+
+    const std::string path{ (std::filesystem::temp_directory_path() / "vcpp_test_uring_input.ogg").string() };
+    FILE* const outFile{ std::fopen(path.c_str(), "wb") };
+    RC_ASSERT(outFile != nullptr);
+    {
+        OggPhysicalStreamOut outPhysical{ outFile };
+        OggLogicalStreamOut outLogical{ outPhysical.newLogicalStream() };
+        for (std::size_t i{ 0 }; i < packetSizes.size(); i++) {
+            const std::vector<uint8_t> packet{ makePacket(i, packetSizes[i] % 100000) };
+            outLogical.write(packet.data(), unsigned(packet.size()), 0, true, i + 1 == packetSizes.size());
+        }
+    }
+    std::fclose(outFile);
+
+    const auto mappedCallback{ std::make_shared<TestNewStreamCallback<CollectingDataCallback>>() };
+    {
+        OggPhysicalStreamIn inPhysical{ path };
+        inPhysical.addNewStreamCallback(mappedCallback);
+        inPhysical.process();
+    }
+
+    // Without a ring, the input falls back to blocking reads.
+    const auto uringCallback{ std::make_shared<TestNewStreamCallback<CollectingDataCallback>>() };
+    {
+        OggPhysicalStreamIn inPhysical{ path, useRing ? std::make_shared<IoUring>(8) : nullptr };
+        inPhysical.addNewStreamCallback(uringCallback);
+        inPhysical.process();
+    }
+    std::filesystem::remove(path);
+
+    RC_ASSERT(uringCallback->dataCallbacks.size() == 1);
+    RC_ASSERT(uringCallback->dataCallbacks[0]->bytes == mappedCallback->dataCallbacks[0]->bytes);
+}
+
+TEST(TestOggStream, uring_inputs_can_share_a_ring_and_seek) {
+    const std::string path{ (std::filesystem::temp_directory_path() / "vcpp_test_uring_seek.ogg").string() };
+    {
+        std::basic_stringstream<uint8_t> stream{};
+        writeSeekTestStream(stream, 300, 2);
+        const std::basic_string<uint8_t> content{ stream.str() };
+        FILE* const file{ std::fopen(path.c_str(), "wb") };
+        ASSERT_NE(file, nullptr);
+        std::fwrite(content.data(), 1, content.size(), file);
+        std::fclose(file);
+    }
+
+    const std::shared_ptr<IoUring> ring{ std::make_shared<IoUring>(4) };
+    std::vector<std::thread> threads;
+    std::vector<int64_t> results(4);
+    for (std::size_t t{ 0 }; t < results.size(); t++) {
+        threads.emplace_back([&, t]() {
+            OggPhysicalStreamIn inPhysical{ path, ring };
+            const uint32_t serial{ inPhysical.nextPacket()->streamSerialNumber };
+            results[t] = seekAndReadGranule(inPhysical, serial, int64_t(51 * t + 1));
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::filesystem::remove(path);
+
+    // The first stream only has even granule positions.
+    for (std::size_t t{ 0 }; t < results.size(); t++) {
+        const int64_t target{ int64_t(51 * t + 1) };
+        EXPECT_EQ(results[t], target + target % 2);
+    }
+}
@@ -0,0 +1,57 @@
+#include "SpscQueue.h"
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+
+using namespace vcpp;
+
+RC_GTEST_PROP(TestSpscQueue, elements_are_popped_in_order,
+    (const std::vector<uint32_t> values, const std::size_t capacityRaw)) {
+    SpscQueue<uint32_t> queue{ capacityRaw % 8 + 1 };
+
+    std::thread producer{ [&]() {
+        for (const uint32_t value : values) {
+            queue.push(uint32_t(value));
+        }
+        queue.close();
+    } };
+
+    std::vector<uint32_t> popped;
+    while (const std::optional<uint32_t> value{ queue.pop() }) {
+        popped.push_back(*value);
+    }
+    producer.join();
+
+    RC_ASSERT(popped == values);
+}
+
+TEST(TestSpscQueue, try_push_fails_on_a_full_queue) {
+    SpscQueue<std::unique_ptr<int>> queue{ 2 };
+    EXPECT_TRUE(queue.tryPush(std::make_unique<int>(1)));
+    EXPECT_TRUE(queue.tryPush(std::make_unique<int>(2)));
+
+    std::unique_ptr<int> third{ std::make_unique<int>(3) };
+    EXPECT_FALSE(queue.tryPush(std::move(third)));
+    ASSERT_NE(third, nullptr);
+
+    EXPECT_EQ(**queue.tryPop(), 1);
+    EXPECT_TRUE(queue.tryPush(std::move(third)));
+    EXPECT_EQ(**queue.tryPop(), 2);
+    EXPECT_EQ(**queue.tryPop(), 3);
+    EXPECT_FALSE(queue.tryPop().has_value());
+}
+
+TEST(TestSpscQueue, closing_wakes_up_a_waiting_producer) {
+    SpscQueue<int> queue{ 1 };
+    queue.push(1);
+
+    std::thread consumer{ [&]() { queue.close(); } };
+    EXPECT_FALSE(queue.push(2));
+    consumer.join();
+
+    EXPECT_EQ(*queue.pop(), 1);
+    EXPECT_FALSE(queue.pop().has_value());
+}
@@ -0,0 +1,283 @@
+#include "VorbisDecoder.h"
+#include "VorbisStream.h"
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+
+using namespace vcpp;
+
+static const std::string testDataDir{ VCPP_TEST_DATA_DIR };
+
+class VorbisNewStreamCallback : public OggPhysicalStreamIn::NewStreamCallback {
+public:
+    std::vector<std::shared_ptr<VorbisStream>> streams;
+
+    void onNewStream(OggLogicalStreamIn& stream) {
+        streams.emplace_back(std::make_shared<VorbisStream>());
+        stream.addPacketCallback(streams.back());
+    }
+};
+
+// Returns the packets of the first logical stream in the file, or only the first maxPackets.
+static std::vector<std::vector<uint8_t>> readPackets(const std::string& path, const std::size_t maxPackets = SIZE_MAX) {
+    OggPhysicalStreamIn in{ path };
+    std::vector<std::vector<uint8_t>> packets;
+    while (packets.size() < maxPackets) {
+        const std::optional<OggPacket> packet{ in.nextPacket() };
+        if (!packet) {
+            break;
+        }
+        packets.emplace_back(packet->data, packet->data + packet->size);
+    }
+    return packets;
+}
+
+static std::vector<std::vector<uint8_t>> readHeaderPackets(const std::string& path) {
+    return readPackets(path, 3);
+}
+
+static VorbisSetup readSetup(const std::string& path) {
+    const std::vector<std::vector<uint8_t>> packets{ readHeaderPackets(path) };
+    const VorbisIdentification identification{ VorbisIdentification::parse(packets[0].data(), packets[0].size()) };
+    return VorbisSetup::parse(packets[2].data(), packets[2].size(), identification);
+}
+
+TEST(TestVorbis, headers_are_parsed) {
+    const auto callback{ std::make_shared<VorbisNewStreamCallback>() };
+    OggPhysicalStreamIn in{ testDataDir + "/stereo.ogg" };
+    in.addNewStreamCallback(callback);
+    in.process();
+
+    ASSERT_EQ(callback->streams.size(), 1u);
+    const VorbisStream& stream{ *callback->streams[0] };
+    ASSERT_TRUE(stream.hasHeaders());
+
+    const VorbisIdentification& identification{ stream.getIdentification() };
+    EXPECT_EQ(identification.numChannels, 2u);
+    EXPECT_EQ(identification.sampleRate, 44100u);
+    EXPECT_EQ(identification.blockSizes[0], 256u);
+    EXPECT_EQ(identification.blockSizes[1], 2048u);
+
+    const VorbisComment& comment{ stream.getComment() };
+    EXPECT_EQ(comment.vendor, "Xiph.Org libVorbis I 20200704 (Reducing Environment)");
+    ASSERT_EQ(comment.userComments.size(), 1u);
+    EXPECT_EQ(comment.userComments[0], "ENCODER=libsndfile");
+
+    const VorbisSetup& setup{ stream.getSetup() };
+    EXPECT_EQ(setup.codebooks.size(), 42u);
+    EXPECT_EQ(setup.modes.size(), 2u);
+    for (const VorbisMode& mode : setup.modes) {
+        EXPECT_LT(mode.mapping, setup.mappings.size());
+    }
+    for (const VorbisMapping& mapping : setup.mappings) {
+        EXPECT_EQ(mapping.channelMux.size(), 2u);
+    }
+}
+
+TEST(TestVorbis, streams_share_imdct_plans) {
+    const std::vector<std::vector<uint8_t>> packets{ readHeaderPackets(testDataDir + "/stereo.ogg") };
+    VorbisStream a{};
+    VorbisStream b{};
+    for (const std::vector<uint8_t>& packet : packets) {
+        a.processPacket(packet.data(), packet.size());
+        b.processPacket(packet.data(), packet.size());
+    }
+    ASSERT_TRUE(a.hasHeaders());
+    ASSERT_TRUE(b.hasHeaders());
+
+    const VorbisDecoder::PacketHeader shortBlock{ 0, false, false, false };
+    const VorbisDecoder::PacketHeader longBlock{ 1, true, false, false };
+    EXPECT_EQ(&a.getDecoder().getImdct(shortBlock), &b.getDecoder().getImdct(shortBlock));
+    EXPECT_EQ(&a.getDecoder().getImdct(longBlock), &b.getDecoder().getImdct(longBlock));
+    EXPECT_EQ(a.getDecoder().getImdct(shortBlock).getSize(), 256u);
+    EXPECT_EQ(a.getDecoder().getImdct(longBlock).getSize(), 2048u);
+}
+
+TEST(TestVorbis, codewords_are_prefix_free) {
+    const std::vector<std::vector<uint8_t>> packets{ readHeaderPackets(testDataDir + "/mono.ogg") };
+    ASSERT_EQ(packets.size(), 3u);
+    const VorbisIdentification identification{ VorbisIdentification::parse(packets[0].data(), packets[0].size()) };
+    const VorbisSetup setup{ VorbisSetup::parse(packets[2].data(), packets[2].size(), identification) };
+
+    for (const VorbisCodebook& codebook : setup.codebooks) {
+        for (uint32_t a{ 0 }; a < codebook.numEntries; a++) {
+            for (uint32_t b{ 0 }; b < codebook.numEntries; b++) {
+                if (a == b || codebook.lengths[a] == 0 || codebook.lengths[b] == 0 || codebook.lengths[a] > codebook.lengths[b]) {
+                    continue;
+                }
+                const uint32_t mask{ codebook.lengths[a] == 32 ? ~uint32_t(0) : (uint32_t(1) << codebook.lengths[a]) - 1 };
+                EXPECT_NE(codebook.codewords[a], codebook.codewords[b] & mask);
+            }
+        }
+    }
+}
+
+TEST(TestVorbis, damaged_headers_are_rejected) {
+    const std::vector<std::vector<uint8_t>> packets{ readHeaderPackets(testDataDir + "/stereo.ogg") };
+    ASSERT_EQ(packets.size(), 3u);
+
+    // Truncated setup header.
+    VorbisStream truncated{};
+    truncated.processPacket(packets[0].data(), packets[0].size());
+    truncated.processPacket(packets[1].data(), packets[1].size());
+    EXPECT_THROW(truncated.processPacket(packets[2].data(), packets[2].size() / 2), VorbisError);
+
+    // Headers in the wrong order.
+    VorbisStream reordered{};
+    EXPECT_THROW(reordered.processPacket(packets[1].data(), packets[1].size()), VorbisError);
+
+    // Invalid block sizes.
+    std::vector<uint8_t> identification{ packets[0] };
+    identification[28] = 0x8b;
+    VorbisStream badBlockSizes{};
+    EXPECT_THROW(badBlockSizes.processPacket(identification.data(), identification.size()), VorbisError);
+
+    // A first codebook with no dimensions and no entries. The codebooks start after the
+    // common header, the codebook count and the sync pattern of the first codebook.
+    std::vector<uint8_t> setup{ packets[2] };
+    std::fill(setup.begin() + 11, setup.begin() + 16, uint8_t(0));
+    VorbisStream emptyCodebook{};
+    emptyCodebook.processPacket(packets[0].data(), packets[0].size());
+    emptyCodebook.processPacket(packets[1].data(), packets[1].size());
+    EXPECT_THROW(emptyCodebook.processPacket(setup.data(), setup.size()), VorbisError);
+}
+
+RC_GTEST_PROP(TestVorbis, codebook_entries_are_decoded,
+    (const std::vector<uint32_t> entriesRaw, const std::vector<uint8_t> padding)) {
+    static const VorbisSetup setup{ readSetup(testDataDir + "/stereo.ogg") };
+
+    for (const VorbisCodebook& codebook : setup.codebooks) {
+        std::vector<uint32_t> usedEntries;
+        for (uint32_t entry{ 0 }; entry < codebook.numEntries; entry++) {
+            if (codebook.lengths[entry] != 0) {
+                usedEntries.push_back(entry);
+            }
+        }
+        if (usedEntries.size() < 2) {
+            continue;
+        }
+
+        // Pack the codewords of random entries, followed by random bits.
+        std::vector<uint8_t> data;
+        std::vector<uint32_t> expected;
+        std::size_t numBits{ 0 };
+        auto writeBits = [&](const uint32_t value, const unsigned int count) {
+            for (unsigned int bit{ 0 }; bit < count; bit++, numBits++) {
+                if (numBits % 8 == 0) {
+                    data.push_back(0);
+                }
+                data.back() |= uint8_t(((value >> bit) & 1) << (numBits % 8));
+            }
+        };
+        for (const uint32_t entryRaw : entriesRaw) {
+            const uint32_t entry{ usedEntries[entryRaw % usedEntries.size()] };
+            writeBits(codebook.codewords[entry], codebook.lengths[entry]);
+            expected.push_back(entry);
+        }
+        for (const uint8_t value : padding) {
+            writeBits(value, 8);
+        }
+
+        BitReader reader{ data.data(), data.size() };
+        for (const uint32_t entry : expected) {
+            RC_ASSERT(codebook.decodeEntry(reader) == int32_t(entry));
+        }
+    }
+}
+
+TEST(TestVorbis, decoding_stops_at_the_end_of_the_packet) {
+    const VorbisSetup setup{ readSetup(testDataDir + "/stereo.ogg") };
+    for (const VorbisCodebook& codebook : setup.codebooks) {
+        BitReader reader{ nullptr, 0 };
+        EXPECT_EQ(codebook.decodeEntry(reader), -1);
+    }
+}
+
+TEST(TestVorbis, vectors_are_expanded) {
+    const VorbisSetup setup{ readSetup(testDataDir + "/stereo.ogg") };
+    std::size_t numVectorCodebooks{ 0 };
+    for (const VorbisCodebook& codebook : setup.codebooks) {
+        if (codebook.lookupType == 0) {
+            EXPECT_TRUE(codebook.vectors.empty());
+            continue;
+        }
+        numVectorCodebooks++;
+        ASSERT_EQ(codebook.vectors.size(), std::size_t(codebook.numEntries) * codebook.dimensions);
+
+        // Straight from the Vorbis specification.
+        for (uint32_t entry{ 0 }; entry < codebook.numEntries; entry++) {
+            float last{ 0.0f };
+            uint32_t indexDivisor{ 1 };
+            for (uint32_t i{ 0 }; i < codebook.dimensions; i++) {
+                const uint32_t offset{ codebook.lookupType == 1
+                    ? (entry / indexDivisor) % codebook.numLookupValues
+                    : entry * codebook.dimensions + i };
+                const float value{ codebook.multiplicands[offset] * codebook.deltaValue + codebook.minimumValue + last };
+                EXPECT_EQ(codebook.vectors[std::size_t(entry) * codebook.dimensions + i], value);
+                if (codebook.isSequence) {
+                    last = value;
+                }
+                indexDivisor *= codebook.numLookupValues;
+            }
+        }
+    }
+    EXPECT_GT(numVectorCodebooks, 0u);
+}
+
+// Decodes the spectra of all audio packets of a file.
+static std::vector<float> decodeSpectra(
+    const std::vector<std::vector<uint8_t>>& packets,
+    const VorbisDspKernels& kernels,
+    const std::size_t maxPacketSize = SIZE_MAX
+) {
+    const VorbisIdentification identification{ VorbisIdentification::parse(packets[0].data(), packets[0].size()) };
+    const VorbisSetup setup{ VorbisSetup::parse(packets[2].data(), packets[2].size(), identification) };
+    const VorbisDecoder decoder{ identification, setup, kernels };
+    VorbisDecoder::Workspace workspace{};
+
+    const std::size_t stride{ identification.blockSizes[1] / 2u };
+    std::vector<float> spectra;
+    for (std::size_t i{ 3 }; i < packets.size(); i++) {
+        BitReader reader{ packets[i].data(), std::min(packets[i].size(), maxPacketSize) };
+        VorbisDecoder::PacketHeader header;
+        if (!decoder.readPacketHeader(reader, header)) {
+            continue;
+        }
+        const std::size_t offset{ spectra.size() };
+        spectra.resize(offset + identification.numChannels * stride);
+        decoder.decodeSpectrum(reader, header, spectra.data() + offset, stride, workspace);
+    }
+    return spectra;
+}
+
+TEST(TestVorbis, spectra_do_not_depend_on_kernels) {
+    for (const char* const file : { "/stereo.ogg", "/mono.ogg" }) {
+        const std::vector<std::vector<uint8_t>> packets{ readPackets(testDataDir + file) };
+        const std::vector<float> expected{ decodeSpectra(packets, getScalarVorbisDspKernels()) };
+        const std::vector<float> actual{ decodeSpectra(packets, getVorbisDspKernels()) };
+
+        ASSERT_EQ(expected.size(), actual.size());
+        EXPECT_EQ(std::memcmp(expected.data(), actual.data(), expected.size() * sizeof(float)), 0);
+
+        double energy{ 0.0 };
+        for (const float value : actual) {
+            ASSERT_TRUE(std::isfinite(value));
+            energy += double(value) * value;
+        }
+        EXPECT_GT(energy, 0.0);
+    }
+}
+
+TEST(TestVorbis, truncated_packets_are_decoded) {
+    const std::vector<std::vector<uint8_t>> packets{ readPackets(testDataDir + "/stereo.ogg") };
+    for (const std::size_t maxPacketSize : { 1, 2, 5, 17, 40 }) {
+        for (const float value : decodeSpectra(packets, getVorbisDspKernels(), maxPacketSize)) {
+            ASSERT_TRUE(std::isfinite(value));
+        }
+    }
+}
@@ -0,0 +1,207 @@
+#include "VorbisDsp.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+
+using namespace vcpp;
+
+// Turns random integers into floats of both signs, including zeros.
+static std::vector<float> makeValues(const std::vector<int32_t>& raw) {
+    std::vector<float> values;
+    for (const int32_t value : raw) {
+        values.push_back(value % 5 == 0 ? 0.0f : float(value % 1000) / 7.0f);
+    }
+    return values;
+}
+
+static bool isBitIdentical(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0);
+}
+
+RC_GTEST_PROP(TestVorbisDsp, floor_is_applied_like_scalar_kernel,
+    (const std::vector<int32_t> residueRaw, const std::vector<uint8_t> floorRaw)) {
+    RC_PRE(floorRaw.size() > 0);
+    std::vector<float> expected{ makeValues(residueRaw) };
+    std::vector<uint8_t> floor;
+    for (std::size_t i{ 0 }; i < expected.size(); i++) {
+        floor.push_back(floorRaw[i % floorRaw.size()]);
+    }
+    std::vector<float> actual{ expected };
+
+    getScalarVorbisDspKernels().applyFloor(expected.data(), floor.data(), expected.size());
+    getVorbisDspKernels().applyFloor(actual.data(), floor.data(), actual.size());
+
+    RC_ASSERT(isBitIdentical(expected, actual));
+}
+
+RC_GTEST_PROP(TestVorbisDsp, decoupling_matches_specification,
+    (const std::vector<int32_t> magnitudeRaw, const std::vector<int32_t> angleRaw)) {
+    const std::size_t size{ std::min(magnitudeRaw.size(), angleRaw.size()) };
+    std::vector<float> magnitude{ makeValues(magnitudeRaw) };
+    std::vector<float> angle{ makeValues(angleRaw) };
+    magnitude.resize(size);
+    angle.resize(size);
+
+    // Straight from the Vorbis specification.
+    std::vector<float> expectedMagnitude(size);
+    std::vector<float> expectedAngle(size);
+    for (std::size_t i{ 0 }; i < size; i++) {
+        const float m{ magnitude[i] };
+        const float a{ angle[i] };
+        if (m > 0) {
+            if (a > 0) {
+                expectedMagnitude[i] = m;
+                expectedAngle[i] = m - a;
+            }
+            else {
+                expectedAngle[i] = m;
+                expectedMagnitude[i] = m + a;
+            }
+        }
+        else {
+            if (a > 0) {
+                expectedMagnitude[i] = m;
+                expectedAngle[i] = m + a;
+            }
+            else {
+                expectedAngle[i] = m;
+                expectedMagnitude[i] = m - a;
+            }
+        }
+    }
+
+    for (const VorbisDspKernels* kernels : { &getScalarVorbisDspKernels(), &getVorbisDspKernels() }) {
+        std::vector<float> actualMagnitude{ magnitude };
+        std::vector<float> actualAngle{ angle };
+        kernels->decouple(actualMagnitude.data(), actualAngle.data(), size);
+        RC_ASSERT(isBitIdentical(expectedMagnitude, actualMagnitude));
+        RC_ASSERT(isBitIdentical(expectedAngle, actualAngle));
+    }
+}
+
+RC_GTEST_PROP(TestVorbisDsp, values_are_deinterleaved,
+    (const std::vector<int32_t> valuesRaw, const uint8_t numChannelsRaw)) {
+    const std::size_t numChannels{ numChannelsRaw % 4u + 1 };
+    std::vector<float> values{ makeValues(valuesRaw) };
+    const std::size_t size{ values.size() / numChannels };
+
+    for (const VorbisDspKernels* kernels : { &getScalarVorbisDspKernels(), &getVorbisDspKernels() }) {
+        std::vector<std::vector<float>> channels(numChannels, std::vector<float>(size));
+        std::vector<float*> out;
+        for (std::vector<float>& channel : channels) {
+            out.push_back(channel.data());
+        }
+        kernels->deinterleave(values.data(), out.data(), numChannels, size);
+        for (std::size_t i{ 0 }; i < size; i++) {
+            for (std::size_t channel{ 0 }; channel < numChannels; channel++) {
+                RC_ASSERT(channels[channel][i] == values[i * numChannels + channel]);
+            }
+        }
+    }
+}
+
+// Samples of 16-bit output as defined for the kernels: scaled, clamped and rounded to even.
+static int16_t toInt16(const float sample) {
+    const float scaled{ std::min(std::max(sample * 32768.0f, -32768.0f), 32767.0f) };
+    return int16_t(std::nearbyint(scaled));
+}
+
+// Splits values into numChannels channels of size samples each, scaled so that
+// some samples are outside of [-1, 1].
+static std::vector<std::vector<float>> makeChannels(const std::vector<int32_t>& raw, const std::size_t numChannels, const std::size_t size) {
+    const std::vector<float> values{ makeValues(raw) };
+    std::vector<std::vector<float>> channels(numChannels, std::vector<float>(size));
+    for (std::size_t channel{ 0 }; channel < numChannels; channel++) {
+        for (std::size_t i{ 0 }; i < size; i++) {
+            channels[channel][i] = values[channel * size + i] / 100.0f;
+        }
+    }
+    return channels;
+}
+
+static std::vector<const float*> getPointers(const std::vector<std::vector<float>>& channels) {
+    std::vector<const float*> pointers;
+    for (const std::vector<float>& channel : channels) {
+        pointers.push_back(channel.data());
+    }
+    return pointers;
+}
+
+RC_GTEST_PROP(TestVorbisDsp, blocks_are_overlap_added,
+    (const std::vector<int32_t> valuesRaw, const std::vector<uint16_t> windowRaw, const uint8_t numChannelsRaw)) {
+    const std::size_t numChannels{ numChannelsRaw % 4u + 1 };
+    const std::size_t size{ std::min(valuesRaw.size() / (2 * numChannels), windowRaw.size()) };
+    std::vector<int32_t> previousRaw{ valuesRaw.begin(), valuesRaw.begin() + numChannels * size };
+    std::vector<int32_t> currentRaw{ valuesRaw.begin() + numChannels * size, valuesRaw.begin() + 2 * numChannels * size };
+    const std::vector<std::vector<float>> previous{ makeChannels(previousRaw, numChannels, size) };
+    const std::vector<std::vector<float>> current{ makeChannels(currentRaw, numChannels, size) };
+    std::vector<float> rising(size);
+    std::vector<float> falling(size);
+    for (std::size_t i{ 0 }; i < size; i++) {
+        rising[i] = float(windowRaw[i]) / 65535.0f;
+        falling[i] = 1.0f - rising[i];
+    }
+
+    for (const VorbisDspKernels* kernels : { &getScalarVorbisDspKernels(), &getVorbisDspKernels() }) {
+        std::vector<float> floatOut(numChannels * size);
+        std::vector<int16_t> int16Out(numChannels * size);
+        kernels->overlapAddFloat(getPointers(previous).data(), getPointers(current).data(), 
+            rising.data(), falling.data(), numChannels, size, floatOut.data());
+        kernels->overlapAddInt16(getPointers(previous).data(), getPointers(current).data(),
+            rising.data(), falling.data(), numChannels, size, int16Out.data());
+
+        for (std::size_t i{ 0 }; i < size; i++) {
+            for (std::size_t channel{ 0 }; channel < numChannels; channel++) {
+                // Some compilers fuse the multiplication and addition, so the
+                // results are only compared up to rounding.
+                const float expected{ previous[channel][i] * falling[i] + current[channel][i] * rising[i] };
+                RC_ASSERT(std::abs(floatOut[i * numChannels + channel] - expected) <= 1e-6f * (std::abs(expected) + 1.0f));
+                RC_ASSERT(std::abs(int16Out[i * numChannels + channel] - toInt16(expected)) <= 1);
+            }
+        }
+    }
+}
+
+RC_GTEST_PROP(TestVorbisDsp, samples_are_interleaved,
+    (const std::vector<int32_t> valuesRaw, const uint8_t numChannelsRaw)) {
+    const std::size_t numChannels{ numChannelsRaw % 4u + 1 };
+    const std::size_t size{ valuesRaw.size() / numChannels };
+    const std::vector<std::vector<float>> channels{ makeChannels(valuesRaw, numChannels, size) };
+
+    for (const VorbisDspKernels* kernels : { &getScalarVorbisDspKernels(), &getVorbisDspKernels() }) {
+        std::vector<float> floatOut(numChannels * size);
+        std::vector<int16_t> int16Out(numChannels * size);
+        kernels->interleaveFloat(getPointers(channels).data(), numChannels, size, floatOut.data());
+        kernels->interleaveInt16(getPointers(channels).data(), numChannels, size, int16Out.data());
+
+        for (std::size_t i{ 0 }; i < size; i++) {
+            for (std::size_t channel{ 0 }; channel < numChannels; channel++) {
+                RC_ASSERT(floatOut[i * numChannels + channel] == channels[channel][i]);
+                RC_ASSERT(int16Out[i * numChannels + channel] == toInt16(channels[channel][i]));
+            }
+        }
+    }
+}
+
+TEST(TestVorbisDsp, samples_are_clamped) {
+    const std::vector<float> samples{ -2.0f, -1.0f, -0.5f, 0.0f, 0.5f, 0.99999f, 1.0f, 2.0f, 1.0f / 65536.0f };
+    const std::vector<int16_t> expected{ -32768, -32768, -16384, 0, 16384, 32767, 32767, 32767, 0 };
+    const float* const in{ samples.data() };
+    for (const VorbisDspKernels* kernels : { &getScalarVorbisDspKernels(), &getVorbisDspKernels() }) {
+        std::vector<int16_t> out(samples.size());
+        kernels->interleaveInt16(&in, 1, samples.size(), out.data());
+        EXPECT_EQ(out, expected) << kernels->name;
+    }
+}
+
+TEST(TestVorbisDsp, inverse_db_table_matches_specification) {
+    EXPECT_FLOAT_EQ(vorbisInverseDb(0), 1.0649863e-07f);
+    EXPECT_FLOAT_EQ(vorbisInverseDb(128), 0.00033677815f);
+    EXPECT_EQ(vorbisInverseDb(255), 1.0f);
+    for (unsigned int i{ 1 }; i < 256; i++) {
+        EXPECT_GT(vorbisInverseDb(uint8_t(i)), vorbisInverseDb(uint8_t(i - 1)));
+    }
+}
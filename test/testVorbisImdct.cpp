@@ -0,0 +1,81 @@
+#include "VorbisImdct.h"
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace vcpp;
+
+// Inverse MDCT straight from the Vorbis specification, in O(n^2).
+static std::vector<double> directImdct(const std::vector<float>& in) {
+    const std::size_t size{ in.size() * 2 };
+    const double pi{ 3.14159265358979323846 };
+    std::vector<double> out(size);
+    for (std::size_t n{ 0 }; n < size; n++) {
+        double sum{ 0.0 };
+        for (std::size_t k{ 0 }; k < size / 2; k++) {
+            sum += in[k] * std::cos(2.0 * pi / double(size) * (double(n) + 0.5 + double(size) / 4.0) * (double(k) + 0.5));
+        }
+        out[n] = sum;
+    }
+    return out;
+}
+
+TEST(TestVorbisImdct, transform_matches_direct_imdct) {
+    std::mt19937 random{ 1 };
+    std::uniform_real_distribution<float> distribution{ -1.0f, 1.0f };
+
+    for (std::size_t size{ 64 }; size <= 8192; size *= 2) {
+        std::vector<float> in(size / 2);
+        for (float& value : in) {
+            value = distribution(random);
+        }
+        const std::vector<double> expected{ directImdct(in) };
+        double maxExpected{ 0.0 };
+        for (const double value : expected) {
+            maxExpected = std::max(maxExpected, std::abs(value));
+        }
+
+        for (const VorbisDspKernels* kernels : { &getScalarVorbisDspKernels(), &getVorbisDspKernels() }) {
+            const VorbisImdct imdct{ size, *kernels };
+            std::vector<float> out(size);
+            std::vector<float> scratch(size / 2);
+            imdct.transform(in.data(), out.data(), scratch.data());
+
+            double maxError{ 0.0 };
+            for (std::size_t i{ 0 }; i < size; i++) {
+                maxError = std::max(maxError, std::abs(out[i] - expected[i]));
+            }
+            EXPECT_LT(maxError, maxExpected * 1e-5) << "size " << size << ", " << kernels->name;
+        }
+    }
+}
+
+TEST(TestVorbisImdct, windows_are_power_complementary) {
+    for (std::size_t size{ 64 }; size <= 8192; size *= 2) {
+        const VorbisImdct imdct{ size };
+        const float* const window{ imdct.getWindow() };
+        for (std::size_t i{ 0 }; i < size / 2; i++) {
+            const float rising{ window[i] };
+            const float falling{ window[size / 2 - 1 - i] };
+            EXPECT_NEAR(rising * rising + falling * falling, 1.0f, 1e-6f);
+        }
+    }
+}
+
+TEST(TestVorbisImdct, plans_are_shared) {
+    const std::shared_ptr<const VorbisImdct> a{ VorbisImdct::get(256) };
+    const std::shared_ptr<const VorbisImdct> b{ VorbisImdct::get(256) };
+    const std::shared_ptr<const VorbisImdct> c{ VorbisImdct::get(2048) };
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(a->getSize(), 256u);
+    EXPECT_EQ(c->getSize(), 2048u);
+}
+
+TEST(TestVorbisImdct, invalid_sizes_are_rejected) {
+    EXPECT_THROW(VorbisImdct{ 32 }, std::invalid_argument);
+    EXPECT_THROW(VorbisImdct{ 300 }, std::invalid_argument);
+    EXPECT_THROW(VorbisImdct{ 16384 }, std::invalid_argument);
+}
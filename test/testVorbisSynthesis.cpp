@@ -0,0 +1,271 @@
+#include "VorbisStream.h"
+#include "VorbisSynthesis.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace vcpp;
+
+static const std::string testDataDir{ VCPP_TEST_DATA_DIR };
+
+enum class Format {
+    InterleavedFloat,
+    InterleavedInt16,
+    PlanarFloat
+};
+
+// Reads the pending frames of a stream in parts of at most chunkSize frames, like a
+// consumer that writes into a ring buffer.
+class PcmCollector : public VorbisStream::PcmCallback {
+    const Format format_;
+    const std::size_t chunkSize_;
+
+public:
+    std::size_t numChannels{ 0 };
+    std::vector<float> floatSamples;
+    std::vector<int16_t> int16Samples;
+
+    PcmCollector(const Format format, const std::size_t chunkSize)
+        : format_{ format }, chunkSize_{ chunkSize } {}
+
+    void onPcmAvailable(VorbisStream& stream, const std::size_t numFrames) override {
+        numChannels = stream.getIdentification().numChannels;
+        std::size_t numFramesRead{ 0 };
+        while (stream.getNumPendingFrames() > 0) {
+            const std::size_t count{ std::min(chunkSize_, stream.getNumPendingFrames()) };
+            if (format_ == Format::InterleavedInt16) {
+                const std::size_t offset{ int16Samples.size() };
+                int16Samples.resize(offset + count * numChannels);
+                numFramesRead += stream.readInterleaved(int16Samples.data() + offset, count);
+            }
+            else if (format_ == Format::InterleavedFloat) {
+                const std::size_t offset{ floatSamples.size() };
+                floatSamples.resize(offset + count * numChannels);
+                numFramesRead += stream.readInterleaved(floatSamples.data() + offset, count);
+            }
+            else {
+                std::vector<std::vector<float>> channels(numChannels, std::vector<float>(count));
+                std::vector<float*> out;
+                for (std::vector<float>& channel : channels) {
+                    out.push_back(channel.data());
+                }
+                numFramesRead += stream.readPlanar(out.data(), count);
+                for (std::size_t i{ 0 }; i < count; i++) {
+                    for (const std::vector<float>& channel : channels) {
+                        floatSamples.push_back(channel[i]);
+                    }
+                }
+            }
+        }
+        EXPECT_EQ(numFramesRead, numFrames);
+    }
+};
+
+class PcmNewStreamCallback : public OggPhysicalStreamIn::NewStreamCallback {
+    std::shared_ptr<PcmCollector> collector_;
+    const unsigned int numWorkers_;
+    const std::size_t queueDepth_;
+
+public:
+    PcmNewStreamCallback(std::shared_ptr<PcmCollector> collector, const unsigned int numWorkers, const std::size_t queueDepth)
+        : collector_{ collector }, numWorkers_{ numWorkers }, queueDepth_{ queueDepth } {}
+
+    void onNewStream(OggLogicalStreamIn& stream) {
+        const auto vorbisStream{ std::make_shared<VorbisStream>(numWorkers_, queueDepth_) };
+        vorbisStream->addPcmCallback(collector_);
+        stream.addPacketCallback(vorbisStream);
+    }
+};
+
+static std::shared_ptr<PcmCollector> decodeFile(
+    const std::string& path,
+    const Format format,
+    const std::size_t chunkSize = SIZE_MAX,
+    const unsigned int numWorkers = 0,
+    const std::size_t queueDepth = 32) {
+    const auto collector{ std::make_shared<PcmCollector>(format, chunkSize) };
+    OggPhysicalStreamIn in{ path };
+    in.addNewStreamCallback(std::make_shared<PcmNewStreamCallback>(collector, numWorkers, queueDepth));
+    in.process();
+    return collector;
+}
+
+// Interleaved samples decoded by libvorbis, stored as little-endian floats.
+static std::vector<float> readReference(const std::string& path) {
+    std::ifstream in{ path, std::ios::binary };
+    std::vector<float> samples;
+    uint8_t bytes[4];
+    while (in.read(reinterpret_cast<char*>(bytes), 4)) {
+        const uint32_t bits{ uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24 };
+        float sample;
+        std::memcpy(&sample, &bits, sizeof(sample));
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+TEST(TestVorbisSynthesis, samples_match_libvorbis) {
+    for (const std::string name : { "stereo", "mono" }) {
+        const std::vector<float> expected{ readReference(testDataDir + "/" + name + ".f32") };
+        const std::shared_ptr<PcmCollector> collector{ decodeFile(testDataDir + "/" + name + ".ogg", Format::InterleavedFloat) };
+        const std::vector<float>& actual{ collector->floatSamples };
+
+        // The last page ends the stream in the middle of the last block.
+        ASSERT_EQ(actual.size(), expected.size()) << name;
+        float maxError{ 0.0f };
+        for (std::size_t i{ 0 }; i < actual.size(); i++) {
+            maxError = std::max(maxError, std::abs(actual[i] - expected[i]));
+        }
+        EXPECT_LT(maxError, 1e-5f) << name;
+    }
+}
+
+TEST(TestVorbisSynthesis, output_formats_agree) {
+    for (const std::string name : { "stereo", "mono" }) {
+        const std::string path{ testDataDir + "/" + name + ".ogg" };
+        const std::vector<float> interleaved{ decodeFile(path, Format::InterleavedFloat)->floatSamples };
+        const std::vector<float> planar{ decodeFile(path, Format::PlanarFloat)->floatSamples };
+        const std::vector<int16_t> int16{ decodeFile(path, Format::InterleavedInt16)->int16Samples };
+
+        EXPECT_EQ(planar, interleaved) << name;
+        ASSERT_EQ(int16.size(), interleaved.size()) << name;
+        for (std::size_t i{ 0 }; i < int16.size(); i++) {
+            EXPECT_NEAR(int16[i], interleaved[i] * 32768.0f, 0.5f + 1e-3f) << name << " " << i;
+        }
+    }
+}
+
+TEST(TestVorbisSynthesis, frames_can_be_read_in_parts) {
+    for (const std::string name : { "stereo", "mono" }) {
+        const std::string path{ testDataDir + "/" + name + ".ogg" };
+        for (const Format format : { Format::InterleavedFloat, Format::PlanarFloat }) {
+            const std::vector<float> whole{ decodeFile(path, format)->floatSamples };
+            for (const std::size_t chunkSize : { 1, 7, 37, 100 }) {
+                EXPECT_EQ(decodeFile(path, format, chunkSize)->floatSamples, whole) << name << " " << chunkSize;
+            }
+        }
+        const std::vector<int16_t> whole{ decodeFile(path, Format::InterleavedInt16)->int16Samples };
+        EXPECT_EQ(decodeFile(path, Format::InterleavedInt16, 37)->int16Samples, whole) << name;
+    }
+}
+
+TEST(TestVorbisSynthesis, workers_produce_identical_output) {
+    for (const std::string name : { "stereo", "mono" }) {
+        const std::string path{ testDataDir + "/" + name + ".ogg" };
+        const std::vector<float> expectedFloat{ decodeFile(path, Format::InterleavedFloat)->floatSamples };
+        const std::vector<int16_t> expectedInt16{ decodeFile(path, Format::InterleavedInt16)->int16Samples };
+        for (const unsigned int numWorkers : { 1, 2, 4 }) {
+            for (const std::size_t queueDepth : { 1, 3, 32 }) {
+                EXPECT_EQ(decodeFile(path, Format::InterleavedFloat, SIZE_MAX, numWorkers, queueDepth)->floatSamples, expectedFloat)
+                    << name << " " << numWorkers << " " << queueDepth;
+                EXPECT_EQ(decodeFile(path, Format::InterleavedInt16, 37, numWorkers, queueDepth)->int16Samples, expectedInt16)
+                    << name << " " << numWorkers << " " << queueDepth;
+            }
+        }
+    }
+}
+
+TEST(TestVorbisSynthesis, queued_packets_are_delivered_by_flush) {
+    std::vector<std::vector<uint8_t>> packets;
+    OggPhysicalStreamIn in{ testDataDir + "/mono.ogg" };
+    while (const std::optional<OggPacket> packet{ in.nextPacket() }) {
+        packets.emplace_back(packet->data, packet->data + packet->size);
+    }
+
+    const auto collector{ std::make_shared<PcmCollector>(Format::InterleavedFloat, SIZE_MAX) };
+    VorbisStream stream{ 2, 4 };
+    stream.addPcmCallback(collector);
+    for (const std::vector<uint8_t>& packet : packets) {
+        stream.processPacket(packet.data(), packet.size());
+    }
+    stream.flush();
+
+    // Without the granule position, the last block is not truncated.
+    const std::vector<float> expected{ decodeFile(testDataDir + "/mono.ogg", Format::InterleavedFloat)->floatSamples };
+    ASSERT_GT(collector->floatSamples.size(), expected.size());
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), collector->floatSamples.begin()));
+}
+
+// Throws from one of its calls, like a consumer whose output failed once.
+class FailingPcmCallback : public VorbisStream::PcmCallback {
+    std::size_t numCalls_{ 0 };
+
+public:
+    void onPcmAvailable(VorbisStream& stream, const std::size_t numFrames) override {
+        (void)stream;
+        (void)numFrames;
+        if (++numCalls_ == 5) {
+            throw std::runtime_error{ "Output failed." };
+        }
+    }
+};
+
+TEST(TestVorbisSynthesis, workers_continue_after_damaged_packets) {
+    std::vector<std::vector<uint8_t>> packets;
+    OggPhysicalStreamIn in{ testDataDir + "/stereo.ogg" };
+    while (const std::optional<OggPacket> packet{ in.nextPacket() }) {
+        packets.emplace_back(packet->data, packet->data + packet->size);
+    }
+    // Keep the packet header, but replace the rest with garbage.
+    for (std::size_t i{ 1 }; i < packets[10].size(); i++) {
+        packets[10][i] = uint8_t(i * 37);
+    }
+    packets[12].resize(2);
+
+    const auto expected{ std::make_shared<PcmCollector>(Format::InterleavedFloat, SIZE_MAX) };
+    VorbisStream singleThreaded{};
+    singleThreaded.addPcmCallback(expected);
+    for (const std::vector<uint8_t>& packet : packets) {
+        singleThreaded.processPacket(packet.data(), packet.size());
+    }
+
+    const auto actual{ std::make_shared<PcmCollector>(Format::InterleavedFloat, SIZE_MAX) };
+    VorbisStream stream{ 2, 2 };
+    stream.addPcmCallback(actual);
+    stream.addPcmCallback(std::make_shared<FailingPcmCallback>());
+    std::size_t numErrors{ 0 };
+    for (const std::vector<uint8_t>& packet : packets) {
+        try {
+            stream.processPacket(packet.data(), packet.size());
+        }
+        catch (const std::runtime_error&) {
+            numErrors++;
+        }
+    }
+    EXPECT_NO_THROW(stream.flush());
+
+    // The failed delivery is not repeated, and all other packets are still decoded.
+    EXPECT_EQ(numErrors, 1u);
+    EXPECT_EQ(actual->floatSamples, expected->floatSamples);
+}
+
+TEST(TestVorbisSynthesis, first_block_produces_no_frames) {
+    VorbisIdentification identification{};
+    identification.numChannels = 1;
+    identification.sampleRate = 8000;
+    identification.blockSizes = { 64, 256 };
+    VorbisSynthesis synthesis{ identification };
+
+    std::vector<float> block(256, 1.0f);
+    synthesis.addBlock(block, 256);
+    EXPECT_EQ(synthesis.getNumPendingFrames(), 0u);
+
+    // Long to short: a quarter of each block.
+    block.assign(64, 1.0f);
+    synthesis.addBlock(block, 64);
+    EXPECT_EQ(synthesis.getNumPendingFrames(), 64u + 16u);
+    EXPECT_EQ(synthesis.getStreamPosition(), 80u);
+
+    synthesis.truncate(50);
+    EXPECT_EQ(synthesis.getNumPendingFrames(), 50u);
+    std::vector<float> out(100);
+    EXPECT_EQ(synthesis.readInterleaved(out.data(), 100), 50u);
+    EXPECT_EQ(synthesis.getNumPendingFrames(), 0u);
+}